@@ -4,7 +4,341 @@
 #include "Dispatcher/JsonMessageDispatcher.h"
 
 #include "Async/JsonPromise.h"
+#include "CoreGlobals.h"
+#include "Async/Async.h"
+#include "Messaging/TokenBucket.h"
+#include "WebApiServerStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Compact Json Parse"), STAT_WebApiServer_CompactJsonParse, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Compact Json Nodes"), STAT_WebApiServer_CompactJsonNodes, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Compact Json Arena Growths"), STAT_WebApiServer_CompactJsonArenaGrowths, STATGROUP_WebApiServer);
+DECLARE_MEMORY_STAT(TEXT("Compact Json Arena Size"), STAT_WebApiServer_CompactJsonArenaSize, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Response Cache Hits"), STAT_WebApiServer_ResponseCacheHits, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Response Cache Misses"), STAT_WebApiServer_ResponseCacheMisses, STATGROUP_WebApiServer);
+DECLARE_MEMORY_STAT(TEXT("Response Cache Size"), STAT_WebApiServer_ResponseCacheSize, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Coalesced Requests"), STAT_WebApiServer_CoalescedRequests, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Snapshot Builds"), STAT_WebApiServer_SnapshotBuilds, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Snapshot Reuses"), STAT_WebApiServer_SnapshotReuses, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Conflated Notifications Replaced"), STAT_WebApiServer_ConflatedReplaced, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Conflated Notifications Sent"), STAT_WebApiServer_ConflatedSent, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rate Limited Messages"), STAT_WebApiServer_RateLimitedMessages, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rate Limited Requests"), STAT_WebApiServer_RateLimitedRequests, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pending Limit Rejections"), STAT_WebApiServer_PendingLimitRejections, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bulkhead Rejections"), STAT_WebApiServer_BulkheadRejections, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bulkhead Queue Timeouts"), STAT_WebApiServer_BulkheadQueueTimeouts, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sharded Messages"), STAT_WebApiServer_ShardedMessages, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shard Messages Handed To Game Thread"), STAT_WebApiServer_ShardGameThreadMessages, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shard Registry Rebuilds"), STAT_WebApiServer_ShardRegistryRebuilds, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shard Queue Rejections"), STAT_WebApiServer_ShardQueueRejections, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Stream Chunks Sent"), STAT_WebApiServer_StreamChunksSent, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Stream Chunks Received"), STAT_WebApiServer_StreamChunksReceived, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Stream Send Window Stalls"), STAT_WebApiServer_StreamStalls, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Streams Dropped"), STAT_WebApiServer_StreamsDropped, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Slow Handler Calls"), STAT_WebApiServer_SlowHandlerCalls, STATGROUP_WebApiServer);
+
+/** Answer to a message dropped before parsing, when its id isn't known */
+static const TCHAR* RateLimitedMessage = TEXT("{\"" JSONRPC_ID "\":null,\"" JSONRPC_ERROR "\":\"rate_limited\"}");
+static const TCHAR* ServerBusyMessage = TEXT("{\"" JSONRPC_ID "\":null,\"" JSONRPC_ERROR "\":\"server_busy\"}");
+
+/** Execution of a request shared by every identical request received while it runs */
+struct FJsonRpcInFlightRequest
+{
+    struct FWaiter
+    {
+        int32 Id;
+        TScriptInterface<IMessageSender> MessageSender;
+    };
+
+    TArray<FWaiter> Waiters;
+    double StartTime = 0.0;
+};
+
+/** Rate limits and pending requests of one sender */
+struct FJsonRpcClientAdmission
+{
+    TWeakObjectPtr<UObject> Sender;
+    FTokenBucket MessageBucket;
+    TMap<FString, FTokenBucket> MethodBuckets;
+
+    struct FPendingRequest
+    {
+        /** Set on the first completion, or when the request expires */
+        TSharedRef<bool> bReleased;
+        double StartTime;
+    };
+
+    /** Requests waiting on a handler, counted by MaxPendingRequestsPerClient */
+    TArray<FPendingRequest> PendingRequests;
+};
+
+/** Concurrency limit of one method */
+struct FJsonRpcBulkhead
+{
+    struct FQueuedRequest
+    {
+        TFunction<void ()> Run;
+        FJsonRpcRequestErrorCallback Reject;
+        double EnqueueTime = 0.0;
+        /** Length of the message of the request, for the slow call records */
+        int32 MessageSize = 0;
+    };
+
+    int32 InFlight = 0;
+    /** Oldest first */
+    TArray<FQueuedRequest> Queue;
+    bool bDraining = false;
+};
+
+/** Notifications held for one sender until the next flush, in the order their keys were first used */
+struct FJsonRpcConflationQueue
+{
+    struct FNotification
+    {
+        FString Method;
+        TSharedPtr<FJsonValue> Params;
+    };
+
+    TWeakObjectPtr<UObject> Sender;
+    TArray<FNotification> Notifications;
+    /** Position in Notifications by method and key */
+    TMap<TPair<FString, FString>, int32> Positions;
+};
+
+/** Handlers a shard may run itself. Methods missing from it are handed to the game thread. */
+struct FJsonRpcShardRegistry
+{
+    TMap<FString, TSharedPtr<FJsonRpcRequestHandler>> RequestHandlers;
+    TMap<FString, TArray<TSharedPtr<FJsonRpcNotificationHandler>>> NotificationHandlers;
+    TArray<FJsonRpcNotificationInterceptorLambda> NotificationInterceptors;
+};
+
+/** Sender whose messages go to a shard, shared by the game thread and the shard */
+struct FJsonRpcShardSender
+{
+    /** Only copied on the shard, resolved by the game thread */
+    TWeakObjectPtr<UObject> Object;
+    /** Messages handed back to the game thread and not done yet. The following messages of the sender go there too while it's not 0. */
+    std::atomic<int32> DeferredCount { 0 };
+};
+
+/** Held while a message handed back by a shard runs, and by requests until their handler completes */
+struct FJsonRpcDeferredMessage
+{
+    explicit FJsonRpcDeferredMessage(const TSharedPtr<FJsonRpcShardSender>& InSender)
+        : Sender(InSender)
+    {
+    }
+
+    ~FJsonRpcDeferredMessage()
+    {
+        Release();
+    }
+
+    void Release()
+    {
+        if (Sender.IsValid() && !bReleased.exchange(true))
+            Sender->DeferredCount.fetch_sub(1, std::memory_order_release);
+    }
+
+    TSharedPtr<FJsonRpcShardSender> Sender;
+    std::atomic<bool> bReleased { false };
+};
+
+/** Streamed response being produced, see RegisterStreamingRequestHandler */
+struct FJsonRpcResponseStream
+{
+    int32 Id = 0;
+    TWeakObjectPtr<UObject> MessageSender;
+    FJsonRpcChunkProducer Producer;
+    /** False for senders that can't stream, the chunks are then collected and sent as one result */
+    bool bChunked = true;
+    TArray<TSharedPtr<FJsonValue>> Chunks;
+    /** Set once the requester grants credits, chunks are then only sent while SentChunks < GrantedChunks */
+    bool bCredited = false;
+    int64 GrantedChunks = 0;
+    int64 SentChunks = 0;
+};
+
+/**
+ * Params of an incoming message, either as a json value or as a view into a compact document.
+ * The other form is only built if a handler asks for it.
+ */
+struct FJsonRpcIncomingParams
+{
+    explicit FJsonRpcIncomingParams(const TSharedPtr<FJsonValue>& InValue) : Value(InValue), bHasValue(true) {}
+    explicit FJsonRpcIncomingParams(const FJsonArenaView& InView) : View(InView), bHasView(true) {}
+
+    const TSharedPtr<FJsonValue>& GetValue() const
+    {
+        if (!bHasValue)
+        {
+            Value = View.ToJsonValue();
+            bHasValue = true;
+        }
+        return Value;
+    }
+
+    const FJsonArenaView& GetView() const
+    {
+        if (!bHasView)
+        {
+            if (Value.IsValid())
+            {
+                OwnedDocument = MakeUnique<FJsonArenaDocument>();
+                OwnedDocument->Build(Value);
+                View = OwnedDocument->GetRoot();
+            }
+            bHasView = true;
+        }
+        return View;
+    }
+
+private:
+    mutable TSharedPtr<FJsonValue> Value;
+    mutable FJsonArenaView View;
+    mutable TUniquePtr<FJsonArenaDocument> OwnedDocument;
+    mutable bool bHasValue = false;
+    mutable bool bHasView = false;
+};
+
+UJsonMessageDispatcher::~UJsonMessageDispatcher()
+{
+    StopShards();
+
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+}
+
+void UJsonMessageDispatcher::StartTicking()
+{
+    if (bTickingRequested.exchange(true))
+        return;
+
+    if (IsInGameThread())
+    {
+        if (!TickHandle.IsValid())
+            TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick));
+        return;
+    }
+
+    TWeakObjectPtr<UJsonMessageDispatcher> WeakThis = this;
+    AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+    {
+        UJsonMessageDispatcher* Dispatcher = WeakThis.Get();
+        if (Dispatcher && !Dispatcher->TickHandle.IsValid())
+            Dispatcher->TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(Dispatcher, &ThisClass::Tick));
+    });
+}
 
+bool UJsonMessageDispatcher::HasPendingWork() const
+{
+    if (!InboundQueue.IsEmpty() || !OutboundQueue->IsEmpty() || !ConflationQueues.IsEmpty() || !ResponseStreams.IsEmpty() || !Shards.IsEmpty())
+        return true;
+
+    for (const auto& [Method, Bulkhead] : Bulkheads)
+    {
+        if (!Bulkhead->Queue.IsEmpty())
+            return true;
+    }
+    return false;
+}
+
+bool UJsonMessageDispatcher::Tick(float DeltaTime)
+{
+    FlushInboundQueue();
+    FlushOutboundQueue();
+
+    const double Now = FPlatformTime::Seconds();
+    if (!ConflationQueues.IsEmpty() && Now - LastConflationFlushTime >= ConflationFlushInterval)
+        FlushConflatedNotifications();
+
+    if (!Bulkheads.IsEmpty())
+        ExpireBulkheadQueues();
+
+    if (!ResponseStreams.IsEmpty())
+        PumpResponseStreams();
+
+    if (HasPendingWork())
+        return true;
+
+    // Idle, the next StartTicking adds the ticker back. Work queued from another thread
+    // between the check and the reset is caught by the second check or by its own StartTicking.
+    bTickingRequested = false;
+    if (HasPendingWork() && !bTickingRequested.exchange(true))
+        return true;
+
+    TickHandle.Reset();
+    return false;
+}
+
+FJsonRpcClientAdmission* UJsonMessageDispatcher::FindOrAddClientAdmission(const TScriptInterface<IMessageSender>& MessageSender)
+{
+    const IMessageSender* Sender = MessageSender.GetInterface();
+    UObject* Owner = Sender != nullptr ? Sender->GetAdmissionOwner() : nullptr;
+    UObject* Object = Owner != nullptr ? Owner : MessageSender.GetObject();
+    if (!IsValid(Object))
+        return nullptr;
+
+    TSharedPtr<FJsonRpcClientAdmission>& Admission = ClientAdmissions.FindOrAdd(Object);
+    if (!Admission.IsValid())
+    {
+        Admission = MakeShared<FJsonRpcClientAdmission>();
+        Admission->Sender = Object;
+        // Owners have no closed event, their entry goes once they are collected
+        if (Owner == nullptr)
+            ObserveSender(MessageSender);
+    }
+    return Admission.Get();
+}
+
+bool UJsonMessageDispatcher::AdmitMessages(const TScriptInterface<IMessageSender>& MessageSender, int32 Count)
+{
+    if (MessagesPerSecondPerClient <= 0.0f)
+        return true;
+
+    FJsonRpcClientAdmission* Admission = FindOrAddClientAdmission(MessageSender);
+    if (Admission == nullptr || Admission->MessageBucket.TryConsume(FPlatformTime::Seconds(), MessagesPerSecondPerClient, MessageBurstPerClient, Count))
+        return true;
+
+    INC_DWORD_STAT(STAT_WebApiServer_RateLimitedMessages);
+    ++AdmissionStats.RejectedMessages;
+    return false;
+}
+
+void UJsonMessageDispatcher::ObserveSender(const TScriptInterface<IMessageSender>& MessageSender)
+{
+    UObject* Object = MessageSender.GetObject();
+    IMessageSender* Sender = MessageSender.GetInterface();
+    if (!IsValid(Object) || Sender == nullptr || ObservedSenders.Contains(Object))
+        return;
+
+    FSimpleMulticastDelegate* ClosedDelegate = Sender->GetClosedDelegate();
+    if (ClosedDelegate == nullptr)
+        return;
+
+    ClosedDelegate->AddUObject(this, &ThisClass::HandleSenderClosed, TObjectKey<UObject>(Object));
+    ObservedSenders.Add(Object);
+}
+
+void UJsonMessageDispatcher::HandleSenderClosed(TObjectKey<UObject> Sender)
+{
+    ClientAdmissions.Remove(Sender);
+    ShardSenders.Remove(Sender);
+
+    // Nobody is left to read them
+    const int32 DroppedStreams = ResponseStreams.RemoveAll([Sender](const TSharedPtr<FJsonRpcResponseStream>& Stream)
+    {
+        return TObjectKey<UObject>(Stream->MessageSender.GetEvenIfUnreachable()) == Sender;
+    });
+    INC_DWORD_STAT_BY(STAT_WebApiServer_StreamsDropped, DroppedStreams);
+
+    // Requests sent to it won't be answered any more, don't leave them to their timeout
+    if (UObject* Object = Sender.ResolveObjectPtr())
+        FailPendingRequests(TScriptInterface<IMessageSender>(Object));
+}
 
 bool UJsonMessageDispatcher::HaveValidRequestHandler(const FString& Method) const
 {
@@ -17,7 +351,7 @@ bool UJsonMessageDispatcher::HaveValidRequestHandler(const FString& Method) cons
 
 bool UJsonMessageDispatcher::RegisterRequestHandler(const FString& Method, const FJsonRpcRequestHandlerDelegate& Handler, UObject* Owner, bool bOverride)
 {
-    return RegisterRequestHandler(Method, [Handler](const TSharedPtr<FJsonValue>& Params)
+    const bool bRegistered = RegisterRequestHandler(Method, [Handler](const TSharedPtr<FJsonValue>& Params)
     {
         FJsonObjectWrapper Result;
         EJsonObjectWrapperType ResultType = EJsonObjectWrapperType::JOWT_Object;
@@ -26,6 +360,11 @@ bool UJsonMessageDispatcher::RegisterRequestHandler(const FString& Method, const
         Handler.ExecuteIfBound(ToJsonWrapper(Params), Result, ResultType, Error, bSuccess);
         return FromJsonWrapper(Result, ResultType);
     }, Owner, bOverride);
+
+    // Blueprint code only runs on the game thread
+    if (bRegistered)
+        RequestHandlers.FindChecked(Method)->bGameThreadBound = true;
+    return bRegistered;
 }
 
 bool UJsonMessageDispatcher::RegisterRequestHandler(const FString& Method, const FJsonRpcRequestHandlerLambda& Handler, UObject* Owner, bool bOverride)
@@ -54,7 +393,37 @@ bool UJsonMessageDispatcher::RegisterRequestHandler(const FString& Method, const
         }
     };
 
-    RequestHandlers.Add(Method, NewHandler);
+    AddRequestHandler(Method, NewHandler);
+    return true;
+}
+
+bool UJsonMessageDispatcher::RegisterCompactRequestHandler(const FString& Method, const FJsonRpcRequestHandlerCompactLambda& Handler, UObject* Owner, bool bOverride)
+{
+    if (!bOverride && HaveValidRequestHandler(Method))
+        return false;
+
+    auto NewHandler = MakeShared<FJsonRpcRequestHandler>();
+    NewHandler->Owner = Owner;
+    NewHandler->CompactAction = [Handler](const FJsonArenaView& Params,
+        const FJsonRpcRequestCompletionCallback& CompletionCallback,
+        const FJsonRpcRequestErrorCallback& FailureCallback)
+    {
+        try
+        {
+            TSharedPtr<FJsonValue> Result = Handler(Params);
+            CompletionCallback(Result);
+        }
+        catch (FString& e)
+        {
+            FailureCallback(e);
+        }
+        catch (std::exception& e)
+        {
+            FailureCallback(e.what());
+        }
+    };
+
+    AddRequestHandler(Method, NewHandler);
     return true;
 }
 
@@ -81,7 +450,7 @@ FString ToString(EJson Type)
     }
 }
 
-bool ValidateParamsArray(const TArray<TSharedPtr<FJsonValue>> &Parameters, const TArray<EJson>& ExpectedTypes, FString *ErrorMessage)
+bool ValidateParamsArray(TConstArrayView<TSharedPtr<FJsonValue>> Parameters, const TArray<EJson>& ExpectedTypes, FString *ErrorMessage)
 {
     int32 ExpectedCount = ExpectedTypes.Num();
 
@@ -105,14 +474,14 @@ bool ValidateParamsArray(const TArray<TSharedPtr<FJsonValue>> &Parameters, const
     return true;
 }
 
-bool ValidateParamsObject(const TSharedPtr<FJsonObject>& Parameter, const TMap<FString, EJson>& ExpectedTypes, FString *ErrorMessage)
+bool ValidateParamsObject(const FJsonObject& Parameter, const TMap<FString, EJson>& ExpectedTypes, FString *ErrorMessage)
 {
     TArray<FString> MissingProperties;
     TArray<FString> WrongProperties;
 
     for (const auto& [Name, Type] : ExpectedTypes)
     {
-        TSharedPtr<FJsonValue>* ParameterValuePtr = Parameter->Values.Find(Name);
+        const TSharedPtr<FJsonValue>* ParameterValuePtr = Parameter.Values.Find(Name);
         if (ParameterValuePtr == nullptr)
         {
             if (ErrorMessage == nullptr)
@@ -158,16 +527,46 @@ bool ValidateParamsObject(const TSharedPtr<FJsonObject>& Parameter, const TMap<F
     return MissingProperties.IsEmpty() && WrongProperties.IsEmpty();
 }
 
+/** Params of a request or notification as an array, without copying it. Missing params are an empty array. */
+bool GetParamsArray(const TSharedPtr<FJsonValue>& Params, TConstArrayView<TSharedPtr<FJsonValue>>& OutParameters)
+{
+    if (!Params)
+    {
+        OutParameters = TConstArrayView<TSharedPtr<FJsonValue>>();
+        return true;
+    }
+    if (Params->Type != EJson::Array)
+        return false;
+
+    OutParameters = Params->AsArray();
+    return true;
+}
+
+/** Params of a request or notification as an object, without copying it. Missing params are an empty object. */
+const FJsonObject* GetParamsObject(const TSharedPtr<FJsonValue>& Params)
+{
+    static const FJsonObject EmptyObject;
+
+    if (!Params)
+        return &EmptyObject;
+    if (Params->Type != EJson::Object || !Params->AsObject().IsValid())
+        return nullptr;
+
+    return Params->AsObject().Get();
+}
+
 bool UJsonMessageDispatcher::RegisterRequestHandler(const FString& Method, const TArray<EJson>& ExpectedTypes, const FJsonRpcRequestHandlerStructuredArrayLambda& Handler, UObject* Owner, bool bOverride)
 {
     return RegisterRequestHandler(
         Method,
         [Handler, ExpectedTypes](const TSharedPtr<FJsonValue>& Params)
         {
+            static const TArray<TSharedPtr<FJsonValue>> NoParameters;
+
             if (Params && Params->Type != EJson::Array)
                 throw FString(TEXT("Invalid parameters (not an array)"));
 
-            TArray<TSharedPtr<FJsonValue>> Parameters = Params ? Params->AsArray() : TArray<TSharedPtr<FJsonValue>>();
+            const TArray<TSharedPtr<FJsonValue>>& Parameters = Params ? Params->AsArray() : NoParameters;
             FString ErrorMessage;
             if (!ValidateParamsArray(Parameters, ExpectedTypes, &ErrorMessage))
                 throw ErrorMessage;
@@ -190,7 +589,7 @@ bool UJsonMessageDispatcher::RegisterRequestHandler(const FString& Method, const
 
             TSharedPtr<FJsonObject> Parameter = Params ? Params->AsObject() : MakeShared<FJsonObject>();
             FString ErrorMessage;
-            if (!ValidateParamsObject(Parameter, ExpectedTypes, &ErrorMessage))
+            if (!ValidateParamsObject(*Parameter, ExpectedTypes, &ErrorMessage))
                 throw ErrorMessage;
 
             return Handler(Parameter);
@@ -200,6 +599,62 @@ bool UJsonMessageDispatcher::RegisterRequestHandler(const FString& Method, const
     );
 }
 
+bool UJsonMessageDispatcher::RegisterRequestViewHandler(const FString& Method, const TArray<EJson>& ExpectedTypes, const FJsonRpcRequestHandlerArrayViewLambda& Handler, UObject* Owner, bool bOverride)
+{
+    return RegisterRequestHandler(
+        Method,
+        [Handler, ExpectedTypes](const TSharedPtr<FJsonValue>& Params)
+        {
+            TConstArrayView<TSharedPtr<FJsonValue>> Parameters;
+            if (!GetParamsArray(Params, Parameters))
+                throw FString(TEXT("Invalid parameters (not an array)"));
+
+            FString ErrorMessage;
+            if (!ValidateParamsArray(Parameters, ExpectedTypes, &ErrorMessage))
+                throw ErrorMessage;
+
+            return Handler(Parameters);
+        },
+        Owner,
+        bOverride
+    );
+}
+
+bool UJsonMessageDispatcher::RegisterRequestViewHandler(const FString& Method, const TMap<FString, EJson>& ExpectedTypes, const FJsonRpcRequestHandlerObjectViewLambda& Handler, UObject* Owner, bool bOverride)
+{
+    return RegisterRequestHandler(
+        Method,
+        [Handler, ExpectedTypes](const TSharedPtr<FJsonValue>& Params)
+        {
+            const FJsonObject* Parameter = GetParamsObject(Params);
+            if (Parameter == nullptr)
+                throw FString(TEXT("Invalid parameters (not an object)"));
+
+            FString ErrorMessage;
+            if (!ValidateParamsObject(*Parameter, ExpectedTypes, &ErrorMessage))
+                throw ErrorMessage;
+
+            return Handler(*Parameter);
+        },
+        Owner,
+        bOverride
+    );
+}
+
+bool UJsonMessageDispatcher::RegisterStreamingRequestHandler(const FString& Method, const FJsonRpcStreamingRequestHandlerLambda& Handler, UObject* Owner, bool bOverride)
+{
+    if (!bOverride && HaveValidRequestHandler(Method))
+        return false;
+
+    auto NewHandler = MakeShared<FJsonRpcRequestHandler>();
+    NewHandler->Owner = Owner;
+    NewHandler->StreamAction = Handler;
+    // Streams are paced by the game thread tick
+    NewHandler->bGameThreadBound = true;
+
+    AddRequestHandler(Method, NewHandler);
+    return true;
+}
 
 bool UJsonMessageDispatcher::RegisterRequestAsyncHandler(const FString& Method, const FJsonRpcRequestHandlerAsyncDelegate& Handler, UObject* Owner, bool bOverride)
 {
@@ -219,12 +674,35 @@ bool UJsonMessageDispatcher::RegisterRequestAsyncHandler(const FString& Method,
         Promise->GetOnReject().AddLambda(FailureCallback);
         Handler.ExecuteIfBound(ToJsonWrapper(Params), Promise);
     };
+    NewHandler->bGameThreadBound = true;
 
-    RequestHandlers.Add(Method, NewHandler);
+    AddRequestHandler(Method, NewHandler);
     return false;
 }
 
 
+void UJsonMessageDispatcher::AddRequestHandler(const FString& Method, const TSharedPtr<FJsonRpcRequestHandler>& Handler)
+{
+    // Results of the handler being replaced must not answer requests for the new one
+    if (RequestHandlers.Contains(Method))
+        InvalidateMethodResults(Method);
+
+    RequestHandlers.Add(Method, Handler);
+    bShardRegistryDirty = true;
+}
+
+void UJsonMessageDispatcher::InvalidateMethodResults(const FString& Method)
+{
+    InvalidateCachedResponses(Method);
+
+    // Requests still running keep answering their waiters, later requests no longer join them
+    for (auto It = InFlightRequests.CreateIterator(); It; ++It)
+    {
+        if (It.Key().Method.Equals(Method, ESearchCase::CaseSensitive))
+            It.RemoveCurrent();
+    }
+}
+
 bool UJsonMessageDispatcher::IsRequestHandlerRegistered(const FString& Method, UObject* Owner) const
 {
     auto CurrentHandlerPtr = RequestHandlers.Find(Method);
@@ -242,6 +720,8 @@ bool UJsonMessageDispatcher::UnregisterRequestHandler(const FString& Method, UOb
     if (IsRequestHandlerRegistered(Method, Owner))
     {
         RequestHandlers.Remove(Method);
+        InvalidateMethodResults(Method);
+        bShardRegistryDirty = true;
         return true;
     }
     return false;
@@ -258,6 +738,8 @@ void UJsonMessageDispatcher::UnregisterRequestHandlersFromOwner(UObject* Owner)
     for (const auto& Key : KeysToRemove)
     {
         RequestHandlers.Remove(Key);
+        InvalidateMethodResults(Key);
+        bShardRegistryDirty = true;
     }
 }
 
@@ -269,6 +751,9 @@ void UJsonMessageDispatcher::RegisterNotificationHandler(const FString& Method,
         {
             Handler.ExecuteIfBound(ToJsonWrapper(Params));
         }, Owner);
+
+    // Blueprint code only runs on the game thread
+    NotificationHandlers.FindChecked(Method).Last()->bGameThreadBound = true;
 }
 
 void UJsonMessageDispatcher::RegisterNotificationHandler(const FString& Method, const FJsonRpcNotificationHandlerLambda& Handler, UObject* Owner)
@@ -281,6 +766,7 @@ void UJsonMessageDispatcher::RegisterNotificationHandler(const FString& Method,
         MethodHandlers->Add(NewHandler);
     else
         NotificationHandlers.Add(Method, {NewHandler});
+    bShardRegistryDirty = true;
 }
 
 void UJsonMessageDispatcher::RegisterNotificationHandler(const FString& Method, const TArray<EJson>& ExpectedTypes, const FJsonRpcNotificationHandlerStructuredArrayLambda& Handler, UObject* Owner)
@@ -289,10 +775,12 @@ void UJsonMessageDispatcher::RegisterNotificationHandler(const FString& Method,
         Method,
         [Handler, ExpectedTypes](const TSharedPtr<FJsonValue>& Params)
         {
+            static const TArray<TSharedPtr<FJsonValue>> NoParameters;
+
             if (Params && Params->Type != EJson::Array)
                 return;
 
-            TArray<TSharedPtr<FJsonValue>> Parameters = Params ? Params->AsArray() : TArray<TSharedPtr<FJsonValue>>();
+            const TArray<TSharedPtr<FJsonValue>>& Parameters = Params ? Params->AsArray() : NoParameters;
             if (!ValidateParamsArray(Parameters, ExpectedTypes, nullptr))
                 return;
 
@@ -310,13 +798,60 @@ void UJsonMessageDispatcher::RegisterNotificationHandler(const FString& Method,
                 return;
 
             TSharedPtr<FJsonObject> Parameter = Params ? Params->AsObject() : MakeShared<FJsonObject>();
-            if (!ValidateParamsObject(Parameter, ExpectedTypes, nullptr))
+            if (!ValidateParamsObject(*Parameter, ExpectedTypes, nullptr))
                 return;
 
             Handler(Parameter);
         }, Owner);
 }
 
+void UJsonMessageDispatcher::RegisterNotificationViewHandler(const FString& Method, const TArray<EJson>& ExpectedTypes, const FJsonRpcNotificationHandlerArrayViewLambda& Handler, UObject* Owner)
+{
+    RegisterNotificationHandler(
+        Method,
+        [Handler, ExpectedTypes](const TSharedPtr<FJsonValue>& Params)
+        {
+            TConstArrayView<TSharedPtr<FJsonValue>> Parameters;
+            if (!GetParamsArray(Params, Parameters))
+                return;
+
+            if (!ValidateParamsArray(Parameters, ExpectedTypes, nullptr))
+                return;
+
+            Handler(Parameters);
+        }, Owner);
+}
+
+void UJsonMessageDispatcher::RegisterNotificationViewHandler(const FString& Method, const TMap<FString, EJson>& ExpectedTypes, const FJsonRpcNotificationHandlerObjectViewLambda& Handler, UObject* Owner)
+{
+    RegisterNotificationHandler(
+        Method,
+        [Handler, ExpectedTypes](const TSharedPtr<FJsonValue>& Params)
+        {
+            const FJsonObject* Parameter = GetParamsObject(Params);
+            if (Parameter == nullptr)
+                return;
+
+            if (!ValidateParamsObject(*Parameter, ExpectedTypes, nullptr))
+                return;
+
+            Handler(*Parameter);
+        }, Owner);
+}
+
+void UJsonMessageDispatcher::RegisterCompactNotificationHandler(const FString& Method, const FJsonRpcNotificationHandlerCompactLambda& Handler, UObject* Owner)
+{
+    auto NewHandler = MakeShared<FJsonRpcNotificationHandler>();
+    NewHandler->Owner = Owner;
+    NewHandler->CompactAction = Handler;
+
+    if (TArray<TSharedPtr<FJsonRpcNotificationHandler>>* MethodHandlers = NotificationHandlers.Find(Method))
+        MethodHandlers->Add(NewHandler);
+    else
+        NotificationHandlers.Add(Method, {NewHandler});
+    bShardRegistryDirty = true;
+}
+
 bool UJsonMessageDispatcher::IsNotificationHandlerRegistered(const FString& Method, UObject* Owner) const
 {
     const TArray<TSharedPtr<FJsonRpcNotificationHandler>>* HandlersPtr = NotificationHandlers.Find(Method);
@@ -341,6 +876,8 @@ void UJsonMessageDispatcher::UnregisterNotificationHandler(const FString& Method
     if (HandlersPtr == nullptr)
         return;
 
+    bShardRegistryDirty = true;
+
     if (Owner == nullptr)
     {
         NotificationHandlers.Remove(Method);
@@ -368,32 +905,171 @@ void UJsonMessageDispatcher::UnregisterHandlersFromOwner(UObject* Owner)
 {
     UnregisterRequestHandlersFromOwner(Owner);
     UnregisterNotificationHandlersFromOwner(Owner);
+
+    for (auto It = Snapshots.CreateIterator(); It; ++It)
+    {
+        if (It->Value.Owner == Owner)
+            It.RemoveCurrent();
+    }
 }
 
 
-/** Message Sending */
+/** Snapshots */
 
-bool SendMessageIfBound(const TScriptInterface<IMessageSender>& MessageSender, const FString& Message)
+/** Condensed serialization of any json value, including non object roots */
+bool SerializeJsonValue(const TSharedPtr<FJsonValue>& Value, FString& OutString)
 {
-    UObject* Object = MessageSender.GetObject();
-    if (!IsValid(Object))
-        return false;
+    TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&OutString);
+    return FJsonSerializer::Serialize(Value, FString(), Writer);
+}
+
+void UJsonMessageDispatcher::RegisterSnapshotProducer(const FString& Name, const FJsonRpcSnapshotProducerLambda& Producer, UObject* Owner)
+{
+    FJsonRpcSnapshot& Snapshot = Snapshots.Add(Name);
+    Snapshot.Owner = Owner;
+    Snapshot.Producer = Producer;
+}
+
+void UJsonMessageDispatcher::UnregisterSnapshotProducer(const FString& Name)
+{
+    Snapshots.Remove(Name);
+}
+
+bool UJsonMessageDispatcher::GetSerializedSnapshot(const FString& Name, FString& OutSerializedValue)
+{
+    FJsonRpcSnapshot* Snapshot = Snapshots.Find(Name);
+    if (Snapshot == nullptr || !Snapshot->Producer)
+        return false;
+
+    if (Snapshot->BuildFrame != GFrameCounter)
+    {
+        INC_DWORD_STAT(STAT_WebApiServer_SnapshotBuilds);
+
+        const TSharedPtr<FJsonValue> Value = Snapshot->Producer();
+
+        // The producer may have registered or removed snapshots
+        Snapshot = Snapshots.Find(Name);
+        if (Snapshot == nullptr)
+            return false;
+
+        Snapshot->SerializedValue.Reset();
+        if (!SerializeJsonValue(Value.IsValid() ? Value : MakeShared<FJsonValueNull>(), Snapshot->SerializedValue))
+        {
+            Snapshot->BuildFrame = MAX_uint64;
+            return false;
+        }
+        Snapshot->BuildFrame = GFrameCounter;
+    }
+    else
+    {
+        INC_DWORD_STAT(STAT_WebApiServer_SnapshotReuses);
+    }
+
+    OutSerializedValue = Snapshot->SerializedValue;
+    return true;
+}
+
+bool UJsonMessageDispatcher::RegisterSnapshotRequestHandler(const FString& Method, const FString& SnapshotName, UObject* Owner, bool bOverride)
+{
+    if (!bOverride && HaveValidRequestHandler(Method))
+        return false;
+
+    TWeakObjectPtr<UJsonMessageDispatcher> WeakThis = this;
+    auto NewHandler = MakeShared<FJsonRpcRequestHandler>();
+    NewHandler->Owner = Owner;
+    NewHandler->SerializedAction = [WeakThis, SnapshotName](FString& OutSerializedResult, FString& OutError)
+    {
+        UJsonMessageDispatcher* Dispatcher = WeakThis.Get();
+        if (Dispatcher == nullptr || !Dispatcher->GetSerializedSnapshot(SnapshotName, OutSerializedResult))
+        {
+            OutError = FString::Printf(TEXT("snapshot %s unavailable"), *SnapshotName);
+            return false;
+        }
+        return true;
+    };
+    // Snapshots are built once per game frame
+    NewHandler->bGameThreadBound = true;
+
+    AddRequestHandler(Method, NewHandler);
+    return true;
+}
+
+/** Method Policies */
+
+void UJsonMessageDispatcher::SetMethodPolicy(const FString& Method, const FJsonRpcMethodPolicy& Policy)
+{
+    MethodPolicies.Add(Method, Policy);
+    ResponseCache.Invalidate(Method);
+    bShardRegistryDirty = true;
+}
+
+void UJsonMessageDispatcher::ClearMethodPolicy(const FString& Method)
+{
+    MethodPolicies.Remove(Method);
+    ResponseCache.Invalidate(Method);
+    bShardRegistryDirty = true;
+}
+
+bool UJsonMessageDispatcher::GetMethodPolicy(const FString& Method, FJsonRpcMethodPolicy& OutPolicy) const
+{
+    const FJsonRpcMethodPolicy* Policy = MethodPolicies.Find(Method);
+    if (Policy == nullptr)
+        return false;
+
+    OutPolicy = *Policy;
+    return true;
+}
+
+void UJsonMessageDispatcher::InvalidateCachedResponses(const FString& Method)
+{
+    ResponseCache.Invalidate(Method);
+    SET_MEMORY_STAT(STAT_WebApiServer_ResponseCacheSize, ResponseCache.GetUsedBytes());
+}
+
+void UJsonMessageDispatcher::InvalidateAllCachedResponses()
+{
+    ResponseCache.Reset();
+    SET_MEMORY_STAT(STAT_WebApiServer_ResponseCacheSize, 0);
+}
+
+/** Message Sending */
+
+/** Every message sent by a dispatcher goes through here, Dispatcher is null once it's gone */
+bool SendMessageIfBound(const UJsonMessageDispatcher* Dispatcher, const TScriptInterface<IMessageSender>& MessageSender, const FString& Message)
+{
+    UObject* Object = MessageSender.GetObject();
+    if (!IsValid(Object))
+        return false;
+
+    if (Dispatcher != nullptr && Dispatcher->HasOutgoingInterceptors())
+    {
+        FString InterceptedMessage = Message;
+        if (!Dispatcher->InterceptOutgoing(MessageSender, InterceptedMessage))
+            return false;
+        return IMessageSender::Execute_SendMessage(Object, InterceptedMessage);
+    }
 
     return IMessageSender::Execute_SendMessage(Object, Message);
 }
 
-bool SendJsonMessage(const TScriptInterface<IMessageSender>& MessageSender, const TSharedPtr<FJsonObject>& JsonResponse)
+/** Response built around an already serialized result */
+FString MakeSerializedResultMessage(int32 Id, const FString& SerializedResult)
+{
+    return FString::Printf(TEXT("{\"" JSONRPC_ID "\":%d,\"" JSONRPC_RESULT "\":%s}"), Id, *SerializedResult);
+}
+
+bool SendJsonMessage(const UJsonMessageDispatcher* Dispatcher, const TScriptInterface<IMessageSender>& MessageSender, const TSharedPtr<FJsonObject>& JsonResponse)
 {
     FString StringResponse;
     TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&StringResponse);
 
     if (!FJsonSerializer::Serialize(JsonResponse.ToSharedRef(), Writer))
     {
-        SendMessageIfBound(MessageSender, TEXT("internal_serialization_error"));
+        SendMessageIfBound(Dispatcher, MessageSender, TEXT("internal_serialization_error"));
         return false;
     }
 
-    return SendMessageIfBound(MessageSender, StringResponse);
+    return SendMessageIfBound(Dispatcher, MessageSender, StringResponse);
 }
 
 void UJsonMessageDispatcher::SendRequestWithCompletion(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FJsonObjectWrapper& Params, EJsonObjectWrapperType ParamsType, const FJsonRpcResponseHandlerDelegate& CompletionHandler, float Timeout)
@@ -424,17 +1100,85 @@ void UJsonMessageDispatcher::SendRequestWithPromise(const TScriptInterface<IMess
 }
 
 
+float UJsonMessageDispatcher::GetRequestTimeout(const TScriptInterface<IMessageSender>& MessageSender, float Timeout) const
+{
+    if (Timeout > 0.0f)
+        return Timeout;
+
+    float SmoothedRtt, RttVariation;
+    const IMessageSender* Sender = MessageSender.GetInterface();
+    if (Sender == nullptr || !Sender->GetRoundTripTime(SmoothedRtt, RttVariation))
+        return MaxAdaptiveTimeout;
+
+    return FMath::Min(AdaptiveTimeoutBase + SmoothedRtt + 4.0f * RttVariation, MaxAdaptiveTimeout);
+}
+
+void UJsonMessageDispatcher::FailPendingRequests(const TScriptInterface<IMessageSender>& MessageSender, const FString& Error)
+{
+    UObject* Object = MessageSender.GetObject();
+
+    // Collected first, completion handlers may send new requests
+    TArray<TSharedPtr<FJsonRpcResponseHandler>> Failed;
+    for (auto It = ResponseHandlers.CreateIterator(); It; ++It)
+    {
+        if (It->Value.IsValid() && It->Value->MessageSender == Object)
+        {
+            Failed.Add(It->Value);
+            It.RemoveCurrent();
+        }
+    }
+
+    for (const TSharedPtr<FJsonRpcResponseHandler>& Handler : Failed)
+        Handler->CompletionHandler(false, nullptr, Error);
+}
+
+int32 UJsonMessageDispatcher::NextRequestId()
+{
+    return static_cast<int32>(RequestIdCounter.fetch_add(1, std::memory_order_relaxed) % JSONRPC_ID_MAX) + 1;
+}
+
 void UJsonMessageDispatcher::SendRequest(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const FJsonRpcResponseHandlerLambda& CompletionHandler, float Timeout)
 {
-    int32 RequestId = ++LastRequestId;
+    TSharedPtr<FJsonRpcResponseHandler> NewHandler = MakeShared<FJsonRpcResponseHandler>();
+    NewHandler->CompletionHandler = CompletionHandler;
+    SendRequestWithHandler(MessageSender, Method, Params, NewHandler, Timeout);
+}
 
-    if (LastRequestId >= JSONRPC_ID_MAX)
-        LastRequestId = 0;
+void UJsonMessageDispatcher::SendStreamingRequestWithCompletion(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FJsonObjectWrapper& Params, EJsonObjectWrapperType ParamsType, const FJsonRpcResponseChunkHandlerDelegate& ChunkHandler, const FJsonRpcResponseHandlerDelegate& CompletionHandler, float Timeout)
+{
+    SendStreamingRequest(MessageSender, Method, FromJsonWrapper(Params, ParamsType),
+        [ChunkHandler](const TSharedPtr<FJsonValue>& Chunk)
+        {
+            ChunkHandler.ExecuteIfBound(ToJsonWrapper(Chunk));
+        },
+        [CompletionHandler](bool bSuccess, const TSharedPtr<FJsonValue>& Result, const FString& Error)
+        {
+            CompletionHandler.ExecuteIfBound(bSuccess, ToJsonWrapper(Result), Error);
+        }, Timeout);
+}
 
+void UJsonMessageDispatcher::SendStreamingRequest(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const FJsonRpcResponseChunkHandlerLambda& ChunkHandler, const FJsonRpcResponseHandlerLambda& CompletionHandler, float Timeout)
+{
     TSharedPtr<FJsonRpcResponseHandler> NewHandler = MakeShared<FJsonRpcResponseHandler>();
     NewHandler->CompletionHandler = CompletionHandler;
-    NewHandler->Timeout = FDateTime::UtcNow() + FTimespan::FromSeconds(Timeout);
-    ResponseHandlers.Add(RequestId, NewHandler);
+    NewHandler->ChunkHandler = ChunkHandler;
+    NewHandler->bGrantsCredits = StreamCreditWindow > 0;
+    const int32 RequestId = SendRequestWithHandler(MessageSender, Method, Params, NewHandler, Timeout);
+
+    // Sent right behind the request, so the stream is paced from its first chunks
+    if (NewHandler->bGrantsCredits && ResponseHandlers.Contains(RequestId))
+        SendStreamCredit(MessageSender, RequestId, StreamCreditWindow);
+}
+
+int32 UJsonMessageDispatcher::SendRequestWithHandler(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const TSharedPtr<FJsonRpcResponseHandler>& Handler, float Timeout)
+{
+    int32 RequestId = NextRequestId();
+
+    Handler->TimeoutSeconds = GetRequestTimeout(MessageSender, Timeout);
+    Handler->Timeout = FDateTime::UtcNow() + FTimespan::FromSeconds(Handler->TimeoutSeconds);
+    Handler->MessageSender = MessageSender.GetObject();
+    ResponseHandlers.Add(RequestId, Handler);
+    ObserveSender(MessageSender);
 
     TSharedPtr<FJsonObject> Request = MakeShared<FJsonObject>();
 
@@ -443,10 +1187,11 @@ void UJsonMessageDispatcher::SendRequest(const TScriptInterface<IMessageSender>&
     if (Params.IsValid())
         Request->SetField(TEXT(JSONRPC_PARAMS), Params);
 
-    if (!SendJsonMessage(MessageSender, Request))
+    if (!SendJsonMessage(this, MessageSender, Request))
     {
         HandleResponse(RequestId, nullptr, MakeShared<FJsonValueString>(TEXT("failed_to_send_message")));
     }
+    return RequestId;
 }
 
 void UJsonMessageDispatcher::SendRequest(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const FJsonRpcResponseSuccessHandlerLambda& SuccessHandler, const FJsonRpcResponseFailureHandlerLambda& FailureHandler, float Timeout)
@@ -487,134 +1232,1453 @@ void UJsonMessageDispatcher::SendNotification(const TScriptInterface<IMessageSen
     if (Params.IsValid())
         Request->SetField(TEXT(JSONRPC_PARAMS), Params);
 
-    SendJsonMessage(MessageSender, Request);
+    SendJsonMessage(this, MessageSender, Request);
 }
 
-/** Message handling */
-
-void UJsonMessageDispatcher::HandleMessage(const FString& Message, TScriptInterface<IMessageSender> MessageSender)
+void UJsonMessageDispatcher::SendRequestAnyThread(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const FJsonRpcResponseHandlerLambda& CompletionHandler, float Timeout)
 {
-    TSharedPtr<FJsonObject> JsonMessage;
-    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Message);
+    FJsonRpcOutboundMessage Outbound;
+    Outbound.MessageSender = MessageSender.GetObject();
+    Outbound.RequestId = NextRequestId();
+    Outbound.CompletionHandler = CompletionHandler;
+    Outbound.Timeout = Timeout;
 
-    if (!FJsonSerializer::Deserialize(Reader, JsonMessage) || !JsonMessage.IsValid())
-    {
-        SendMessageIfBound(MessageSender, TEXT("invalid_json"));
-        return;
-    }
+    TSharedPtr<FJsonObject> Request = MakeShared<FJsonObject>();
+    Request->SetNumberField(TEXT(JSONRPC_ID), Outbound.RequestId);
+    Request->SetStringField(TEXT(JSONRPC_METHOD), Method);
+    if (Params.IsValid())
+        Request->SetField(TEXT(JSONRPC_PARAMS), Params);
+
+    // An empty message reports the failure through the completion handler once on the game thread
+    SerializeJsonValue(MakeShared<FJsonValueObject>(Request), Outbound.Message);
 
-    HandleJsonMessage(JsonMessage, MessageSender);
+    OutboundQueue->Enqueue(MoveTemp(Outbound));
+    StartTicking();
 }
 
-void UJsonMessageDispatcher::HandleJsonMessage(const FJsonObjectWrapper& JsonMessage, TScriptInterface<IMessageSender> MessageSender)
+void UJsonMessageDispatcher::SendNotificationAnyThread(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params)
 {
-    HandleJsonMessage(JsonMessage.JsonObject, MessageSender);
+    FJsonRpcOutboundMessage Outbound;
+    Outbound.MessageSender = MessageSender.GetObject();
+
+    TSharedPtr<FJsonObject> Request = MakeShared<FJsonObject>();
+    Request->SetStringField(TEXT(JSONRPC_METHOD), Method);
+    if (Params.IsValid())
+        Request->SetField(TEXT(JSONRPC_PARAMS), Params);
+
+    if (!SerializeJsonValue(MakeShared<FJsonValueObject>(Request), Outbound.Message))
+        return;
+
+    OutboundQueue->Enqueue(MoveTemp(Outbound));
+    StartTicking();
 }
 
-TSharedPtr<FJsonObject> MakeErrorJson(int32 Id, const FString &Error)
+void UJsonMessageDispatcher::FlushOutboundQueue()
 {
-    TSharedPtr<FJsonObject> ErrorJson = MakeShared<FJsonObject>();
+    check(IsInGameThread());
 
-    ErrorJson->SetNumberField(TEXT(JSONRPC_ID), Id);
-    ErrorJson->SetStringField(TEXT(JSONRPC_ERROR), Error);
-    return ErrorJson;
+    FJsonRpcOutboundMessage Outbound;
+    while (OutboundQueue->Dequeue(Outbound))
+    {
+        if (Outbound.CompletionHandler)
+        {
+            TSharedPtr<FJsonRpcResponseHandler> NewHandler = MakeShared<FJsonRpcResponseHandler>();
+            NewHandler->CompletionHandler = MoveTemp(Outbound.CompletionHandler);
+            NewHandler->TimeoutSeconds = GetRequestTimeout(TScriptInterface<IMessageSender>(Outbound.MessageSender.Get()), Outbound.Timeout);
+            NewHandler->Timeout = FDateTime::UtcNow() + FTimespan::FromSeconds(NewHandler->TimeoutSeconds);
+            NewHandler->MessageSender = Outbound.MessageSender;
+            ResponseHandlers.Add(Outbound.RequestId, NewHandler);
+            ObserveSender(TScriptInterface<IMessageSender>(Outbound.MessageSender.Get()));
+        }
+
+        UObject* Object = Outbound.MessageSender.Get();
+        const bool bSent = !Outbound.Message.IsEmpty() && SendMessageIfBound(this, TScriptInterface<IMessageSender>(Object), Outbound.Message);
+        if (!bSent && Outbound.RequestId != 0)
+            HandleResponse(Outbound.RequestId, nullptr, MakeShared<FJsonValueString>(TEXT("failed_to_send_message")));
+    }
 }
 
-void UJsonMessageDispatcher::HandleJsonMessage(const TSharedPtr<FJsonObject>& JsonMessage, TScriptInterface<IMessageSender> MessageSender)
+void UJsonMessageDispatcher::SendNotificationConflated(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FString& Key, const FJsonObjectWrapper& Params, EJsonObjectWrapperType ParamsType)
 {
-    int32 Id;
-    bool bHasId = JsonMessage->TryGetNumberField(TEXT(JSONRPC_ID), Id);
+    SendNotificationConflated(MessageSender, Method, Key, FromJsonWrapper(Params, ParamsType));
+}
 
-    FString Method;
-    bool bHasMethod = JsonMessage->TryGetStringField(TEXT(JSONRPC_METHOD), Method);
+void UJsonMessageDispatcher::SendNotificationConflated(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FString& Key, const TSharedPtr<FJsonValue>& Params)
+{
+    UObject* Object = MessageSender.GetObject();
+    if (!IsValid(Object))
+        return;
 
-    if (bHasMethod)
+    TSharedPtr<FJsonRpcConflationQueue>& Queue = ConflationQueues.FindOrAdd(Object);
+    if (!Queue.IsValid())
     {
-        if (bHasId)
-            HandleRequest(Id, Method, JsonMessage->TryGetField(TEXT(JSONRPC_PARAMS)), MessageSender);
-        else
-            HandleNotification(Method, JsonMessage->TryGetField(TEXT(JSONRPC_PARAMS)));
+        Queue = MakeShared<FJsonRpcConflationQueue>();
+        Queue->Sender = Object;
     }
-    else
+
+    TPair<FString, FString> NotificationKey(Method, Key);
+    if (const int32* Position = Queue->Positions.Find(NotificationKey))
     {
-        if (bHasId)
-            HandleResponse(Id, JsonMessage->TryGetField(TEXT(JSONRPC_RESULT)), JsonMessage->TryGetField(TEXT(JSONRPC_ERROR)));
+        INC_DWORD_STAT(STAT_WebApiServer_ConflatedReplaced);
+        Queue->Notifications[*Position].Params = Params;
+        return;
     }
+
+    Queue->Positions.Add(MoveTemp(NotificationKey), Queue->Notifications.Num());
+    Queue->Notifications.Add({Method, Params});
+    StartTicking();
 }
 
-void UJsonMessageDispatcher::HandleRequest(int32 Id,const FString& Method, const TSharedPtr<FJsonValue>& Params, TScriptInterface<IMessageSender> MessageSender)
+void UJsonMessageDispatcher::FlushConflatedNotifications()
 {
-    TSharedPtr<FJsonRpcRequestHandler>* Handler = RequestHandlers.Find(Method);
-    if (Handler == nullptr || !Handler->IsValid())
+    LastConflationFlushTime = FPlatformTime::Seconds();
+
+    // Sending may end up queueing new notifications
+    TMap<TObjectKey<UObject>, TSharedPtr<FJsonRpcConflationQueue>> Queues = MoveTemp(ConflationQueues);
+    ConflationQueues.Reset();
+
+    for (const auto& [Key, Queue] : Queues)
     {
-        SendJsonMessage(MessageSender, MakeErrorJson(Id, FString::Printf(TEXT("no handlers for method %s"), *Method)));
-        return;
+        UObject* Object = Queue->Sender.Get();
+        if (!IsValid(Object) || Queue->Notifications.IsEmpty())
+            continue;
+
+        FString Batch;
+        int32 Count = 0;
+        for (const FJsonRpcConflationQueue::FNotification& Notification : Queue->Notifications)
+        {
+            TSharedPtr<FJsonObject> Request = MakeShared<FJsonObject>();
+            Request->SetStringField(TEXT(JSONRPC_METHOD), Notification.Method);
+            if (Notification.Params.IsValid())
+                Request->SetField(TEXT(JSONRPC_PARAMS), Notification.Params);
+
+            FString SerializedRequest;
+            if (!SerializeJsonValue(MakeShared<FJsonValueObject>(Request), SerializedRequest))
+                continue;
+
+            if (Count++ > 0)
+                Batch += TEXT(",");
+            Batch += SerializedRequest;
+        }
+
+        if (Count == 0)
+            continue;
+
+        // A single notification goes out as is, several as a batch array
+        if (Count > 1)
+            Batch = TEXT("[") + Batch + TEXT("]");
+
+        INC_DWORD_STAT_BY(STAT_WebApiServer_ConflatedSent, Count);
+        SendMessageIfBound(this, TScriptInterface<IMessageSender>(Object), Batch);
     }
+}
+
+/** Message handling */
 
-    (*Handler)->Action(Params,
-        [Id, MessageSender](const TSharedPtr<FJsonValue>& Result)
+/** Elements of a batch message, 1 for anything else. Only scans the structure, the message is parsed later. */
+static int32 CountBatchElements(const FString& Message)
+{
+    const TCHAR* Char = *Message;
+    while (FChar::IsWhitespace(*Char))
+        ++Char;
+    if (*Char != TEXT('['))
+        return 1;
+
+    int32 Depth = 0;
+    int32 Elements = 1;
+    bool bInString = false;
+    for (; *Char != TEXT('\0'); ++Char)
+    {
+        if (bInString)
         {
-            TSharedPtr<FJsonObject> JsonResponse = MakeShared<FJsonObject>();
-            JsonResponse->SetNumberField(TEXT(JSONRPC_ID), Id);
-            JsonResponse->SetField(TEXT(JSONRPC_RESULT), Result != nullptr ? Result : MakeShared<FJsonValueNull>());
-            SendJsonMessage(MessageSender, JsonResponse);
-        }, [Id, MessageSender](const FString& Error)
+            if (*Char == TEXT('\\') && Char[1] != TEXT('\0'))
+                ++Char;
+            else if (*Char == TEXT('"'))
+                bInString = false;
+            continue;
+        }
+
+        switch (*Char)
         {
-            SendJsonMessage(MessageSender, MakeErrorJson(Id, Error));
-        });
+        case TEXT('"'):
+            bInString = true;
+            break;
+        case TEXT('['):
+        case TEXT('{'):
+            ++Depth;
+            break;
+        case TEXT(']'):
+        case TEXT('}'):
+            if (--Depth <= 0)
+                return Elements;
+            break;
+        case TEXT(','):
+            if (Depth == 1)
+                ++Elements;
+            break;
+        default:
+            break;
+        }
+    }
+    return Elements;
 }
 
-void UJsonMessageDispatcher::HandleNotification(const FString& Method, const TSharedPtr<FJsonValue>& Params)
+void UJsonMessageDispatcher::HandleMessage(const FString& Message, TScriptInterface<IMessageSender> MessageSender)
 {
-    auto* Handlers = NotificationHandlers.Find(Method);
-    if (!Handlers)
+    if (MessagesPerSecondPerClient > 0.0f && !AdmitMessages(MessageSender, CountBatchElements(Message)))
+    {
+        SendMessageIfBound(this, MessageSender, RateLimitedMessage);
         return;
+    }
 
-    for (const auto& Handler : *Handlers)
+    if (!Shards.IsEmpty())
+    {
+        DispatchToShard(Message, MessageSender);
+        return;
+    }
+
+    // Handlers may dispatch messages of their own
+    TGuardValue<int32> MessageSize(HandledMessageSize, Message.Len());
+
+    if (bUseCompactJsonDom && !bCompactDocumentInUse)
     {
-        Handler->Action(Params);
+        HandleCompactMessage(Message, MessageSender);
+        return;
     }
-}
 
-void UJsonMessageDispatcher::HandleResponse(int32 Id, const TSharedPtr<FJsonValue>& Result, const TSharedPtr<FJsonValue>& Error)
-{
-    TSharedPtr<FJsonRpcResponseHandler> Handler;
+    TSharedPtr<FJsonValue> JsonValue;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Message);
 
-    if (!ResponseHandlers.RemoveAndCopyValue(Id, Handler))
+    if (!FJsonSerializer::Deserialize(Reader, JsonValue) || !JsonValue.IsValid())
+    {
+        SendMessageIfBound(this, MessageSender, TEXT("invalid_json"));
         return;
-    
-    if (!Handler.IsValid())
+    }
+
+    // Batch: every element is handled as its own message
+    if (JsonValue->Type == EJson::Array)
+    {
+        for (const TSharedPtr<FJsonValue>& Element : JsonValue->AsArray())
+        {
+            const TSharedPtr<FJsonObject>* ElementObject;
+            if (Element.IsValid() && Element->TryGetObject(ElementObject) && ElementObject->IsValid())
+                HandleJsonMessage(*ElementObject, MessageSender);
+        }
         return;
+    }
 
-    if (Error.IsValid() && !Error->IsNull())
+    const TSharedPtr<FJsonObject>* JsonMessage;
+    if (!JsonValue->TryGetObject(JsonMessage) || !JsonMessage->IsValid())
     {
-        FString ErrorString;
-        if (Error->TryGetString(ErrorString))
-            Handler->CompletionHandler(false, nullptr, ErrorString);
+        SendMessageIfBound(this, MessageSender, TEXT("invalid_json"));
         return;
     }
 
-    Handler->CompletionHandler(true, Result, TEXT(""));
+    HandleJsonMessage(*JsonMessage, MessageSender);
 }
 
-void UJsonMessageDispatcher::Cleanup()
+void UJsonMessageDispatcher::HandleCompactMessage(const FString& Message, TScriptInterface<IMessageSender> MessageSender)
 {
-    for (auto It = ResponseHandlers.CreateIterator(); It; ++It)
+    TGuardValue<bool> DocumentInUse(bCompactDocumentInUse, true);
+
     {
-        if (!It->Value.IsValid())
+        SCOPE_CYCLE_COUNTER(STAT_WebApiServer_CompactJsonParse);
+
+        const SIZE_T PreviousSize = CompactDocument.GetAllocatedSize();
+        const bool bParsed = CompactDocument.Parse(Message);
+
+        const SIZE_T NewSize = CompactDocument.GetAllocatedSize();
+        if (NewSize != PreviousSize)
         {
-            It.RemoveCurrent();
-            continue;
+            INC_DWORD_STAT(STAT_WebApiServer_CompactJsonArenaGrowths);
+            SET_MEMORY_STAT(STAT_WebApiServer_CompactJsonArenaSize, NewSize);
         }
-        if (It->Value->Timeout < FDateTime::UtcNow())
+
+        if (!bParsed)
         {
-            It->Value->CompletionHandler(false, nullptr, TEXT("timeout"));
-            It.RemoveCurrent();
+            SendMessageIfBound(this, MessageSender, TEXT("invalid_json"));
+            return;
         }
     }
-    for (auto It = NotificationHandlers.CreateIterator(); It; ++It)
+
+    INC_DWORD_STAT_BY(STAT_WebApiServer_CompactJsonNodes, CompactDocument.GetNodeCount());
+
+    const FJsonArenaView Root = CompactDocument.GetRoot();
+
+    // Batch: every element is handled as its own message
+    if (Root.GetType() == EJsonArenaType::Array)
     {
-        if (!It->Value.IsEmpty())
-            It.RemoveCurrent();
+        for (const FJsonArenaView Element : Root)
+        {
+            if (Element.GetType() == EJsonArenaType::Object)
+                HandleCompactJsonMessage(Element, MessageSender);
+        }
+        return;
+    }
+
+    if (Root.GetType() != EJsonArenaType::Object)
+    {
+        SendMessageIfBound(this, MessageSender, TEXT("invalid_json"));
+        return;
+    }
+
+    HandleCompactJsonMessage(Root, MessageSender);
+}
+
+void UJsonMessageDispatcher::HandleCompactJsonMessage(const FJsonArenaView& JsonMessage, TScriptInterface<IMessageSender> MessageSender)
+{
+    int32 Id;
+    bool bHasId = JsonMessage.Find(TEXT(JSONRPC_ID)).TryGetNumber(Id);
+
+    FString Method;
+    bool bHasMethod = JsonMessage.Find(TEXT(JSONRPC_METHOD)).TryGetString(Method);
+
+    if (bHasMethod)
+    {
+        const FJsonRpcIncomingParams Params(JsonMessage.Find(TEXT(JSONRPC_PARAMS)));
+        if (bHasId)
+            HandleRequest(Id, Method, Params, MessageSender);
+        else if (Method == TEXT(JSONRPC_STREAM_CREDIT))
+            HandleStreamCredit(Params.GetValue(), MessageSender);
+        else
+            HandleNotification(Method, Params);
+    }
+    else if (bHasId)
+    {
+        const FJsonArenaView Chunk = JsonMessage.Find(TEXT(JSONRPC_CHUNK));
+        if (Chunk.IsValid())
+            HandleResponseChunk(Id, Chunk.ToJsonValue());
+        else
+            HandleResponse(Id, JsonMessage.Find(TEXT(JSONRPC_RESULT)).ToJsonValue(), JsonMessage.Find(TEXT(JSONRPC_ERROR)).ToJsonValue());
+    }
+}
+
+void UJsonMessageDispatcher::HandleJsonMessage(const FJsonObjectWrapper& JsonMessage, TScriptInterface<IMessageSender> MessageSender)
+{
+    HandleJsonMessage(JsonMessage.JsonObject, MessageSender);
+}
+
+TSharedPtr<FJsonObject> MakeErrorJson(int32 Id, const FString &Error)
+{
+    TSharedPtr<FJsonObject> ErrorJson = MakeShared<FJsonObject>();
+
+    ErrorJson->SetNumberField(TEXT(JSONRPC_ID), Id);
+    ErrorJson->SetStringField(TEXT(JSONRPC_ERROR), Error);
+    return ErrorJson;
+}
+
+void UJsonMessageDispatcher::HandleJsonMessage(const TSharedPtr<FJsonObject>& JsonMessage, TScriptInterface<IMessageSender> MessageSender)
+{
+    int32 Id;
+    bool bHasId = JsonMessage->TryGetNumberField(TEXT(JSONRPC_ID), Id);
+
+    FString Method;
+    bool bHasMethod = JsonMessage->TryGetStringField(TEXT(JSONRPC_METHOD), Method);
+
+    if (bHasMethod)
+    {
+        const FJsonRpcIncomingParams Params(JsonMessage->TryGetField(TEXT(JSONRPC_PARAMS)));
+        if (bHasId)
+            HandleRequest(Id, Method, Params, MessageSender);
+        else if (Method == TEXT(JSONRPC_STREAM_CREDIT))
+            HandleStreamCredit(Params.GetValue(), MessageSender);
+        else
+            HandleNotification(Method, Params);
+    }
+    else if (bHasId)
+    {
+        const TSharedPtr<FJsonValue> Chunk = JsonMessage->TryGetField(TEXT(JSONRPC_CHUNK));
+        if (Chunk.IsValid())
+            HandleResponseChunk(Id, Chunk);
+        else
+            HandleResponse(Id, JsonMessage->TryGetField(TEXT(JSONRPC_RESULT)), JsonMessage->TryGetField(TEXT(JSONRPC_ERROR)));
+    }
+}
+
+static bool RunRequestInterceptors(const TArray<FJsonRpcRequestInterceptorLambda>& Interceptors, const FString& Method, const TSharedPtr<FJsonValue>& Params,
+    const TScriptInterface<IMessageSender>& MessageSender, FString& OutError)
+{
+    for (const FJsonRpcRequestInterceptorLambda& Interceptor : Interceptors)
+    {
+        if (!Interceptor(Method, Params, MessageSender, OutError))
+        {
+            if (OutError.IsEmpty())
+                OutError = TEXT("rejected");
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool RunNotificationInterceptors(const TArray<FJsonRpcNotificationInterceptorLambda>& Interceptors, const FString& Method, const TSharedPtr<FJsonValue>& Params)
+{
+    for (const FJsonRpcNotificationInterceptorLambda& Interceptor : Interceptors)
+    {
+        if (!Interceptor(Method, Params))
+            return false;
+    }
+    return true;
+}
+
+/** Times the handler call of its scope against HandlerBudgetMs. Reads no clock while the budget is 0. */
+struct FJsonRpcHandlerWatchdog
+{
+    FJsonRpcHandlerWatchdog(UJsonMessageDispatcher& InDispatcher, const FString& InMethod, int32 InMessageSize, bool bInNotification)
+        : Dispatcher(InDispatcher)
+        , Method(InMethod)
+        , MessageSize(InMessageSize)
+        , bNotification(bInNotification)
+        , StartCycles(InDispatcher.HandlerBudgetMs > 0.0f ? FPlatformTime::Cycles64() : 0)
+    {
+    }
+
+    ~FJsonRpcHandlerWatchdog()
+    {
+        if (StartCycles == 0)
+            return;
+
+        const double DurationMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+        if (DurationMs > Dispatcher.HandlerBudgetMs)
+            Dispatcher.RecordSlowCall(Method, MessageSize, bNotification, DurationMs);
+    }
+
+    UJsonMessageDispatcher& Dispatcher;
+    const FString& Method;
+    int32 MessageSize;
+    bool bNotification;
+    uint64 StartCycles;
+};
+
+static void InvokeRequestHandler(const FJsonRpcRequestHandler& Handler, const FJsonRpcIncomingParams& Params,
+    const FJsonRpcRequestCompletionCallback& CompletionCallback, const FJsonRpcRequestErrorCallback& FailureCallback)
+{
+    if (Handler.CompactAction)
+        Handler.CompactAction(Params.GetView(), CompletionCallback, FailureCallback);
+    else
+        Handler.Action(Params.GetValue(), CompletionCallback, FailureCallback);
+}
+
+void UJsonMessageDispatcher::HandleRequest(int32 Id,const FString& Method, const FJsonRpcIncomingParams& Params, TScriptInterface<IMessageSender> MessageSender,
+    const TSharedPtr<FJsonRpcDeferredMessage>& Deferred)
+{
+    if (!RequestInterceptors->IsEmpty())
+    {
+        // Held while the hooks run, they may add or remove interceptors
+        const TSharedRef<const TArray<FJsonRpcRequestInterceptorLambda>> RunningInterceptors = RequestInterceptors;
+        FString Error;
+        if (!RunRequestInterceptors(*RunningInterceptors, Method, Params.GetValue(), MessageSender, Error))
+        {
+            SendJsonMessage(this, MessageSender, MakeErrorJson(Id, Error));
+            return;
+        }
+    }
+
+    TSharedPtr<FJsonRpcRequestHandler>* Handler = RequestHandlers.Find(Method);
+    if (Handler == nullptr || !Handler->IsValid())
+    {
+        SendJsonMessage(this, MessageSender, MakeErrorJson(Id, FString::Printf(TEXT("no handlers for method %s"), *Method)));
+        return;
+    }
+
+    FJsonRpcHandlerWatchdog Watchdog(*this, Method, HandledMessageSize, false);
+
+    const FJsonRpcMethodPolicy* Policy = MethodPolicies.Find(Method);
+
+    if (Policy != nullptr && Policy->RequestsPerSecondPerClient > 0.0f)
+    {
+        FJsonRpcClientAdmission* Admission = FindOrAddClientAdmission(MessageSender);
+        if (Admission != nullptr && !Admission->MethodBuckets.FindOrAdd(Method).TryConsume(FPlatformTime::Seconds(), Policy->RequestsPerSecondPerClient, Policy->RequestBurstPerClient))
+        {
+            INC_DWORD_STAT(STAT_WebApiServer_RateLimitedRequests);
+            ++AdmissionStats.RejectedRequests;
+            SendJsonMessage(this, MessageSender, MakeErrorJson(Id, TEXT("rate_limited")));
+            return;
+        }
+    }
+
+    if ((*Handler)->StreamAction)
+    {
+        StartResponseStream(Id, **Handler, Params.GetValue(), MessageSender);
+        return;
+    }
+
+    if ((*Handler)->SerializedAction)
+    {
+        FString SerializedResult;
+        FString Error;
+        if ((*Handler)->SerializedAction(SerializedResult, Error))
+            SendMessageIfBound(this, MessageSender, MakeSerializedResultMessage(Id, SerializedResult));
+        else
+            SendJsonMessage(this, MessageSender, MakeErrorJson(Id, Error));
+        return;
+    }
+
+    // Responses only need the dispatcher for its outgoing interceptors. Handlers may complete after it's gone.
+    TWeakObjectPtr<UJsonMessageDispatcher> InterceptingThis;
+    if (HasOutgoingInterceptors())
+        InterceptingThis = this;
+
+    FJsonRpcRequestCompletionCallback CompletionCallback = [InterceptingThis, Id, MessageSender](const TSharedPtr<FJsonValue>& Result)
+    {
+        TSharedPtr<FJsonObject> JsonResponse = MakeShared<FJsonObject>();
+        JsonResponse->SetNumberField(TEXT(JSONRPC_ID), Id);
+        JsonResponse->SetField(TEXT(JSONRPC_RESULT), Result != nullptr ? Result : MakeShared<FJsonValueNull>());
+        SendJsonMessage(InterceptingThis.Get(), MessageSender, JsonResponse);
+    };
+    FJsonRpcRequestErrorCallback FailureCallback = [InterceptingThis, Id, MessageSender](const FString& Error)
+    {
+        SendJsonMessage(InterceptingThis.Get(), MessageSender, MakeErrorJson(Id, Error));
+    };
+
+    const bool bCacheResponses = Policy != nullptr && Policy->bCacheResponses;
+    const bool bCoalesceInFlight = Policy != nullptr && Policy->bCoalesceInFlight;
+
+    if (bCacheResponses || bCoalesceInFlight)
+    {
+        FJsonRpcRequestKey RequestKey(Method, Params.GetValue());
+
+        if (bCacheResponses)
+        {
+            if (const FString* CachedResult = ResponseCache.Find(RequestKey, FPlatformTime::Seconds()))
+            {
+                INC_DWORD_STAT(STAT_WebApiServer_ResponseCacheHits);
+                SendMessageIfBound(this, MessageSender, MakeSerializedResultMessage(Id, *CachedResult));
+                return;
+            }
+            INC_DWORD_STAT(STAT_WebApiServer_ResponseCacheMisses);
+        }
+
+        if (bCoalesceInFlight)
+        {
+            // Same request already running, answer this one with its result
+            if (TSharedPtr<FJsonRpcInFlightRequest>* InFlightRequest = InFlightRequests.Find(RequestKey))
+            {
+                INC_DWORD_STAT(STAT_WebApiServer_CoalescedRequests);
+                (*InFlightRequest)->Waiters.Add({Id, MessageSender});
+                return;
+            }
+        }
+
+        TSharedPtr<FJsonRpcInFlightRequest> InFlightRequest = MakeShared<FJsonRpcInFlightRequest>();
+        InFlightRequest->StartTime = FPlatformTime::Seconds();
+        InFlightRequest->Waiters.Add({Id, MessageSender});
+        if (bCoalesceInFlight)
+            InFlightRequests.Add(RequestKey, InFlightRequest);
+
+        // Serialize the result once, for the cache and for every waiting request
+        TWeakObjectPtr<UJsonMessageDispatcher> WeakThis = this;
+        TWeakPtr<FJsonRpcRequestHandler> WeakHandler = *Handler;
+        CompletionCallback = [WeakThis, RequestKey, InFlightRequest, bCacheResponses, WeakHandler, TimeToLive = Policy->CacheTimeToLive](const TSharedPtr<FJsonValue>& Result)
+        {
+            UJsonMessageDispatcher* Dispatcher = WeakThis.Get();
+            if (Dispatcher)
+                Dispatcher->RemoveInFlightRequest(RequestKey, InFlightRequest);
+
+            const TArray<FJsonRpcInFlightRequest::FWaiter> Waiters = MoveTemp(InFlightRequest->Waiters);
+
+            FString SerializedResult;
+            if (!SerializeJsonValue(Result != nullptr ? Result : MakeShared<FJsonValueNull>(), SerializedResult))
+            {
+                for (const FJsonRpcInFlightRequest::FWaiter& Waiter : Waiters)
+                    SendMessageIfBound(Dispatcher, Waiter.MessageSender, TEXT("internal_serialization_error"));
+                return;
+            }
+
+            // The handler may have been replaced or unregistered while it ran
+            const TSharedPtr<FJsonRpcRequestHandler> CurrentHandler = Dispatcher ? Dispatcher->RequestHandlers.FindRef(RequestKey.Method) : nullptr;
+            if (bCacheResponses && CurrentHandler.IsValid() && CurrentHandler == WeakHandler.Pin())
+            {
+                Dispatcher->ResponseCache.MaxBytes = FMath::Max(Dispatcher->ResponseCacheMaxBytes, 0);
+                Dispatcher->ResponseCache.Add(RequestKey, SerializedResult, FPlatformTime::Seconds() + TimeToLive);
+                SET_MEMORY_STAT(STAT_WebApiServer_ResponseCacheSize, Dispatcher->ResponseCache.GetUsedBytes());
+            }
+
+            for (const FJsonRpcInFlightRequest::FWaiter& Waiter : Waiters)
+                SendMessageIfBound(Dispatcher, Waiter.MessageSender, MakeSerializedResultMessage(Waiter.Id, SerializedResult));
+        };
+        FailureCallback = [WeakThis, RequestKey, InFlightRequest](const FString& Error)
+        {
+            if (UJsonMessageDispatcher* Dispatcher = WeakThis.Get())
+                Dispatcher->RemoveInFlightRequest(RequestKey, InFlightRequest);
+
+            const TArray<FJsonRpcInFlightRequest::FWaiter> Waiters = MoveTemp(InFlightRequest->Waiters);
+            for (const FJsonRpcInFlightRequest::FWaiter& Waiter : Waiters)
+                SendJsonMessage(WeakThis.Get(), Waiter.MessageSender, MakeErrorJson(Waiter.Id, Error));
+        };
+    }
+
+    if (MaxPendingRequestsPerClient > 0)
+    {
+        FJsonRpcClientAdmission* Admission = FindOrAddClientAdmission(MessageSender);
+        if (Admission != nullptr)
+        {
+            // Handlers that never complete stop holding a slot once expired, their late completion is then ignored
+            const double Now = FPlatformTime::Seconds();
+            Admission->PendingRequests.RemoveAllSwap([this, Now](const FJsonRpcClientAdmission::FPendingRequest& Pending)
+            {
+                if (*Pending.bReleased || Now - Pending.StartTime < PendingRequestTimeout)
+                    return false;
+                *Pending.bReleased = true;
+                return true;
+            }, EAllowShrinking::No);
+
+            if (Admission->PendingRequests.Num() >= MaxPendingRequestsPerClient)
+            {
+                INC_DWORD_STAT(STAT_WebApiServer_PendingLimitRejections);
+                ++AdmissionStats.RejectedPendingRequests;
+                FailureCallback(TEXT("too_many_pending_requests"));
+                return;
+            }
+
+            // Released on the first completion, handlers completing twice are ignored
+            TSharedRef<bool> bReleased = MakeShared<bool>(false);
+            Admission->PendingRequests.Add({ bReleased, Now });
+            TWeakPtr<FJsonRpcClientAdmission> WeakAdmission = ClientAdmissions.FindChecked(Admission->Sender.Get());
+            auto Release = [WeakAdmission, bReleased]()
+            {
+                if (*bReleased)
+                    return;
+                *bReleased = true;
+
+                TSharedPtr<FJsonRpcClientAdmission> PinnedAdmission = WeakAdmission.Pin();
+                if (PinnedAdmission.IsValid())
+                {
+                    PinnedAdmission->PendingRequests.RemoveAllSwap([&bReleased](const FJsonRpcClientAdmission::FPendingRequest& Pending)
+                    {
+                        return Pending.bReleased == bReleased;
+                    }, EAllowShrinking::No);
+                }
+            };
+            CompletionCallback = [Release, InnerCallback = MoveTemp(CompletionCallback)](const TSharedPtr<FJsonValue>& Result)
+            {
+                Release();
+                InnerCallback(Result);
+            };
+            FailureCallback = [Release, InnerCallback = MoveTemp(FailureCallback)](const FString& Error)
+            {
+                Release();
+                InnerCallback(Error);
+            };
+        }
+    }
+
+    // The following messages of the sender wait for the response
+    if (Deferred.IsValid())
+    {
+        CompletionCallback = [Deferred, InnerCallback = MoveTemp(CompletionCallback)](const TSharedPtr<FJsonValue>& Result)
+        {
+            InnerCallback(Result);
+            Deferred->Release();
+        };
+        FailureCallback = [Deferred, InnerCallback = MoveTemp(FailureCallback)](const FString& Error)
+        {
+            InnerCallback(Error);
+            Deferred->Release();
+        };
+    }
+
+    if (Policy != nullptr && Policy->MaxInFlight > 0)
+    {
+        RunInBulkhead(Method, *Policy, *Handler, Params.GetValue(), CompletionCallback, FailureCallback);
+        return;
+    }
+
+    InvokeRequestHandler(**Handler, Params, CompletionCallback, FailureCallback);
+}
+
+void UJsonMessageDispatcher::RunInBulkhead(const FString& Method, const FJsonRpcMethodPolicy& Policy, const TSharedPtr<FJsonRpcRequestHandler>& Handler, const TSharedPtr<FJsonValue>& Params,
+    const FJsonRpcRequestCompletionCallback& CompletionCallback, const FJsonRpcRequestErrorCallback& FailureCallback)
+{
+    TSharedPtr<FJsonRpcBulkhead>& Bulkhead = Bulkheads.FindOrAdd(Method);
+    if (!Bulkhead.IsValid())
+        Bulkhead = MakeShared<FJsonRpcBulkhead>();
+
+    // The slot is given back on the first completion, then the next queued request can start
+    TWeakObjectPtr<UJsonMessageDispatcher> WeakThis = this;
+    TWeakPtr<FJsonRpcBulkhead> WeakBulkhead = Bulkhead;
+    TSharedRef<bool> bReleased = MakeShared<bool>(false);
+    auto Release = [WeakThis, WeakBulkhead, bReleased, Method]()
+    {
+        if (*bReleased)
+            return;
+        *bReleased = true;
+
+        if (TSharedPtr<FJsonRpcBulkhead> PinnedBulkhead = WeakBulkhead.Pin())
+            --PinnedBulkhead->InFlight;
+        if (UJsonMessageDispatcher* Dispatcher = WeakThis.Get())
+            Dispatcher->DrainBulkhead(Method);
+    };
+
+    TFunction<void ()> Run = [Handler, Params, Release, CompletionCallback, FailureCallback]()
+    {
+        InvokeRequestHandler(*Handler, FJsonRpcIncomingParams(Params),
+            [Release, CompletionCallback](const TSharedPtr<FJsonValue>& Result)
+            {
+                Release();
+                CompletionCallback(Result);
+            },
+            [Release, FailureCallback](const FString& Error)
+            {
+                Release();
+                FailureCallback(Error);
+            });
+    };
+
+    if (Bulkhead->InFlight < Policy.MaxInFlight && Bulkhead->Queue.IsEmpty())
+    {
+        ++Bulkhead->InFlight;
+        Run();
+        return;
+    }
+
+    if (Bulkhead->Queue.Num() >= Policy.MaxQueued)
+    {
+        INC_DWORD_STAT(STAT_WebApiServer_BulkheadRejections);
+        FailureCallback(TEXT("method_busy"));
+        return;
+    }
+
+    FJsonRpcBulkhead::FQueuedRequest& QueuedRequest = Bulkhead->Queue.AddDefaulted_GetRef();
+    QueuedRequest.Run = MoveTemp(Run);
+    QueuedRequest.Reject = FailureCallback;
+    QueuedRequest.EnqueueTime = FPlatformTime::Seconds();
+    QueuedRequest.MessageSize = HandledMessageSize;
+
+    // Queue timeouts are checked on tick
+    StartTicking();
+}
+
+void UJsonMessageDispatcher::DrainBulkhead(const FString& Method)
+{
+    TSharedPtr<FJsonRpcBulkhead>* BulkheadPtr = Bulkheads.Find(Method);
+    if (BulkheadPtr == nullptr)
+        return;
+
+    // Requests completing synchronously would otherwise drain recursively
+    TSharedPtr<FJsonRpcBulkhead> Bulkhead = *BulkheadPtr;
+    if (Bulkhead->bDraining)
+        return;
+    TGuardValue<bool> Draining(Bulkhead->bDraining, true);
+
+    ExpireBulkheadQueues();
+
+    const FJsonRpcMethodPolicy* Policy = MethodPolicies.Find(Method);
+    const int32 MaxInFlight = Policy != nullptr && Policy->MaxInFlight > 0 ? Policy->MaxInFlight : MAX_int32;
+
+    while (!Bulkhead->Queue.IsEmpty() && Bulkhead->InFlight < MaxInFlight)
+    {
+        FJsonRpcBulkhead::FQueuedRequest QueuedRequest = MoveTemp(Bulkhead->Queue[0]);
+        Bulkhead->Queue.RemoveAt(0, 1, EAllowShrinking::No);
+
+        ++Bulkhead->InFlight;
+
+        // Started outside the call of the request, timed on its own
+        FJsonRpcHandlerWatchdog Watchdog(*this, Method, QueuedRequest.MessageSize, false);
+        QueuedRequest.Run();
+    }
+
+    if (Bulkhead->InFlight <= 0 && Bulkhead->Queue.IsEmpty())
+        Bulkheads.Remove(Method);
+}
+
+void UJsonMessageDispatcher::ExpireBulkheadQueues()
+{
+    const double Now = FPlatformTime::Seconds();
+    TArray<FJsonRpcRequestErrorCallback> Expired;
+
+    for (const auto& [Method, Bulkhead] : Bulkheads)
+    {
+        const FJsonRpcMethodPolicy* Policy = MethodPolicies.Find(Method);
+        if (Policy == nullptr || Policy->QueueTimeout <= 0.0f)
+            continue;
+
+        // Oldest first, so expired requests are at the front
+        int32 ExpiredCount = 0;
+        while (ExpiredCount < Bulkhead->Queue.Num() && Now - Bulkhead->Queue[ExpiredCount].EnqueueTime >= Policy->QueueTimeout)
+            Expired.Add(MoveTemp(Bulkhead->Queue[ExpiredCount++].Reject));
+        Bulkhead->Queue.RemoveAt(0, ExpiredCount, EAllowShrinking::No);
+    }
+
+    INC_DWORD_STAT_BY(STAT_WebApiServer_BulkheadQueueTimeouts, Expired.Num());
+    for (const FJsonRpcRequestErrorCallback& Reject : Expired)
+        Reject(TEXT("queue_timeout"));
+}
+
+int32 UJsonMessageDispatcher::GetInFlightCount(const FString& Method) const
+{
+    const TSharedPtr<FJsonRpcBulkhead>* Bulkhead = Bulkheads.Find(Method);
+    return Bulkhead != nullptr ? (*Bulkhead)->InFlight : 0;
+}
+
+int32 UJsonMessageDispatcher::GetQueuedCount(const FString& Method) const
+{
+    const TSharedPtr<FJsonRpcBulkhead>* Bulkhead = Bulkheads.Find(Method);
+    return Bulkhead != nullptr ? (*Bulkhead)->Queue.Num() : 0;
+}
+
+void UJsonMessageDispatcher::RemoveInFlightRequest(const FJsonRpcRequestKey& Key, const TSharedPtr<FJsonRpcInFlightRequest>& InFlightRequest)
+{
+    const TSharedPtr<FJsonRpcInFlightRequest>* Current = InFlightRequests.Find(Key);
+    if (Current != nullptr && *Current == InFlightRequest)
+        InFlightRequests.Remove(Key);
+}
+
+void UJsonMessageDispatcher::HandleNotification(const FString& Method, const FJsonRpcIncomingParams& Params)
+{
+    auto* Handlers = NotificationHandlers.Find(Method);
+    if (!Handlers)
+        return;
+
+    if (!NotificationInterceptors->IsEmpty())
+    {
+        const TSharedRef<const TArray<FJsonRpcNotificationInterceptorLambda>> RunningInterceptors = NotificationInterceptors;
+        if (!RunNotificationInterceptors(*RunningInterceptors, Method, Params.GetValue()))
+            return;
+    }
+
+    FJsonRpcHandlerWatchdog Watchdog(*this, Method, HandledMessageSize, true);
+
+    for (const auto& Handler : *Handlers)
+    {
+        if (Handler->CompactAction)
+            Handler->CompactAction(Params.GetView());
+        else
+            Handler->Action(Params.GetValue());
+    }
+}
+
+/** Interceptors */
+
+int32 UJsonMessageDispatcher::AddInterceptor(const FJsonRpcInterceptor& Interceptor)
+{
+    const int32 Handle = ++NextInterceptorHandle;
+
+    // After the interceptors of the same priority
+    int32 Index = 0;
+    while (Index < Interceptors.Num() && Interceptors[Index].Value.Priority <= Interceptor.Priority)
+        ++Index;
+    Interceptors.Insert(TPair<int32, FJsonRpcInterceptor>(Handle, Interceptor), Index);
+
+    RebuildInterceptors();
+    return Handle;
+}
+
+bool UJsonMessageDispatcher::RemoveInterceptor(int32 Handle)
+{
+    const int32 Removed = Interceptors.RemoveAll([Handle](const TPair<int32, FJsonRpcInterceptor>& Entry)
+    {
+        return Entry.Key == Handle;
+    });
+    if (Removed == 0)
+        return false;
+
+    RebuildInterceptors();
+    return true;
+}
+
+void UJsonMessageDispatcher::RemoveInterceptorsFromOwner(UObject* Owner)
+{
+    // Would remove every interceptor added without an owner
+    if (Owner == nullptr)
+        return;
+
+    const int32 Removed = Interceptors.RemoveAll([Owner](const TPair<int32, FJsonRpcInterceptor>& Entry)
+    {
+        return Entry.Value.Owner == Owner;
+    });
+    if (Removed > 0)
+        RebuildInterceptors();
+}
+
+void UJsonMessageDispatcher::RebuildInterceptors()
+{
+    // New arrays, the current ones may be iterated by the hook that changed the interceptors
+    TSharedRef<TArray<FJsonRpcRequestInterceptorLambda>> NewRequestInterceptors = MakeShared<TArray<FJsonRpcRequestInterceptorLambda>>();
+    TSharedRef<TArray<FJsonRpcNotificationInterceptorLambda>> NewNotificationInterceptors = MakeShared<TArray<FJsonRpcNotificationInterceptorLambda>>();
+    TSharedRef<TArray<FJsonRpcOutgoingInterceptorLambda>> NewOutgoingInterceptors = MakeShared<TArray<FJsonRpcOutgoingInterceptorLambda>>();
+
+    for (const TPair<int32, FJsonRpcInterceptor>& Entry : Interceptors)
+    {
+        if (Entry.Value.OnRequest)
+            NewRequestInterceptors->Add(Entry.Value.OnRequest);
+        if (Entry.Value.OnNotification)
+            NewNotificationInterceptors->Add(Entry.Value.OnNotification);
+        if (Entry.Value.OnOutgoing)
+            NewOutgoingInterceptors->Add(Entry.Value.OnOutgoing);
+    }
+
+    RequestInterceptors = NewRequestInterceptors;
+    NotificationInterceptors = NewNotificationInterceptors;
+    OutgoingInterceptors = NewOutgoingInterceptors;
+
+    bShardRegistryDirty = true;
+}
+
+bool UJsonMessageDispatcher::InterceptOutgoing(const TScriptInterface<IMessageSender>& MessageSender, FString& Message) const
+{
+    const TSharedRef<const TArray<FJsonRpcOutgoingInterceptorLambda>> RunningInterceptors = OutgoingInterceptors;
+    for (const FJsonRpcOutgoingInterceptorLambda& Interceptor : *RunningInterceptors)
+    {
+        if (!Interceptor(MessageSender, Message))
+            return false;
+    }
+    return true;
+}
+
+/** Watchdog */
+
+void UJsonMessageDispatcher::RecordSlowCall(const FString& Method, int32 MessageSize, bool bNotification, double DurationMs)
+{
+    INC_DWORD_STAT(STAT_WebApiServer_SlowHandlerCalls);
+    ++SlowCallCount;
+
+    FJsonRpcSlowCall SlowCall;
+    SlowCall.Method = Method;
+    SlowCall.bNotification = bNotification;
+    SlowCall.DurationMs = static_cast<float>(DurationMs);
+    SlowCall.Time = FDateTime::UtcNow();
+    SlowCall.Frame = static_cast<int64>(GFrameCounter);
+    SlowCall.MessageSize = MessageSize;
+
+    const double Now = FPlatformTime::Seconds();
+    if (Now - LastSlowCallLogTime >= SlowCallLogInterval)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("JsonMessageDispatcher: %s %s took %.2f ms (budget %.2f ms), message of %d characters, %d slow calls not logged since the last warning"),
+            bNotification ? TEXT("Notification") : TEXT("Request"), *Method, DurationMs, HandlerBudgetMs, SlowCall.MessageSize, SuppressedSlowCallLogs);
+        LastSlowCallLogTime = Now;
+        SuppressedSlowCallLogs = 0;
+    }
+    else
+    {
+        ++SuppressedSlowCallLogs;
+    }
+
+    if (SlowCallHistorySize <= 0)
+        return;
+
+    // The size was changed since the last call
+    if (SlowCalls.Num() > SlowCallHistorySize || (SlowCalls.Num() < SlowCallHistorySize && NextSlowCall != SlowCalls.Num()))
+    {
+        SlowCalls = GetSlowCalls();
+        SlowCalls.RemoveAt(0, FMath::Max(SlowCalls.Num() - SlowCallHistorySize + 1, 0));
+        NextSlowCall = SlowCalls.Num();
+    }
+
+    if (SlowCalls.Num() < SlowCallHistorySize)
+        SlowCalls.Add(MoveTemp(SlowCall));
+    else
+        SlowCalls[NextSlowCall] = MoveTemp(SlowCall);
+    NextSlowCall = (NextSlowCall + 1) % SlowCallHistorySize;
+}
+
+TArray<FJsonRpcSlowCall> UJsonMessageDispatcher::GetSlowCalls() const
+{
+    if (NextSlowCall == 0 || NextSlowCall >= SlowCalls.Num())
+        return SlowCalls;
+
+    // Wrapped ring, the oldest call is the next one to be overwritten
+    TArray<FJsonRpcSlowCall> Ordered;
+    Ordered.Reserve(SlowCalls.Num());
+    Ordered.Append(SlowCalls.GetData() + NextSlowCall, SlowCalls.Num() - NextSlowCall);
+    Ordered.Append(SlowCalls.GetData(), NextSlowCall);
+    return Ordered;
+}
+
+void UJsonMessageDispatcher::ClearSlowCalls()
+{
+    SlowCalls.Empty();
+    NextSlowCall = 0;
+    SlowCallCount = 0;
+    SuppressedSlowCallLogs = 0;
+}
+
+void UJsonMessageDispatcher::HandleResponse(int32 Id, const TSharedPtr<FJsonValue>& Result, const TSharedPtr<FJsonValue>& Error)
+{
+    TSharedPtr<FJsonRpcResponseHandler> Handler;
+
+    if (!ResponseHandlers.RemoveAndCopyValue(Id, Handler))
+        return;
+    
+    if (!Handler.IsValid())
+        return;
+
+    if (Error.IsValid() && !Error->IsNull())
+    {
+        FString ErrorString;
+        if (Error->TryGetString(ErrorString))
+            Handler->CompletionHandler(false, nullptr, ErrorString);
+        return;
+    }
+
+    // Collected chunks of a stream answered to a plain request
+    if (!Handler->Chunks.IsEmpty() && (!Result.IsValid() || Result->IsNull()))
+    {
+        Handler->CompletionHandler(true, MakeShared<FJsonValueArray>(MoveTemp(Handler->Chunks)), TEXT(""));
+        return;
+    }
+
+    Handler->CompletionHandler(true, Result, TEXT(""));
+}
+
+void UJsonMessageDispatcher::HandleResponseChunk(int32 Id, const TSharedPtr<FJsonValue>& Chunk)
+{
+    // Held by value, the chunk handler may send requests of its own
+    TSharedPtr<FJsonRpcResponseHandler> Handler = ResponseHandlers.FindRef(Id);
+    if (!Handler.IsValid())
+        return;
+
+    INC_DWORD_STAT(STAT_WebApiServer_StreamChunksReceived);
+
+    // A long stream only times out when it stalls
+    Handler->Timeout = FDateTime::UtcNow() + FTimespan::FromSeconds(Handler->TimeoutSeconds);
+
+    if (Handler->ChunkHandler)
+        Handler->ChunkHandler(Chunk);
+    else
+        Handler->Chunks.Add(Chunk);
+
+    // Handled chunks are given back in batches of half the window, so the peer never waits on a round trip per chunk
+    if (Handler->bGrantsCredits && ++Handler->UncreditedChunks >= FMath::Max(StreamCreditWindow / 2, 1))
+    {
+        SendStreamCredit(TScriptInterface<IMessageSender>(Handler->MessageSender.Get()), Id, Handler->UncreditedChunks);
+        Handler->UncreditedChunks = 0;
+    }
+}
+
+void UJsonMessageDispatcher::SendStreamCredit(const TScriptInterface<IMessageSender>& MessageSender, int32 Id, int32 Chunks)
+{
+    SendMessageIfBound(this, MessageSender, FString::Printf(TEXT("{\"" JSONRPC_METHOD "\":\"" JSONRPC_STREAM_CREDIT "\",\"" JSONRPC_PARAMS "\":{\"" JSONRPC_ID "\":%d,\"chunks\":%d}}"), Id, Chunks));
+}
+
+/** Streams */
+
+void UJsonMessageDispatcher::StartResponseStream(int32 Id, const FJsonRpcRequestHandler& Handler, const TSharedPtr<FJsonValue>& Params, const TScriptInterface<IMessageSender>& MessageSender)
+{
+    FJsonRpcChunkProducer Producer;
+    try
+    {
+        Producer = Handler.StreamAction(Params);
+    }
+    catch (FString& e)
+    {
+        SendJsonMessage(this, MessageSender, MakeErrorJson(Id, e));
+        return;
+    }
+    catch (std::exception& e)
+    {
+        SendJsonMessage(this, MessageSender, MakeErrorJson(Id, e.what()));
+        return;
+    }
+
+    if (!Producer)
+    {
+        SendMessageIfBound(this, MessageSender, MakeSerializedResultMessage(Id, TEXT("null")));
+        return;
+    }
+
+    TSharedPtr<FJsonRpcResponseStream> Stream = MakeShared<FJsonRpcResponseStream>();
+    Stream->Id = Id;
+    Stream->MessageSender = MessageSender.GetObject();
+    Stream->Producer = MoveTemp(Producer);
+    const IMessageSender* Sender = MessageSender.GetInterface();
+    Stream->bChunked = Sender == nullptr || Sender->CanStreamResponses();
+
+    // The first chunks go out right away, the rest as the connection drains
+    if (PumpResponseStream(*Stream))
+    {
+        ResponseStreams.Add(Stream);
+        ObserveSender(MessageSender);
+        StartTicking();
+    }
+}
+
+void UJsonMessageDispatcher::HandleStreamCredit(const TSharedPtr<FJsonValue>& Params, const TScriptInterface<IMessageSender>& MessageSender)
+{
+    const TSharedPtr<FJsonObject>* Credit;
+    int32 Id, Chunks;
+    if (!Params.IsValid() || !Params->TryGetObject(Credit) || !(*Credit)->TryGetNumberField(TEXT(JSONRPC_ID), Id)
+        || !(*Credit)->TryGetNumberField(TEXT("chunks"), Chunks) || Chunks <= 0)
+        return;
+
+    // Credits for a stream that already ended are dropped
+    UObject* Object = MessageSender.GetObject();
+    for (const TSharedPtr<FJsonRpcResponseStream>& Stream : ResponseStreams)
+    {
+        if (Stream->Id == Id && Stream->MessageSender == Object)
+        {
+            Stream->bCredited = true;
+            Stream->GrantedChunks += Chunks;
+            return;
+        }
+    }
+}
+
+void UJsonMessageDispatcher::PumpResponseStreams()
+{
+    // Held by value, producers may start or end streams
+    const TArray<TSharedPtr<FJsonRpcResponseStream>> Streams = ResponseStreams;
+    for (const TSharedPtr<FJsonRpcResponseStream>& Stream : Streams)
+    {
+        if (!PumpResponseStream(*Stream))
+            ResponseStreams.Remove(Stream);
+    }
+}
+
+bool UJsonMessageDispatcher::PumpResponseStream(FJsonRpcResponseStream& Stream)
+{
+    UObject* Object = Stream.MessageSender.Get();
+    if (!IsValid(Object))
+    {
+        INC_DWORD_STAT(STAT_WebApiServer_StreamsDropped);
+        return false;
+    }
+
+    const TScriptInterface<IMessageSender> MessageSender(Object);
+    const IMessageSender* Sender = MessageSender.GetInterface();
+
+    // Collected streams are capped too, the producer can be as expensive for them
+    for (int32 Produced = 0; Produced < FMath::Max(MaxStreamChunksPerTick, 1); ++Produced)
+    {
+        const bool bOutOfCredits = Stream.bCredited && Stream.SentChunks >= Stream.GrantedChunks;
+        if (Stream.bChunked && (bOutOfCredits || (Sender != nullptr && Sender->GetPendingSendBytes() >= StreamSendWindow)))
+        {
+            INC_DWORD_STAT(STAT_WebApiServer_StreamStalls);
+            return true;
+        }
+
+        TSharedPtr<FJsonValue> Chunk;
+        FString Error;
+        bool bHasChunk;
+        try
+        {
+            bHasChunk = Stream.Producer(Chunk, Error);
+        }
+        catch (FString& e)
+        {
+            bHasChunk = false;
+            Error = e;
+        }
+        catch (std::exception& e)
+        {
+            bHasChunk = false;
+            Error = e.what();
+        }
+
+        if (!Chunk.IsValid())
+            Chunk = MakeShared<FJsonValueNull>();
+
+        if (!bHasChunk)
+        {
+            if (!Error.IsEmpty())
+            {
+                SendJsonMessage(this, MessageSender, MakeErrorJson(Stream.Id, Error));
+            }
+            else if (Stream.bChunked)
+            {
+                SendMessageIfBound(this, MessageSender, MakeSerializedResultMessage(Stream.Id, TEXT("null")));
+            }
+            else
+            {
+                TSharedPtr<FJsonObject> JsonResponse = MakeShared<FJsonObject>();
+                JsonResponse->SetNumberField(TEXT(JSONRPC_ID), Stream.Id);
+                JsonResponse->SetArrayField(TEXT(JSONRPC_RESULT), Stream.Chunks);
+                SendJsonMessage(this, MessageSender, JsonResponse);
+            }
+            return false;
+        }
+
+        if (!Stream.bChunked)
+        {
+            Stream.Chunks.Add(Chunk);
+            continue;
+        }
+
+        FString SerializedChunk;
+        if (!SerializeJsonValue(Chunk, SerializedChunk))
+        {
+            SendJsonMessage(this, MessageSender, MakeErrorJson(Stream.Id, TEXT("internal_serialization_error")));
+            return false;
+        }
+
+        INC_DWORD_STAT(STAT_WebApiServer_StreamChunksSent);
+        ++Stream.SentChunks;
+        const FString Message = FString::Printf(TEXT("{\"" JSONRPC_ID "\":%d,\"" JSONRPC_CHUNK "\":%s}"), Stream.Id, *SerializedChunk);
+        if (!SendMessageIfBound(this, MessageSender, Message))
+        {
+            INC_DWORD_STAT(STAT_WebApiServer_StreamsDropped);
+            return false;
+        }
+    }
+    return true;
+}
+
+void UJsonMessageDispatcher::Cleanup()
+{
+    for (auto It = ResponseHandlers.CreateIterator(); It; ++It)
+    {
+        if (!It->Value.IsValid())
+        {
+            It.RemoveCurrent();
+            continue;
+        }
+        if (It->Value->Timeout < FDateTime::UtcNow())
+        {
+            It->Value->CompletionHandler(false, nullptr, TEXT("timeout"));
+            It.RemoveCurrent();
+        }
+    }
+    const double Now = FPlatformTime::Seconds();
+    for (auto It = InFlightRequests.CreateIterator(); It; ++It)
+    {
+        if (Now - It->Value->StartTime < InFlightRequestTimeout)
+            continue;
+
+        // Waiters are answered by the handler if it completes later, the entry just stops collecting new ones
+        It.RemoveCurrent();
+    }
+    ExpireBulkheadQueues();
+    for (auto It = ClientAdmissions.CreateIterator(); It; ++It)
+    {
+        if (!It->Value->Sender.IsValid())
+            It.RemoveCurrent();
+    }
+    for (auto It = ObservedSenders.CreateIterator(); It; ++It)
+    {
+        if (It->ResolveObjectPtr() == nullptr)
+            It.RemoveCurrent();
+    }
+    for (auto It = ShardSenders.CreateIterator(); It; ++It)
+    {
+        if (!It->Value->Object.IsValid())
+            It.RemoveCurrent();
+    }
+    for (auto It = NotificationHandlers.CreateIterator(); It; ++It)
+    {
+        if (!It->Value.IsEmpty())
+        {
+            It.RemoveCurrent();
+            bShardRegistryDirty = true;
+        }
+    }
+}
+
+/** Shards */
+
+/** Policies relying on request state owned by the game thread */
+static bool RequiresGameThread(const FJsonRpcMethodPolicy* Policy)
+{
+    return Policy != nullptr
+        && (Policy->bGameThreadBound || Policy->bCacheResponses || Policy->bCoalesceInFlight || Policy->RequestsPerSecondPerClient > 0.0f || Policy->MaxInFlight > 0);
+}
+
+static FString SerializeResponse(const TSharedPtr<FJsonObject>& JsonResponse)
+{
+    FString Response;
+    if (!SerializeJsonValue(MakeShared<FJsonValueObject>(JsonResponse), Response))
+        return TEXT("internal_serialization_error");
+    return Response;
+}
+
+void UJsonMessageDispatcher::StartShards(int32 NumShards)
+{
+    StopShards();
+
+    for (int32 Index = 0; Index < NumShards; ++Index)
+        Shards.Add(MakeUnique<FJsonRpcDispatcherShard>(Index));
+
+    bShardRegistryDirty = true;
+    if (!Shards.IsEmpty())
+        StartTicking();
+}
+
+void UJsonMessageDispatcher::StopShards()
+{
+    // Joins the threads
+    Shards.Empty();
+}
+
+void UJsonMessageDispatcher::RebuildShardRegistry()
+{
+    INC_DWORD_STAT(STAT_WebApiServer_ShardRegistryRebuilds);
+
+    TSharedPtr<FJsonRpcShardRegistry> Registry = MakeShared<FJsonRpcShardRegistry>();
+
+    for (const auto& Pair : RequestHandlers)
+    {
+        if (Pair.Value.IsValid() && !Pair.Value->bGameThreadBound && !Pair.Value->SerializedAction && !RequiresGameThread(MethodPolicies.Find(Pair.Key)))
+            Registry->RequestHandlers.Add(Pair.Key, Pair.Value);
+    }
+
+    for (const auto& Pair : NotificationHandlers)
+    {
+        const FJsonRpcMethodPolicy* Policy = MethodPolicies.Find(Pair.Key);
+        if (Policy != nullptr && Policy->bGameThreadBound)
+            continue;
+
+        // All or nothing, so the handlers of a method still run in registration order
+        const bool bAnyGameThreadBound = Pair.Value.ContainsByPredicate([](const TSharedPtr<FJsonRpcNotificationHandler>& Handler)
+        {
+            return Handler->bGameThreadBound;
+        });
+        if (!bAnyGameThreadBound)
+            Registry->NotificationHandlers.Add(Pair.Key, Pair.Value);
+    }
+
+    Registry->NotificationInterceptors = *NotificationInterceptors;
+
+    ShardRegistry = Registry;
+    bShardRegistryDirty = false;
+}
+
+void UJsonMessageDispatcher::DispatchToShard(const FString& Message, const TScriptInterface<IMessageSender>& MessageSender)
+{
+    if (bShardRegistryDirty || !ShardRegistry.IsValid())
+        RebuildShardRegistry();
+
+    // Connection affinity: all the messages of a sender go to the same shard
+    UObject* Object = MessageSender.GetObject();
+    const int32 ShardIndex = GetTypeHash(TObjectKey<UObject>(Object)) % static_cast<uint32>(Shards.Num());
+
+    if (MaxShardQueueLength > 0 && Shards[ShardIndex]->GetQueuedCount() >= MaxShardQueueLength)
+    {
+        INC_DWORD_STAT(STAT_WebApiServer_ShardQueueRejections);
+        SendMessageIfBound(this, MessageSender, ServerBusyMessage);
+        return;
+    }
+
+    INC_DWORD_STAT(STAT_WebApiServer_ShardedMessages);
+
+    TSharedPtr<FJsonRpcShardSender>& ShardSender = ShardSenders.FindOrAdd(Object);
+    if (!ShardSender.IsValid())
+    {
+        ShardSender = MakeShared<FJsonRpcShardSender>();
+        ShardSender->Object = Object;
+        ObserveSender(MessageSender);
+    }
+
+    // The pending requests of a sender are counted by the game thread, and interceptors are given the sender
+    const bool bRunRequests = MaxPendingRequestsPerClient <= 0 && RequestInterceptors->IsEmpty();
+
+    Shards[ShardIndex]->Enqueue([this, Registry = ShardRegistry, Message, Sender = ShardSender.ToSharedRef(), bRunRequests]()
+    {
+        HandleShardMessage(*Registry, Message, Sender, bRunRequests);
+    });
+}
+
+void UJsonMessageDispatcher::HandleShardMessage(const FJsonRpcShardRegistry& Registry, const FString& Message, const TSharedRef<FJsonRpcShardSender>& Sender, bool bRunRequests)
+{
+    TSharedPtr<FJsonValue> JsonValue;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Message);
+
+    if (!FJsonSerializer::Deserialize(Reader, JsonValue) || !JsonValue.IsValid())
+    {
+        QueueOutboundMessage(Sender->Object, TEXT("invalid_json"));
+        return;
+    }
+
+    // Batch: every element is handled as its own message
+    if (JsonValue->Type == EJson::Array)
+    {
+        for (const TSharedPtr<FJsonValue>& Element : JsonValue->AsArray())
+        {
+            const TSharedPtr<FJsonObject>* ElementObject;
+            if (Element.IsValid() && Element->TryGetObject(ElementObject) && ElementObject->IsValid())
+                HandleShardJsonMessage(Registry, *ElementObject, Sender, bRunRequests, Message.Len());
+        }
+        return;
+    }
+
+    const TSharedPtr<FJsonObject>* JsonMessage;
+    if (!JsonValue->TryGetObject(JsonMessage) || !JsonMessage->IsValid())
+    {
+        QueueOutboundMessage(Sender->Object, TEXT("invalid_json"));
+        return;
+    }
+
+    HandleShardJsonMessage(Registry, *JsonMessage, Sender, bRunRequests, Message.Len());
+}
+
+void UJsonMessageDispatcher::HandleShardJsonMessage(const FJsonRpcShardRegistry& Registry, const TSharedPtr<FJsonObject>& JsonMessage, const TSharedRef<FJsonRpcShardSender>& Sender, bool bRunRequests, int32 MessageSize)
+{
+    int32 Id;
+    bool bHasId = JsonMessage->TryGetNumberField(TEXT(JSONRPC_ID), Id);
+
+    FString Method;
+    bool bHasMethod = JsonMessage->TryGetStringField(TEXT(JSONRPC_METHOD), Method);
+
+    // Messages following one handed back to the game thread can't overtake it
+    const bool bInOrder = Sender->DeferredCount.load(std::memory_order_acquire) == 0;
+
+    if (bInOrder && bHasMethod && bHasId && bRunRequests)
+    {
+        if (const TSharedPtr<FJsonRpcRequestHandler>* Handler = Registry.RequestHandlers.Find(Method))
+        {
+            // Handlers may complete on any thread after the shards stopped, the responses go through the shared queue
+            const FJsonRpcIncomingParams Params(JsonMessage->TryGetField(TEXT(JSONRPC_PARAMS)));
+            InvokeRequestHandler(**Handler, Params,
+                [Outbound = OutboundQueue, Id, MessageSender = Sender->Object](const TSharedPtr<FJsonValue>& Result)
+                {
+                    TSharedPtr<FJsonObject> JsonResponse = MakeShared<FJsonObject>();
+                    JsonResponse->SetNumberField(TEXT(JSONRPC_ID), Id);
+                    JsonResponse->SetField(TEXT(JSONRPC_RESULT), Result != nullptr ? Result : MakeShared<FJsonValueNull>());
+                    Outbound->Enqueue(FJsonRpcOutboundMessage{MessageSender, SerializeResponse(JsonResponse)});
+                },
+                [Outbound = OutboundQueue, Id, MessageSender = Sender->Object](const FString& Error)
+                {
+                    Outbound->Enqueue(FJsonRpcOutboundMessage{MessageSender, SerializeResponse(MakeErrorJson(Id, Error))});
+                });
+            return;
+        }
+    }
+    else if (bInOrder && bHasMethod && !bHasId)
+    {
+        if (const TArray<TSharedPtr<FJsonRpcNotificationHandler>>* Handlers = Registry.NotificationHandlers.Find(Method))
+        {
+            const FJsonRpcIncomingParams Params(JsonMessage->TryGetField(TEXT(JSONRPC_PARAMS)));
+            if (!Registry.NotificationInterceptors.IsEmpty() && !RunNotificationInterceptors(Registry.NotificationInterceptors, Method, Params.GetValue()))
+                return;
+
+            for (const auto& Handler : *Handlers)
+            {
+                if (Handler->CompactAction)
+                    Handler->CompactAction(Params.GetView());
+                else
+                    Handler->Action(Params.GetValue());
+            }
+            return;
+        }
+    }
+
+    // Responses, unknown methods, methods bound to the game thread and the messages queued behind them
+    INC_DWORD_STAT(STAT_WebApiServer_ShardGameThreadMessages);
+    Sender->DeferredCount.fetch_add(1, std::memory_order_relaxed);
+    InboundQueue.Enqueue(FJsonRpcInboundMessage{JsonMessage, Sender->Object, Sender, MessageSize});
+}
+
+void UJsonMessageDispatcher::QueueOutboundMessage(const TWeakObjectPtr<UObject>& MessageSender, FString&& Message)
+{
+    FJsonRpcOutboundMessage Outbound;
+    Outbound.MessageSender = MessageSender;
+    Outbound.Message = MoveTemp(Message);
+    OutboundQueue->Enqueue(MoveTemp(Outbound));
+}
+
+void UJsonMessageDispatcher::FlushInboundQueue()
+{
+    FJsonRpcInboundMessage Inbound;
+    while (InboundQueue.Dequeue(Inbound))
+    {
+        const TScriptInterface<IMessageSender> MessageSender(Inbound.MessageSender.Get());
+
+        // Released once handled, or for requests once their handler completes
+        const TSharedPtr<FJsonRpcDeferredMessage> Deferred = MakeShared<FJsonRpcDeferredMessage>(Inbound.ShardSender);
+        TGuardValue<int32> MessageSize(HandledMessageSize, Inbound.MessageSize);
+
+        int32 Id;
+        FString Method;
+        if (Inbound.Message->TryGetNumberField(TEXT(JSONRPC_ID), Id) && Inbound.Message->TryGetStringField(TEXT(JSONRPC_METHOD), Method))
+            HandleRequest(Id, Method, FJsonRpcIncomingParams(Inbound.Message->TryGetField(TEXT(JSONRPC_PARAMS))), MessageSender, Deferred);
+        else
+            HandleJsonMessage(Inbound.Message, MessageSender);
     }
 }
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Dispatcher/JsonRpcDispatcherShard.h"
+
+#include "HAL/Event.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+
+FJsonRpcDispatcherShard::FJsonRpcDispatcherShard(int32 InIndex)
+    : Index(InIndex)
+{
+    WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("JsonRpcDispatcherShard%d"), Index), 0, TPri_Normal);
+}
+
+FJsonRpcDispatcherShard::~FJsonRpcDispatcherShard()
+{
+    if (Thread != nullptr)
+    {
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+    WorkEvent = nullptr;
+}
+
+void FJsonRpcDispatcherShard::Enqueue(TUniqueFunction<void ()>&& Work)
+{
+    QueuedCount.fetch_add(1, std::memory_order_relaxed);
+    Queue.Enqueue(MoveTemp(Work));
+    WorkEvent->Trigger();
+}
+
+uint32 FJsonRpcDispatcherShard::Run()
+{
+    while (!bStopping.load(std::memory_order_relaxed))
+    {
+        TUniqueFunction<void ()> Work;
+        while (!bStopping.load(std::memory_order_relaxed) && Queue.Dequeue(Work))
+        {
+            QueuedCount.fetch_sub(1, std::memory_order_relaxed);
+            Work();
+        }
+
+        // Auto reset event, a trigger from an Enqueue racing with the dequeue loop isn't lost
+        WorkEvent->Wait();
+    }
+    return 0;
+}
+
+void FJsonRpcDispatcherShard::Stop()
+{
+    bStopping = true;
+    WorkEvent->Trigger();
+}
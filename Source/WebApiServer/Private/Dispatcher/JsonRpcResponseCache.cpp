@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Dispatcher/JsonRpcResponseCache.h"
+
+#include "Dom/JsonObject.h"
+
+FJsonRpcRequestKey::FJsonRpcRequestKey(const FString& InMethod, const TSharedPtr<FJsonValue>& InParams)
+    : Method(InMethod)
+    , Params(InParams)
+    , Hash(HashCombine(FCrc::StrCrc32(*InMethod), HashJsonValue(InParams)))
+{
+}
+
+bool FJsonRpcRequestKey::operator==(const FJsonRpcRequestKey& Other) const
+{
+    if (Hash != Other.Hash || !Method.Equals(Other.Method, ESearchCase::CaseSensitive))
+        return false;
+
+    if (!Params.IsValid() || !Other.Params.IsValid())
+        return Params.IsValid() == Other.Params.IsValid();
+
+    return FJsonValue::CompareEqual(*Params, *Other.Params);
+}
+
+uint32 FJsonRpcRequestKey::HashJsonValue(const TSharedPtr<FJsonValue>& Value)
+{
+    if (!Value.IsValid())
+        return 0;
+
+    switch (Value->Type)
+    {
+    case EJson::Null:
+        return 1;
+    case EJson::Boolean:
+        return Value->AsBool() ? 3 : 2;
+    case EJson::Number:
+        return GetTypeHash(Value->AsNumber());
+    case EJson::String:
+        return FCrc::StrCrc32(*Value->AsString());
+    case EJson::Array:
+        {
+            uint32 Hash = 4;
+            for (const TSharedPtr<FJsonValue>& Element : Value->AsArray())
+                Hash = HashCombine(Hash, HashJsonValue(Element));
+            return Hash;
+        }
+    case EJson::Object:
+        {
+            // Members are summed so the hash doesn't depend on their order
+            uint32 Sum = 0;
+            const TSharedPtr<FJsonObject>& Object = Value->AsObject();
+            if (Object.IsValid())
+            {
+                for (const auto& [Name, Member] : Object->Values)
+                    Sum += HashCombine(FCrc::StrCrc32(*Name), HashJsonValue(Member));
+            }
+            return HashCombine(5, Sum);
+        }
+    default:
+        return 0;
+    }
+}
+
+SIZE_T FJsonRpcRequestKey::GetJsonValueSize(const TSharedPtr<FJsonValue>& Value)
+{
+    if (!Value.IsValid())
+        return 0;
+
+    switch (Value->Type)
+    {
+    case EJson::String:
+        return sizeof(FJsonValueString) + Value->AsString().Len() * sizeof(TCHAR);
+    case EJson::Array:
+        {
+            const TArray<TSharedPtr<FJsonValue>>& Elements = Value->AsArray();
+            SIZE_T Size = sizeof(FJsonValueArray) + Elements.GetAllocatedSize();
+            for (const TSharedPtr<FJsonValue>& Element : Elements)
+                Size += GetJsonValueSize(Element);
+            return Size;
+        }
+    case EJson::Object:
+        {
+            SIZE_T Size = sizeof(FJsonValueObject) + sizeof(FJsonObject);
+            const TSharedPtr<FJsonObject>& Object = Value->AsObject();
+            if (Object.IsValid())
+            {
+                Size += Object->Values.GetAllocatedSize();
+                for (const auto& [Name, Member] : Object->Values)
+                    Size += Name.Len() * sizeof(TCHAR) + GetJsonValueSize(Member);
+            }
+            return Size;
+        }
+    default:
+        return sizeof(FJsonValueNumber);
+    }
+}
+
+FJsonRpcResponseCache::~FJsonRpcResponseCache()
+{
+    Reset();
+}
+
+const FString* FJsonRpcResponseCache::Find(const FJsonRpcRequestKey& Key, double Now)
+{
+    FEntryNode** NodePtr = Index.Find(Key);
+    if (NodePtr == nullptr)
+        return nullptr;
+
+    FEntryNode* Node = *NodePtr;
+    if (Node->GetValue().ExpireTime <= Now)
+    {
+        Remove(Node);
+        return nullptr;
+    }
+
+    // Move to the front of the recency list
+    Entries.RemoveNode(Node, false);
+    Entries.AddHead(Node);
+    return &Node->GetValue().SerializedResult;
+}
+
+void FJsonRpcResponseCache::Add(const FJsonRpcRequestKey& Key, const FString& SerializedResult, double ExpireTime)
+{
+    if (FEntryNode** Existing = Index.Find(Key))
+        Remove(*Existing);
+
+    FEntry Entry;
+    Entry.Key = Key;
+    Entry.SerializedResult = SerializedResult;
+    Entry.ExpireTime = ExpireTime;
+    // Params are kept alive by the entry for as long as it lives, so they count as well
+    Entry.Size = sizeof(FEntry) + (Key.Method.Len() + SerializedResult.Len()) * sizeof(TCHAR) + FJsonRpcRequestKey::GetJsonValueSize(Key.Params);
+
+    if (Entry.Size > MaxBytes)
+        return;
+
+    while (UsedBytes + Entry.Size > MaxBytes && Entries.GetTail() != nullptr)
+        Remove(Entries.GetTail());
+
+    UsedBytes += Entry.Size;
+    Entries.AddHead(MoveTemp(Entry));
+    Index.Add(Key, Entries.GetHead());
+}
+
+void FJsonRpcResponseCache::Invalidate(const FString& Method)
+{
+    FEntryNode* Node = Entries.GetHead();
+    while (Node != nullptr)
+    {
+        FEntryNode* Next = Node->GetNextNode();
+        if (Node->GetValue().Key.Method.Equals(Method, ESearchCase::CaseSensitive))
+            Remove(Node);
+        Node = Next;
+    }
+}
+
+void FJsonRpcResponseCache::Reset()
+{
+    Index.Empty();
+    Entries.Empty();
+    UsedBytes = 0;
+}
+
+void FJsonRpcResponseCache::Remove(FEntryNode* Node)
+{
+    UsedBytes -= Node->GetValue().Size;
+    Index.Remove(Node->GetValue().Key);
+    Entries.RemoveNode(Node);
+}
@@ -0,0 +1,300 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Http/HttpJsonRpcEndpoint.h"
+
+#include "HttpPath.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "IPAddress.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+static const TCHAR* JsonContentType = TEXT("application/json");
+
+/** Answer to a batch element, or a whole batch, that is not a message object */
+static const TCHAR* InvalidRequestMessage = TEXT("{\"" JSONRPC_ID "\":null,\"" JSONRPC_ERROR "\":\"invalid_request\"}");
+
+/** Same answer the socket transports get for a message over MessagesPerSecondPerClient */
+static const TCHAR* RateLimitedMessage = TEXT("{\"" JSONRPC_ID "\":null,\"" JSONRPC_ERROR "\":\"rate_limited\"}");
+
+static constexpr int32 TooManyRequestsCode = 429;
+
+/** Seconds a peer is kept after its last body, on top of RequestTimeout */
+static constexpr double PeerIdleSeconds = 60.0;
+
+/** Exchange */
+
+bool UHttpJsonRpcExchange::SendMessage_Implementation(const FString& Message)
+{
+    if (bCompleted)
+        return false;
+
+    // Only answers to the requests of this body complete it, notifications pushed to every sender don't belong in the response
+    int32 Id;
+    if (!ResponseDocument.Parse(Message) || !ResponseDocument.GetRoot().Find(TEXT(JSONRPC_ID)).TryGetNumber(Id)
+        || PendingIds.RemoveSingleSwap(Id, EAllowShrinking::No) == 0)
+    {
+        UE_LOG(LogTemp, Verbose, TEXT("HttpJsonRpcExchange: Dropping message that answers no request of the body"));
+        return true;
+    }
+
+    Responses.Add(Message);
+    if (PendingIds.IsEmpty())
+        Complete();
+    return true;
+}
+
+void UHttpJsonRpcExchange::Complete()
+{
+    if (bCompleted)
+        return;
+    bCompleted = true;
+
+    TUniquePtr<FHttpServerResponse> Response;
+    if (Responses.IsEmpty())
+    {
+        // Only notifications in the body
+        Response = MakeUnique<FHttpServerResponse>();
+        Response->Code = EHttpServerResponseCodes::NoContent;
+    }
+    else if (!bBatch)
+    {
+        Response = FHttpServerResponse::Create(Responses[0], JsonContentType);
+    }
+    else
+    {
+        int32 BodyLength = 2;
+        for (const FString& Part : Responses)
+            BodyLength += Part.Len() + 1;
+
+        FString Body;
+        Body.Reserve(BodyLength);
+        Body += TEXT("[");
+        for (int32 Index = 0; Index < Responses.Num(); ++Index)
+        {
+            if (Index > 0)
+                Body += TEXT(",");
+            Body += Responses[Index];
+        }
+        Body += TEXT("]");
+        Response = FHttpServerResponse::Create(Body, JsonContentType);
+    }
+
+    Responses.Empty();
+    OnComplete(MoveTemp(Response));
+}
+
+void UHttpJsonRpcExchange::Fail(int32 StatusCode, const FString& Error)
+{
+    if (bCompleted)
+        return;
+    bCompleted = true;
+
+    TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(Error, TEXT("text/plain"));
+    Response->Code = static_cast<EHttpServerResponseCodes>(StatusCode);
+    OnComplete(MoveTemp(Response));
+}
+
+/** Endpoint */
+
+UHttpJsonRpcEndpoint::~UHttpJsonRpcEndpoint()
+{
+    StopEndpoint();
+}
+
+UHttpJsonRpcEndpoint* UHttpJsonRpcEndpoint::NewHttpJsonRpcEndpoint(UObject* Outer, UJsonMessageDispatcher* Dispatcher, int32 Port, const FString& Path)
+{
+    UHttpJsonRpcEndpoint* NewEndpoint = NewObject<UHttpJsonRpcEndpoint>(Outer);
+    NewEndpoint->StartEndpoint(Dispatcher, Port, Path);
+
+    return NewEndpoint;
+}
+
+bool UHttpJsonRpcEndpoint::StartEndpoint(UJsonMessageDispatcher* InDispatcher, int32 Port, const FString& Path)
+{
+    if (IsRunning() || !IsValid(InDispatcher))
+        return false;
+
+    FHttpServerModule& HttpServerModule = FHttpServerModule::Get();
+    Router = HttpServerModule.GetHttpRouter(Port, /* bFailOnBindFailure */ true);
+    if (!Router.IsValid())
+        return false;
+
+    RouteHandle = Router->BindRoute(FHttpPath(Path), EHttpServerRequestVerbs::VERB_POST,
+        FHttpRequestHandler::CreateUObject(this, &ThisClass::HandleHttpRequest));
+    if (!RouteHandle.IsValid())
+    {
+        Router.Reset();
+        return false;
+    }
+
+    Dispatcher = InDispatcher;
+    HttpPort = Port;
+    HttpPath = Path;
+    HttpServerModule.StartAllListeners();
+
+    TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick), 1.0f);
+    return true;
+}
+
+void UHttpJsonRpcEndpoint::StopEndpoint()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+
+    for (auto&& Exchange : PendingExchanges)
+    {
+        if (Exchange)
+            Exchange->Fail(static_cast<int32>(EHttpServerResponseCodes::ServiceUnavail), TEXT("endpoint_stopped"));
+    }
+    PendingExchanges.Empty();
+    Peers.Empty();
+
+    if (Router.IsValid() && RouteHandle.IsValid())
+        Router->UnbindRoute(RouteHandle);
+    RouteHandle.Reset();
+    Router.Reset();
+    Dispatcher = nullptr;
+}
+
+bool UHttpJsonRpcEndpoint::IsRunning() const
+{
+    return RouteHandle.IsValid();
+}
+
+/** Same test the dispatcher uses to decide a message expects a response */
+static bool IsJsonRpcRequest(const TSharedPtr<FJsonObject>& JsonMessage)
+{
+    int32 Id;
+    FString Method;
+    return JsonMessage->TryGetNumberField(TEXT(JSONRPC_ID), Id) && JsonMessage->TryGetStringField(TEXT(JSONRPC_METHOD), Method);
+}
+
+bool UHttpJsonRpcEndpoint::HandleHttpRequest(const FHttpServerRequest& Request, const FHttpJsonRpcResultCallback& OnComplete)
+{
+    if (!IsValid(Dispatcher))
+        return false;
+
+    FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Request.Body.GetData()), Request.Body.Num());
+    TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(FString(Converter.Length(), Converter.Get()));
+
+    TSharedPtr<FJsonValue> Body;
+    if (!FJsonSerializer::Deserialize(Reader, Body) || !Body.IsValid())
+    {
+        TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(TEXT("invalid_json"), TEXT("text/plain"));
+        Response->Code = EHttpServerResponseCodes::BadRequest;
+        OnComplete(MoveTemp(Response));
+        return true;
+    }
+
+    TArray<TSharedPtr<FJsonObject>> Messages;
+    int32 InvalidElements = 0;
+    const bool bBatch = Body->Type == EJson::Array;
+    if (bBatch)
+    {
+        const TArray<TSharedPtr<FJsonValue>>& Elements = Body->AsArray();
+        Messages.Reserve(Elements.Num());
+        for (const TSharedPtr<FJsonValue>& Element : Elements)
+        {
+            const TSharedPtr<FJsonObject>* ElementObject;
+            if (Element.IsValid() && Element->TryGetObject(ElementObject) && ElementObject->IsValid())
+                Messages.Add(*ElementObject);
+            else
+                ++InvalidElements;
+        }
+    }
+    else
+    {
+        const TSharedPtr<FJsonObject>* BodyObject;
+        if (Body->TryGetObject(BodyObject) && BodyObject->IsValid())
+            Messages.Add(*BodyObject);
+    }
+
+    // An empty batch or a body that is not a message at all gets a single error
+    if (Messages.IsEmpty() && InvalidElements == 0)
+    {
+        TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(InvalidRequestMessage, JsonContentType);
+        Response->Code = EHttpServerResponseCodes::BadRequest;
+        OnComplete(MoveTemp(Response));
+        return true;
+    }
+
+    const FString PeerAddress = Request.PeerAddress.IsValid() ? Request.PeerAddress->ToString(false) : FString();
+    TObjectPtr<UHttpJsonRpcPeer>& Peer = Peers.FindOrAdd(PeerAddress);
+    if (Peer == nullptr)
+        Peer = NewObject<UHttpJsonRpcPeer>(this);
+    Peer->LastRequestTime = FDateTime::UtcNow();
+
+    UHttpJsonRpcExchange* Exchange = NewObject<UHttpJsonRpcExchange>(this);
+    Exchange->Peer = Peer;
+
+    // Charged like a message from a socket, one token per batch element
+    if (!Dispatcher->AdmitMessages(TScriptInterface<IMessageSender>(Exchange), Messages.Num() + InvalidElements))
+    {
+        TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(RateLimitedMessage, JsonContentType);
+        Response->Code = static_cast<EHttpServerResponseCodes>(TooManyRequestsCode);
+        OnComplete(MoveTemp(Response));
+        return true;
+    }
+
+    Exchange->OnComplete = OnComplete;
+    Exchange->bBatch = bBatch;
+    Exchange->Deadline = FDateTime::UtcNow() + FTimespan::FromSeconds(RequestTimeout);
+    for (int32 Index = 0; Index < InvalidElements; ++Index)
+        Exchange->Responses.Add(InvalidRequestMessage);
+    for (const TSharedPtr<FJsonObject>& Message : Messages)
+    {
+        int32 Id;
+        if (IsJsonRpcRequest(Message) && Message->TryGetNumberField(TEXT(JSONRPC_ID), Id))
+            Exchange->PendingIds.Add(Id);
+    }
+
+    // Kept alive until the async handlers answer
+    PendingExchanges.Add(Exchange);
+
+    TScriptInterface<IMessageSender> MessageSender(Exchange);
+    for (const TSharedPtr<FJsonObject>& Message : Messages)
+        Dispatcher->HandleJsonMessage(Message, MessageSender);
+
+    if (Exchange->PendingIds.IsEmpty())
+        Exchange->Complete();
+
+    if (Exchange->IsCompleted())
+        PendingExchanges.Remove(Exchange);
+
+    return true;
+}
+
+bool UHttpJsonRpcEndpoint::Tick(float DeltaTime)
+{
+    const FDateTime Now = FDateTime::UtcNow();
+    for (auto It = PendingExchanges.CreateIterator(); It; ++It)
+    {
+        UHttpJsonRpcExchange* Exchange = *It;
+        if (Exchange == nullptr)
+        {
+            It.RemoveCurrent();
+            continue;
+        }
+
+        if (!Exchange->IsCompleted() && Exchange->IsExpired(Now))
+            Exchange->Fail(static_cast<int32>(EHttpServerResponseCodes::GatewayTimeout), TEXT("timeout"));
+
+        if (Exchange->IsCompleted())
+            It.RemoveCurrent();
+    }
+
+    // Kept while one of their exchanges may still be pending, so its pending requests stay counted on the same peer
+    const FTimespan PeerTimeout = FTimespan::FromSeconds(RequestTimeout + PeerIdleSeconds);
+    for (auto It = Peers.CreateIterator(); It; ++It)
+    {
+        if (It->Value == nullptr || Now - It->Value->LastRequestTime > PeerTimeout)
+            It.RemoveCurrent();
+    }
+    return true;
+}
@@ -0,0 +1,646 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Json/JsonArenaDocument.h"
+
+#include "Dom/JsonObject.h"
+
+/** Nesting deeper than this is rejected rather than risking the stack */
+static constexpr int32 JsonArenaMaxDepth = 512;
+
+/** Document */
+
+int32 FJsonArenaDocument::AddNode(EJsonArenaType Type, int32 KeyOffset, int32 KeyLength)
+{
+    const int32 Index = Nodes.AddDefaulted();
+    FNode& Node = Nodes[Index];
+    Node.Type = Type;
+    Node.KeyOffset = KeyOffset;
+    Node.KeyLength = KeyLength;
+    Node.End = Index + 1;
+    return Index;
+}
+
+int32 FJsonArenaDocument::AddString(FStringView Value)
+{
+    const int32 Offset = Strings.Num();
+    Strings.Append(Value.GetData(), Value.Len());
+    return Offset;
+}
+
+void FJsonArenaDocument::Reset()
+{
+    Nodes.Reset();
+    Strings.Reset();
+}
+
+FJsonArenaView FJsonArenaDocument::GetRoot() const
+{
+    if (Nodes.IsEmpty())
+        return FJsonArenaView();
+    return FJsonArenaView(this, 0);
+}
+
+void FJsonArenaDocument::Build(const TSharedPtr<FJsonValue>& Value)
+{
+    Reset();
+    BuildValue(Value, 0, 0);
+}
+
+void FJsonArenaDocument::BuildValue(const TSharedPtr<FJsonValue>& Value, int32 KeyOffset, int32 KeyLength)
+{
+    if (!Value.IsValid())
+    {
+        AddNode(EJsonArenaType::Null, KeyOffset, KeyLength);
+        return;
+    }
+
+    int32 Index;
+    switch (Value->Type)
+    {
+    case EJson::Boolean:
+        Index = AddNode(EJsonArenaType::Boolean, KeyOffset, KeyLength);
+        Nodes[Index].bBoolean = Value->AsBool();
+        return;
+    case EJson::Number:
+        Index = AddNode(EJsonArenaType::Number, KeyOffset, KeyLength);
+        Nodes[Index].Number = Value->AsNumber();
+        return;
+    case EJson::String:
+        {
+            const FString String = Value->AsString();
+            Index = AddNode(EJsonArenaType::String, KeyOffset, KeyLength);
+            Nodes[Index].StringOffset = AddString(String);
+            Nodes[Index].Count = String.Len();
+        }
+        return;
+    case EJson::Array:
+        {
+            Index = AddNode(EJsonArenaType::Array, KeyOffset, KeyLength);
+            const TArray<TSharedPtr<FJsonValue>>& Elements = Value->AsArray();
+            for (const TSharedPtr<FJsonValue>& Element : Elements)
+                BuildValue(Element, 0, 0);
+            Nodes[Index].Count = Elements.Num();
+            Nodes[Index].End = Nodes.Num();
+        }
+        return;
+    case EJson::Object:
+        {
+            Index = AddNode(EJsonArenaType::Object, KeyOffset, KeyLength);
+            const TSharedPtr<FJsonObject>& Object = Value->AsObject();
+            if (Object.IsValid())
+            {
+                for (const auto& [Name, Member] : Object->Values)
+                    BuildValue(Member, AddString(Name), Name.Len());
+                Nodes[Index].Count = Object->Values.Num();
+            }
+            Nodes[Index].End = Nodes.Num();
+        }
+        return;
+    default:
+        AddNode(EJsonArenaType::Null, KeyOffset, KeyLength);
+        return;
+    }
+}
+
+/** Parser */
+
+struct FJsonArenaParser
+{
+    FJsonArenaParser(FJsonArenaDocument& InDocument, FStringView Text)
+        : Document(InDocument)
+        , Cursor(Text.GetData())
+        , End(Text.GetData() + Text.Len())
+    {
+    }
+
+    FJsonArenaDocument& Document;
+    const TCHAR* Cursor;
+    const TCHAR* End;
+    int32 Depth = 0;
+
+    void SkipWhitespace()
+    {
+        while (Cursor < End && (*Cursor == ' ' || *Cursor == '\t' || *Cursor == '\n' || *Cursor == '\r'))
+            ++Cursor;
+    }
+
+    bool ConsumeLiteral(const TCHAR* Literal, int32 Length)
+    {
+        if (End - Cursor < Length || FCString::Strncmp(Cursor, Literal, Length) != 0)
+            return false;
+        Cursor += Length;
+        return true;
+    }
+
+    static int32 HexValue(TCHAR Character)
+    {
+        if (Character >= '0' && Character <= '9')
+            return Character - '0';
+        if (Character >= 'a' && Character <= 'f')
+            return Character - 'a' + 10;
+        if (Character >= 'A' && Character <= 'F')
+            return Character - 'A' + 10;
+        return -1;
+    }
+
+    bool ParseHex4(uint32& OutCodeUnit)
+    {
+        if (End - Cursor < 4)
+            return false;
+        OutCodeUnit = 0;
+        for (int32 i = 0; i < 4; ++i)
+        {
+            const int32 Digit = HexValue(*Cursor++);
+            if (Digit < 0)
+                return false;
+            OutCodeUnit = (OutCodeUnit << 4) | Digit;
+        }
+        return true;
+    }
+
+    void AppendCodePoint(uint32 CodePoint)
+    {
+        TArray<TCHAR>& Strings = Document.Strings;
+        if (sizeof(TCHAR) >= 4 || CodePoint < 0x10000)
+        {
+            Strings.Add(static_cast<TCHAR>(CodePoint));
+        }
+        else
+        {
+            CodePoint -= 0x10000;
+            Strings.Add(static_cast<TCHAR>(0xD800 + (CodePoint >> 10)));
+            Strings.Add(static_cast<TCHAR>(0xDC00 + (CodePoint & 0x3FF)));
+        }
+    }
+
+    /** Cursor is on the opening quote. Unescaped characters are appended to the string pool. */
+    bool ParseString(int32& OutOffset, int32& OutLength)
+    {
+        TArray<TCHAR>& Strings = Document.Strings;
+        OutOffset = Strings.Num();
+        ++Cursor;
+
+        for (;;)
+        {
+            // Copy the run of plain characters in one go
+            const TCHAR* RunStart = Cursor;
+            while (Cursor < End && *Cursor != '"' && *Cursor != '\\')
+                ++Cursor;
+            if (Cursor > RunStart)
+                Strings.Append(RunStart, static_cast<int32>(Cursor - RunStart));
+
+            if (Cursor >= End)
+                return false;
+
+            if (*Cursor == '"')
+            {
+                ++Cursor;
+                OutLength = Strings.Num() - OutOffset;
+                return true;
+            }
+
+            // Escape sequence
+            if (++Cursor >= End)
+                return false;
+            switch (*Cursor++)
+            {
+            case '"': Strings.Add('"'); break;
+            case '\\': Strings.Add('\\'); break;
+            case '/': Strings.Add('/'); break;
+            case 'b': Strings.Add('\b'); break;
+            case 'f': Strings.Add('\f'); break;
+            case 'n': Strings.Add('\n'); break;
+            case 'r': Strings.Add('\r'); break;
+            case 't': Strings.Add('\t'); break;
+            case 'u':
+                {
+                    uint32 CodeUnit;
+                    if (!ParseHex4(CodeUnit))
+                        return false;
+
+                    // Join surrogate pairs
+                    uint32 LowSurrogate;
+                    if (CodeUnit >= 0xD800 && CodeUnit < 0xDC00 && End - Cursor >= 6 && Cursor[0] == '\\' && Cursor[1] == 'u')
+                    {
+                        const TCHAR* Saved = Cursor;
+                        Cursor += 2;
+                        if (ParseHex4(LowSurrogate) && LowSurrogate >= 0xDC00 && LowSurrogate < 0xE000)
+                        {
+                            AppendCodePoint(0x10000 + ((CodeUnit - 0xD800) << 10) + (LowSurrogate - 0xDC00));
+                            break;
+                        }
+                        Cursor = Saved;
+                    }
+                    AppendCodePoint(CodeUnit);
+                }
+                break;
+            default:
+                return false;
+            }
+        }
+    }
+
+    bool IsDigit() const
+    {
+        return Cursor < End && *Cursor >= '0' && *Cursor <= '9';
+    }
+
+    bool SkipDigits()
+    {
+        if (!IsDigit())
+            return false;
+        while (IsDigit())
+            ++Cursor;
+        return true;
+    }
+
+    /** Exact json grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? */
+    bool ParseNumber(double& OutNumber)
+    {
+        const TCHAR* Start = Cursor;
+        if (Cursor < End && *Cursor == '-')
+            ++Cursor;
+
+        // No leading zeros
+        if (Cursor < End && *Cursor == '0')
+            ++Cursor;
+        else if (!SkipDigits())
+            return false;
+
+        if (Cursor < End && *Cursor == '.')
+        {
+            ++Cursor;
+            if (!SkipDigits())
+                return false;
+        }
+
+        if (Cursor < End && (*Cursor == 'e' || *Cursor == 'E'))
+        {
+            ++Cursor;
+            if (Cursor < End && (*Cursor == '+' || *Cursor == '-'))
+                ++Cursor;
+            if (!SkipDigits())
+                return false;
+        }
+
+        const int32 Length = static_cast<int32>(Cursor - Start);
+        TCHAR Buffer[64];
+        if (Length >= UE_ARRAY_COUNT(Buffer))
+        {
+            // Long but valid numbers are rare, don't let them fail the message
+            OutNumber = FCString::Atod(*FString(Length, Start));
+            return true;
+        }
+
+        FMemory::Memcpy(Buffer, Start, Length * sizeof(TCHAR));
+        Buffer[Length] = '\0';
+        OutNumber = FCString::Atod(Buffer);
+        return true;
+    }
+
+    bool ParseValue(int32 KeyOffset, int32 KeyLength)
+    {
+        SkipWhitespace();
+        if (Cursor >= End)
+            return false;
+
+        TArray<FJsonArenaDocument::FNode>& Nodes = Document.Nodes;
+        int32 Index;
+        switch (*Cursor)
+        {
+        case '{':
+            {
+                if (++Depth > JsonArenaMaxDepth)
+                    return false;
+                Index = Document.AddNode(EJsonArenaType::Object, KeyOffset, KeyLength);
+                ++Cursor;
+                int32 Count = 0;
+                SkipWhitespace();
+                if (Cursor < End && *Cursor == '}')
+                {
+                    ++Cursor;
+                }
+                else
+                {
+                    for (;;)
+                    {
+                        SkipWhitespace();
+                        if (Cursor >= End || *Cursor != '"')
+                            return false;
+                        int32 MemberKeyOffset, MemberKeyLength;
+                        if (!ParseString(MemberKeyOffset, MemberKeyLength))
+                            return false;
+                        SkipWhitespace();
+                        if (Cursor >= End || *Cursor++ != ':')
+                            return false;
+                        if (!ParseValue(MemberKeyOffset, MemberKeyLength))
+                            return false;
+                        ++Count;
+                        SkipWhitespace();
+                        if (Cursor >= End)
+                            return false;
+                        if (*Cursor == ',')
+                        {
+                            ++Cursor;
+                            continue;
+                        }
+                        if (*Cursor++ == '}')
+                            break;
+                        return false;
+                    }
+                }
+                Nodes[Index].Count = Count;
+                Nodes[Index].End = Nodes.Num();
+                --Depth;
+            }
+            return true;
+        case '[':
+            {
+                if (++Depth > JsonArenaMaxDepth)
+                    return false;
+                Index = Document.AddNode(EJsonArenaType::Array, KeyOffset, KeyLength);
+                ++Cursor;
+                int32 Count = 0;
+                SkipWhitespace();
+                if (Cursor < End && *Cursor == ']')
+                {
+                    ++Cursor;
+                }
+                else
+                {
+                    for (;;)
+                    {
+                        if (!ParseValue(0, 0))
+                            return false;
+                        ++Count;
+                        SkipWhitespace();
+                        if (Cursor >= End)
+                            return false;
+                        if (*Cursor == ',')
+                        {
+                            ++Cursor;
+                            continue;
+                        }
+                        if (*Cursor++ == ']')
+                            break;
+                        return false;
+                    }
+                }
+                Nodes[Index].Count = Count;
+                Nodes[Index].End = Nodes.Num();
+                --Depth;
+            }
+            return true;
+        case '"':
+            {
+                Index = Document.AddNode(EJsonArenaType::String, KeyOffset, KeyLength);
+                int32 StringOffset, StringLength;
+                if (!ParseString(StringOffset, StringLength))
+                    return false;
+                Nodes[Index].StringOffset = StringOffset;
+                Nodes[Index].Count = StringLength;
+            }
+            return true;
+        case 't':
+            Index = Document.AddNode(EJsonArenaType::Boolean, KeyOffset, KeyLength);
+            Nodes[Index].bBoolean = true;
+            return ConsumeLiteral(TEXT("true"), 4);
+        case 'f':
+            Index = Document.AddNode(EJsonArenaType::Boolean, KeyOffset, KeyLength);
+            return ConsumeLiteral(TEXT("false"), 5);
+        case 'n':
+            Document.AddNode(EJsonArenaType::Null, KeyOffset, KeyLength);
+            return ConsumeLiteral(TEXT("null"), 4);
+        default:
+            {
+                Index = Document.AddNode(EJsonArenaType::Number, KeyOffset, KeyLength);
+                double Number;
+                if (!ParseNumber(Number))
+                    return false;
+                Nodes[Index].Number = Number;
+            }
+            return true;
+        }
+    }
+};
+
+bool FJsonArenaDocument::Parse(FStringView Text)
+{
+    Reset();
+
+    // Rough guess of the final size so a cold document grows at most a couple of times
+    Nodes.Reserve(FMath::Max(Nodes.Max(), Text.Len() / 8));
+    Strings.Reserve(FMath::Max(Strings.Max(), Text.Len() / 2));
+
+    FJsonArenaParser Parser(*this, Text);
+    if (!Parser.ParseValue(0, 0))
+    {
+        Reset();
+        return false;
+    }
+
+    Parser.SkipWhitespace();
+    if (Parser.Cursor != Parser.End)
+    {
+        Reset();
+        return false;
+    }
+    return true;
+}
+
+/** View */
+
+EJsonArenaType FJsonArenaView::GetType() const
+{
+    return IsValid() ? Document->Nodes[Index].Type : EJsonArenaType::Null;
+}
+
+bool FJsonArenaView::AsBool() const
+{
+    return GetType() == EJsonArenaType::Boolean && Document->Nodes[Index].bBoolean;
+}
+
+double FJsonArenaView::AsNumber() const
+{
+    return GetType() == EJsonArenaType::Number ? Document->Nodes[Index].Number : 0.0;
+}
+
+FStringView FJsonArenaView::AsString() const
+{
+    if (GetType() != EJsonArenaType::String)
+        return FStringView();
+
+    const FJsonArenaDocument::FNode& Node = Document->Nodes[Index];
+    return FStringView(Document->Strings.GetData() + Node.StringOffset, Node.Count);
+}
+
+bool FJsonArenaView::TryGetBool(bool& OutValue) const
+{
+    switch (GetType())
+    {
+    case EJsonArenaType::Boolean:
+        OutValue = Document->Nodes[Index].bBoolean;
+        return true;
+    case EJsonArenaType::Number:
+        OutValue = Document->Nodes[Index].Number != 0.0;
+        return true;
+    case EJsonArenaType::String:
+        OutValue = FString(AsString()).ToBool();
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool FJsonArenaView::TryGetNumber(double& OutValue) const
+{
+    switch (GetType())
+    {
+    case EJsonArenaType::Number:
+        OutValue = Document->Nodes[Index].Number;
+        return true;
+    case EJsonArenaType::Boolean:
+        OutValue = Document->Nodes[Index].bBoolean ? 1.0 : 0.0;
+        return true;
+    case EJsonArenaType::String:
+        {
+            const FString String(AsString());
+            if (!String.IsNumeric())
+                return false;
+            OutValue = FCString::Atod(*String);
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool FJsonArenaView::TryGetNumber(int32& OutValue) const
+{
+    double Number;
+    if (!TryGetNumber(Number))
+        return false;
+
+    const double Rounded = FMath::RoundHalfFromZero(Number);
+    if (Rounded < MIN_int32 || Rounded > MAX_int32)
+        return false;
+
+    OutValue = static_cast<int32>(Rounded);
+    return true;
+}
+
+bool FJsonArenaView::TryGetString(FString& OutValue) const
+{
+    switch (GetType())
+    {
+    case EJsonArenaType::String:
+        OutValue = FString(AsString());
+        return true;
+    case EJsonArenaType::Number:
+        OutValue = FString::SanitizeFloat(Document->Nodes[Index].Number, 0);
+        return true;
+    case EJsonArenaType::Boolean:
+        OutValue = Document->Nodes[Index].bBoolean ? TEXT("true") : TEXT("false");
+        return true;
+    default:
+        return false;
+    }
+}
+
+int32 FJsonArenaView::Num() const
+{
+    const EJsonArenaType Type = GetType();
+    if (Type != EJsonArenaType::Array && Type != EJsonArenaType::Object)
+        return 0;
+    return Document->Nodes[Index].Count;
+}
+
+int32 FJsonArenaView::GetSubtreeEnd(const FJsonArenaDocument* InDocument, int32 InIndex)
+{
+    return InDocument->Nodes[InIndex].End;
+}
+
+FJsonArenaView FJsonArenaView::operator[](int32 Position) const
+{
+    if (Position < 0 || Position >= Num())
+        return FJsonArenaView();
+
+    int32 Child = Index + 1;
+    for (int32 i = 0; i < Position; ++i)
+        Child = Document->Nodes[Child].End;
+    return FJsonArenaView(Document, Child);
+}
+
+FJsonArenaView FJsonArenaView::Find(FStringView Key) const
+{
+    if (GetType() != EJsonArenaType::Object)
+        return FJsonArenaView();
+
+    // Duplicate members resolve to the last one, as FJsonObject does
+    int32 Found = INDEX_NONE;
+    const int32 SubtreeEnd = Document->Nodes[Index].End;
+    for (int32 Child = Index + 1; Child < SubtreeEnd; Child = Document->Nodes[Child].End)
+    {
+        const FJsonArenaDocument::FNode& Node = Document->Nodes[Child];
+        if (Node.KeyLength == Key.Len() && FCString::Strncmp(Document->Strings.GetData() + Node.KeyOffset, Key.GetData(), Key.Len()) == 0)
+            Found = Child;
+    }
+    return Found != INDEX_NONE ? FJsonArenaView(Document, Found) : FJsonArenaView();
+}
+
+FStringView FJsonArenaView::GetKey() const
+{
+    if (!IsValid())
+        return FStringView();
+
+    const FJsonArenaDocument::FNode& Node = Document->Nodes[Index];
+    return FStringView(Document->Strings.GetData() + Node.KeyOffset, Node.KeyLength);
+}
+
+FJsonArenaView::FIterator& FJsonArenaView::FIterator::operator++()
+{
+    Index = FJsonArenaView::GetSubtreeEnd(Document, Index);
+    return *this;
+}
+
+FJsonArenaView::FIterator FJsonArenaView::begin() const
+{
+    return FIterator(Document, Num() > 0 ? Index + 1 : end().Index);
+}
+
+FJsonArenaView::FIterator FJsonArenaView::end() const
+{
+    return FIterator(Document, IsValid() ? Document->Nodes[Index].End : INDEX_NONE);
+}
+
+TSharedPtr<FJsonValue> FJsonArenaView::ToJsonValue() const
+{
+    switch (GetType())
+    {
+    case EJsonArenaType::Boolean:
+        return MakeShared<FJsonValueBoolean>(AsBool());
+    case EJsonArenaType::Number:
+        return MakeShared<FJsonValueNumber>(AsNumber());
+    case EJsonArenaType::String:
+        return MakeShared<FJsonValueString>(FString(AsString()));
+    case EJsonArenaType::Array:
+        {
+            TArray<TSharedPtr<FJsonValue>> Elements;
+            Elements.Reserve(Num());
+            for (const FJsonArenaView Element : *this)
+                Elements.Add(Element.ToJsonValue());
+            return MakeShared<FJsonValueArray>(Elements);
+        }
+    case EJsonArenaType::Object:
+        {
+            TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+            Object->Values.Reserve(Num());
+            for (const FJsonArenaView Member : *this)
+                Object->SetField(FString(Member.GetKey()), Member.ToJsonValue());
+            return MakeShared<FJsonValueObject>(Object);
+        }
+    default:
+        return IsValid() ? MakeShared<FJsonValueNull>() : nullptr;
+    }
+}
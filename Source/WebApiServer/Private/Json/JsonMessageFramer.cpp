@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Json/JsonMessageFramer.h"
+
+static void EmitUtf8Message(const uint8* Data, int32 Count, TFunctionRef<void (const FString&)> OnMessage)
+{
+    FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Data), Count);
+    OnMessage(FString(Converter.Length(), Converter.Get()));
+}
+
+static bool IsJsonWhitespace(uint8 Character)
+{
+    return Character == ' ' || Character == '\t' || Character == '\n' || Character == '\r';
+}
+
+EJsonFramerResult FJsonMessageFramer::Feed(const uint8* Data, int32 Count, TFunctionRef<void (const FString&)> OnMessage)
+{
+    EJsonFramerResult Result = EJsonFramerResult::Ok;
+
+    // Start of the current message in this fragment. A message continued from a previous fragment starts at 0.
+    int32 SegmentStart = 0;
+
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        const uint8 Character = Data[Index];
+
+        if (!bInMessage)
+        {
+            if (IsJsonWhitespace(Character))
+                continue;
+
+            if (Character != '{' && Character != '[')
+            {
+                // Not the start of a message, skip up to the next object or array so the messages behind it still get through
+                if (Result == EJsonFramerResult::Ok)
+                    Result = EJsonFramerResult::Skipped;
+                continue;
+            }
+
+            bInMessage = true;
+            bInString = false;
+            bEscaped = false;
+            bDiscarding = false;
+            Depth = 0;
+            SegmentStart = Index;
+        }
+
+        if (bInString)
+        {
+            if (bEscaped)
+                bEscaped = false;
+            else if (Character == '\\')
+                bEscaped = true;
+            else if (Character == '"')
+                bInString = false;
+            continue;
+        }
+
+        switch (Character)
+        {
+        case '"':
+            bInString = true;
+            break;
+        case '{':
+        case '[':
+            ++Depth;
+            break;
+        case '}':
+        case ']':
+            if (--Depth > 0)
+                break;
+
+            {
+                const int32 SegmentLength = Index + 1 - SegmentStart;
+                if (bDiscarding)
+                {
+                    // Tail of a message already reported as oversized
+                }
+                else if (Buffer.Num() + SegmentLength > MaxMessageSize)
+                {
+                    Result = EJsonFramerResult::Oversized;
+                }
+                else if (Buffer.IsEmpty())
+                {
+                    EmitUtf8Message(Data + SegmentStart, SegmentLength, OnMessage);
+                }
+                else
+                {
+                    Buffer.Append(Data + SegmentStart, SegmentLength);
+                    EmitUtf8Message(Buffer.GetData(), Buffer.Num(), OnMessage);
+                }
+            }
+            Buffer.Reset();
+            bInMessage = false;
+            bDiscarding = false;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (bInMessage && !bDiscarding)
+    {
+        const int32 TailLength = Count - SegmentStart;
+        if (Buffer.Num() + TailLength > MaxMessageSize)
+        {
+            // Skip the rest of this message without storing it
+            Buffer.Empty();
+            bDiscarding = true;
+            Result = EJsonFramerResult::Oversized;
+        }
+        else
+        {
+            Buffer.Append(Data + SegmentStart, TailLength);
+        }
+    }
+
+    return Result;
+}
+
+void FJsonMessageFramer::Reset()
+{
+    Buffer.Empty();
+    Depth = 0;
+    bInMessage = false;
+    bInString = false;
+    bEscaped = false;
+    bDiscarding = false;
+}
@@ -3,8 +3,55 @@
 
 #include "Json/JsonObjectWrapperType.h"
 
+#include "WebApiServerStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Json Wrapper Conversion"), STAT_WebApiServer_JsonWrapperConversion, STATGROUP_WebApiServer);
+
+/** Arrays up to this size use preformatted keys */
+static constexpr int32 CachedIndexKeyCount = 4096;
+
+/** Preformatted keys "0", "1", ... of the first CachedIndexKeyCount array elements */
+static const TArray<FString>& GetCachedIndexKeys()
+{
+    // Built once, read only afterwards so it can be shared between threads
+    static const TArray<FString> CachedKeys = []()
+    {
+        TArray<FString> Keys;
+        Keys.Reserve(CachedIndexKeyCount);
+        for (int32 i = 0; i < CachedIndexKeyCount; ++i)
+            Keys.Add(FString::FromInt(i));
+        return Keys;
+    }();
+
+    return CachedKeys;
+}
+
+/** Parse a key made only of decimal digits. Rejects signs, spaces and values that don't fit an int32. */
+static bool ParseIndexKey(const FString& Key, int32& OutIndex)
+{
+    const int32 Length = Key.Len();
+    if (Length == 0 || Length > 10)
+        return false;
+
+    int64 Index = 0;
+    for (const TCHAR Character : Key)
+    {
+        if (Character < '0' || Character > '9')
+            return false;
+        Index = Index * 10 + (Character - '0');
+    }
+
+    if (Index > MAX_int32)
+        return false;
+
+    OutIndex = static_cast<int32>(Index);
+    return true;
+}
+
 FJsonObjectWrapper ToJsonWrapper(const TSharedPtr<FJsonValue>& Value)
 {
+    SCOPE_CYCLE_COUNTER(STAT_WebApiServer_JsonWrapperConversion);
+
     if (!Value.IsValid())
         return FJsonObjectWrapper();
 
@@ -17,12 +64,16 @@ FJsonObjectWrapper ToJsonWrapper(const TSharedPtr<FJsonValue>& Value)
         case EJson::Array:
             JsonObject = MakeShared<FJsonObject>();
             {
-                TArray<TSharedPtr<FJsonValue>> JsonArray = Value->AsArray();
-                for (int32 Index = 0; Index < JsonArray.Num(); ++Index)
-                {
-                    FString Key = FString::FromInt(Index);
-                    JsonObject->SetField(Key, JsonArray[Index]);
-                }
+                const TArray<TSharedPtr<FJsonValue>>& JsonArray = Value->AsArray();
+                JsonObject->Values.Reserve(JsonArray.Num());
+
+                // Keys of the cached range are copied from the table, only the ones past it are formatted
+                const TArray<FString>& CachedKeys = GetCachedIndexKeys();
+                const int32 CachedCount = FMath::Min(JsonArray.Num(), CachedIndexKeyCount);
+                for (int32 Index = 0; Index < CachedCount; ++Index)
+                    JsonObject->Values.Add(CachedKeys[Index], JsonArray[Index]);
+                for (int32 Index = CachedCount; Index < JsonArray.Num(); ++Index)
+                    JsonObject->Values.Add(FString::FromInt(Index), JsonArray[Index]);
             }
             break;
         default:
@@ -37,6 +88,8 @@ FJsonObjectWrapper ToJsonWrapper(const TSharedPtr<FJsonValue>& Value)
 
 TSharedPtr<FJsonValue> FromJsonWrapper(const FJsonObjectWrapper& Wrapper, EJsonObjectWrapperType Type)
 {
+    SCOPE_CYCLE_COUNTER(STAT_WebApiServer_JsonWrapperConversion);
+
     switch (Type)
     {
         case EJsonObjectWrapperType::JOWT_Object:
@@ -44,25 +97,35 @@ TSharedPtr<FJsonValue> FromJsonWrapper(const FJsonObjectWrapper& Wrapper, EJsonO
         case EJsonObjectWrapperType::JOWT_Array:
             {
                 TArray<TSharedPtr<FJsonValue>> JsonArray;
-                for (const auto& Pair : Wrapper.JsonObject->Values)
+                if (!Wrapper.JsonObject.IsValid())
+                    return MakeShared<FJsonValueArray>(JsonArray);
+
+                // Keys are usually exactly 0..N-1, so size the array once and fix it up at the end if not
+                const TMap<FString, TSharedPtr<FJsonValue>>& Values = Wrapper.JsonObject->Values;
+                JsonArray.SetNum(Values.Num());
+                int32 Count = 0;
+                for (const auto& Pair : Values)
                 {
-                    if (Pair.Key.IsEmpty() || !Pair.Key.IsNumeric())
-                        continue;
-                    int32 Index = FCString::Atoi(*Pair.Key);
-                    if (Index < 0)
+                    int32 Index;
+                    if (!ParseIndexKey(Pair.Key, Index))
                         continue;
                     if (Index >= JsonArray.Num())
                         JsonArray.SetNum(Index + 1);
                     JsonArray[Index] = Pair.Value;
+                    Count = FMath::Max(Count, Index + 1);
                 }
-                for (int32 i = 0; i < JsonArray.Num(); i++)
+                JsonArray.SetNum(Count, EAllowShrinking::No);
+
+                for (TSharedPtr<FJsonValue>& Element : JsonArray)
                 {
-                    if (JsonArray[i] == nullptr)
-                        JsonArray[i] = MakeShared<FJsonValueNull>();
+                    if (Element == nullptr)
+                        Element = MakeShared<FJsonValueNull>();
                 }
-                return MakeShared<FJsonValueArray>(JsonArray);
+                return MakeShared<FJsonValueArray>(MoveTemp(JsonArray));
             }
         case EJsonObjectWrapperType::JOWT_Value:
+            if (!Wrapper.JsonObject.IsValid())
+                return nullptr;
             return Wrapper.JsonObject->TryGetField(TEXT("value"));
     }
     return nullptr;
@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Messaging/ClientInterestGrid.h"
+
+FClientInterestGrid::FClientInterestGrid(float InCellSize)
+    : CellSize(FMath::Max(InCellSize, 1.0f))
+{
+}
+
+/** Cell coordinate along one axis, kept one short of the int32 limits so loops over cells can't overflow */
+static int32 GetCellCoordinate(double Position, float CellSize)
+{
+    return static_cast<int32>(FMath::Clamp(FMath::FloorToDouble(Position / CellSize), static_cast<double>(MIN_int32 + 1), static_cast<double>(MAX_int32 - 1)));
+}
+
+FIntPoint FClientInterestGrid::GetCell(const FVector& Location) const
+{
+    return FIntPoint(GetCellCoordinate(Location.X, CellSize), GetCellCoordinate(Location.Y, CellSize));
+}
+
+bool FClientInterestGrid::Contains(const FInterest& Interest, const FVector& Location)
+{
+    return Interest.Radius > 0.0f && FVector::DistSquared(Interest.Center, Location) <= FMath::Square(Interest.Radius);
+}
+
+void FClientInterestGrid::SetInterest(UObject* Client, const FVector& Center, float Radius)
+{
+    if (Client == nullptr)
+        return;
+
+    const TObjectKey<UObject> Key(Client);
+    FInterest& Interest = Clients.FindOrAdd(Key);
+    Interest.Object = Client;
+
+    // A sphere wider than MaxCellsPerClient cells is oversized whatever its radius, clamping keeps huge radii from overflowing the cell range
+    const float IndexedRadius = FMath::Min(Radius, CellSize * FMath::Max(MaxCellsPerClient, 1));
+    const FIntPoint MinCell = GetCell(Center - FVector(IndexedRadius, IndexedRadius, 0.0f));
+    const FIntPoint MaxCell = GetCell(Center + FVector(IndexedRadius, IndexedRadius, 0.0f));
+    const int64 CellCount = (int64(MaxCell.X) - int64(MinCell.X) + 1) * (int64(MaxCell.Y) - int64(MinCell.Y) + 1);
+    const bool bOversized = Radius > 0.0f && (Radius > IndexedRadius || CellCount > MaxCellsPerClient);
+
+    // Moving within the same cells only needs the sphere updated
+    if (Radius > 0.0f && Interest.Radius > 0.0f && bOversized == Interest.bOversized
+        && (bOversized || (MinCell == Interest.MinCell && MaxCell == Interest.MaxCell)))
+    {
+        Interest.Center = Center;
+        Interest.Radius = Radius;
+        return;
+    }
+
+    UnlinkSpatial(Key, Interest);
+    Interest.Center = Center;
+    Interest.Radius = Radius;
+
+    if (Radius <= 0.0f)
+        return;
+
+    if (bOversized)
+    {
+        Interest.bOversized = true;
+        OversizedClients.Add(Key);
+        return;
+    }
+
+    Interest.MinCell = MinCell;
+    Interest.MaxCell = MaxCell;
+    for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+    {
+        for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+            Cells.FindOrAdd(FIntPoint(X, Y)).Add(Key);
+    }
+}
+
+void FClientInterestGrid::SetTags(UObject* Client, const TArray<FName>& Tags)
+{
+    if (Client == nullptr)
+        return;
+
+    const TObjectKey<UObject> Key(Client);
+    FInterest& Interest = Clients.FindOrAdd(Key);
+    Interest.Object = Client;
+
+    UnlinkTags(Key, Interest);
+    Interest.Tags = Tags;
+    for (const FName& Tag : Tags)
+        TaggedClients.FindOrAdd(Tag).Add(Key);
+}
+
+void FClientInterestGrid::RemoveClient(UObject* Client)
+{
+    const TObjectKey<UObject> Key(Client);
+    FInterest* Interest = Clients.Find(Key);
+    if (Interest == nullptr)
+        return;
+
+    UnlinkSpatial(Key, *Interest);
+    UnlinkTags(Key, *Interest);
+    Clients.Remove(Key);
+}
+
+void FClientInterestGrid::Reset()
+{
+    Clients.Empty();
+    Cells.Empty();
+    OversizedClients.Empty();
+    TaggedClients.Empty();
+}
+
+void FClientInterestGrid::UnlinkSpatial(const TObjectKey<UObject>& Key, FInterest& Interest)
+{
+    if (Interest.bOversized)
+    {
+        OversizedClients.Remove(Key);
+        Interest.bOversized = false;
+    }
+
+    for (int32 X = Interest.MinCell.X; X <= Interest.MaxCell.X; ++X)
+    {
+        for (int32 Y = Interest.MinCell.Y; Y <= Interest.MaxCell.Y; ++Y)
+        {
+            const FIntPoint Cell(X, Y);
+            if (TArray<TObjectKey<UObject>>* CellClients = Cells.Find(Cell))
+            {
+                CellClients->RemoveSingleSwap(Key, EAllowShrinking::No);
+                if (CellClients->IsEmpty())
+                    Cells.Remove(Cell);
+            }
+        }
+    }
+    Interest.MinCell = FIntPoint(0, 0);
+    Interest.MaxCell = FIntPoint(-1, -1);
+    Interest.Radius = 0.0f;
+}
+
+void FClientInterestGrid::UnlinkTags(const TObjectKey<UObject>& Key, FInterest& Interest)
+{
+    for (const FName& Tag : Interest.Tags)
+    {
+        if (TSet<TObjectKey<UObject>>* Tagged = TaggedClients.Find(Tag))
+        {
+            Tagged->Remove(Key);
+            if (Tagged->IsEmpty())
+                TaggedClients.Remove(Tag);
+        }
+    }
+    Interest.Tags.Reset();
+}
+
+void FClientInterestGrid::QueryLocation(const FVector& Location, TArray<UObject*>& OutClients) const
+{
+    if (const TArray<TObjectKey<UObject>>* CellClients = Cells.Find(GetCell(Location)))
+    {
+        for (const TObjectKey<UObject>& Key : *CellClients)
+        {
+            const FInterest& Interest = Clients.FindChecked(Key);
+            UObject* Object = Interest.Object.Get();
+            if (Object != nullptr && Contains(Interest, Location))
+                OutClients.Add(Object);
+        }
+    }
+
+    for (const TObjectKey<UObject>& Key : OversizedClients)
+    {
+        const FInterest& Interest = Clients.FindChecked(Key);
+        UObject* Object = Interest.Object.Get();
+        if (Object != nullptr && Contains(Interest, Location))
+            OutClients.Add(Object);
+    }
+}
+
+void FClientInterestGrid::QueryTag(FName Tag, TArray<UObject*>& OutClients) const
+{
+    const TSet<TObjectKey<UObject>>* Tagged = TaggedClients.Find(Tag);
+    if (Tagged == nullptr)
+        return;
+
+    OutClients.Reserve(OutClients.Num() + Tagged->Num());
+    for (const TObjectKey<UObject>& Key : *Tagged)
+    {
+        if (UObject* Object = Clients.FindChecked(Key).Object.Get())
+            OutClients.Add(Object);
+    }
+}
@@ -0,0 +1,272 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Messaging/JsonStateStream.h"
+
+#include "Dispatcher/JsonMessageDispatcher.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "WebApiServerStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Stream Snapshots Sent"), STAT_WebApiServer_StateStreamSnapshots, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Stream Patches Sent"), STAT_WebApiServer_StateStreamPatches, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Stream Bytes Sent"), STAT_WebApiServer_StateStreamBytesSent, STATGROUP_WebApiServer);
+
+static FString SerializeCondensed(const TSharedPtr<FJsonValue>& Value)
+{
+    FString Result;
+    TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Result);
+    if (!FJsonSerializer::Serialize(Value.IsValid() ? Value : MakeShared<FJsonValueNull>(), FString(), Writer))
+        return FString();
+    return Result;
+}
+
+/** Copy of the whole tree, so later changes made by the publisher don't alter the recorded versions */
+static TSharedPtr<FJsonValue> DeepCopyJsonValue(const TSharedPtr<FJsonValue>& Value)
+{
+    if (!Value.IsValid())
+        return nullptr;
+
+    switch (Value->Type)
+    {
+    case EJson::Array:
+        {
+            TArray<TSharedPtr<FJsonValue>> Elements;
+            Elements.Reserve(Value->AsArray().Num());
+            for (const TSharedPtr<FJsonValue>& Element : Value->AsArray())
+                Elements.Add(DeepCopyJsonValue(Element));
+            return MakeShared<FJsonValueArray>(MoveTemp(Elements));
+        }
+    case EJson::Object:
+        {
+            const TSharedPtr<FJsonObject>& Object = Value->AsObject();
+            TSharedPtr<FJsonObject> Copy = MakeShared<FJsonObject>();
+            if (Object.IsValid())
+            {
+                Copy->Values.Reserve(Object->Values.Num());
+                for (const auto& [Name, Member] : Object->Values)
+                    Copy->Values.Add(Name, DeepCopyJsonValue(Member));
+            }
+            return MakeShared<FJsonValueObject>(Copy);
+        }
+    default:
+        // Scalars are immutable
+        return Value;
+    }
+}
+
+/** A merge patch reads null members as removals, so objects holding nulls can't be sent as patch values */
+static bool ContainsNullMember(const TSharedPtr<FJsonValue>& Value)
+{
+    if (!Value.IsValid() || Value->Type != EJson::Object || !Value->AsObject().IsValid())
+        return false;
+
+    for (const auto& [Name, Member] : Value->AsObject()->Values)
+    {
+        if (!Member.IsValid() || Member->IsNull() || ContainsNullMember(Member))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Json merge patch (RFC 7396) turning Old into New. OutPatch is left invalid when both are equal.
+ * Returns false when the change can't be expressed as a merge patch.
+ */
+static bool MakeMergePatch(const TSharedPtr<FJsonValue>& Old, const TSharedPtr<FJsonValue>& New, TSharedPtr<FJsonValue>& OutPatch)
+{
+    OutPatch = nullptr;
+
+    if (Old.IsValid() && New.IsValid() && Old->Type == EJson::Object && New->Type == EJson::Object
+        && Old->AsObject().IsValid() && New->AsObject().IsValid())
+    {
+        const TMap<FString, TSharedPtr<FJsonValue>>& OldValues = Old->AsObject()->Values;
+        const TMap<FString, TSharedPtr<FJsonValue>>& NewValues = New->AsObject()->Values;
+
+        TSharedPtr<FJsonObject> Patch = MakeShared<FJsonObject>();
+        for (const auto& [Name, OldMember] : OldValues)
+        {
+            if (!NewValues.Contains(Name))
+                Patch->Values.Add(Name, MakeShared<FJsonValueNull>());
+        }
+        for (const auto& [Name, NewMember] : NewValues)
+        {
+            const TSharedPtr<FJsonValue>* OldMember = OldValues.Find(Name);
+            if (OldMember == nullptr)
+            {
+                if (!NewMember.IsValid() || NewMember->IsNull() || ContainsNullMember(NewMember))
+                    return false;
+                Patch->Values.Add(Name, NewMember);
+                continue;
+            }
+
+            TSharedPtr<FJsonValue> MemberPatch;
+            if (!MakeMergePatch(*OldMember, NewMember, MemberPatch))
+                return false;
+            if (MemberPatch.IsValid())
+                Patch->Values.Add(Name, MemberPatch);
+        }
+
+        if (!Patch->Values.IsEmpty())
+            OutPatch = MakeShared<FJsonValueObject>(Patch);
+        return true;
+    }
+
+    if (Old.IsValid() && New.IsValid() && FJsonValue::CompareEqual(*Old, *New))
+        return true;
+
+    // Replaced as a whole
+    if (!New.IsValid() || New->IsNull() || ContainsNullMember(New))
+        return false;
+
+    OutPatch = New;
+    return true;
+}
+
+UJsonStateStream* UJsonStateStream::NewJsonStateStream(UObject* Outer, const FString& Method)
+{
+    UJsonStateStream* NewStream = NewObject<UJsonStateStream>(Outer);
+    NewStream->Method = Method;
+
+    return NewStream;
+}
+
+void UJsonStateStream::Subscribe(const TScriptInterface<IMessageSender>& Subscriber)
+{
+    UObject* Object = Subscriber.GetObject();
+    if (!IsValid(Object))
+        return;
+
+    FSubscriber& NewSubscriber = Subscribers.Add(Object);
+    NewSubscriber.Object = Object;
+    NewSubscriber.BaseVersion = INDEX_NONE;
+
+    if (!History.IsEmpty())
+        SendCurrentState(NewSubscriber);
+}
+
+void UJsonStateStream::Unsubscribe(const TScriptInterface<IMessageSender>& Subscriber)
+{
+    Subscribers.Remove(Subscriber.GetObject());
+}
+
+void UJsonStateStream::PublishState(const TSharedPtr<FJsonValue>& State)
+{
+    // Nothing changed, nothing to send
+    if (!History.IsEmpty() && History.Last().State.IsValid() && State.IsValid()
+        && FJsonValue::CompareEqual(*History.Last().State, *State))
+        return;
+
+    FVersion& NewVersion = History.AddDefaulted_GetRef();
+    NewVersion.Version = ++CurrentVersion;
+    NewVersion.State = DeepCopyJsonValue(State);
+
+    const int32 ExtraVersions = History.Num() - FMath::Max(HistorySize, 1);
+    if (ExtraVersions > 0)
+        History.RemoveAt(0, ExtraVersions, EAllowShrinking::No);
+
+    SnapshotMessage.Reset();
+    PatchMessages.Reset();
+
+    for (auto It = Subscribers.CreateIterator(); It; ++It)
+    {
+        if (!It->Value.Object.IsValid())
+        {
+            It.RemoveCurrent();
+            continue;
+        }
+        SendCurrentState(It->Value);
+    }
+}
+
+void UJsonStateStream::PublishStateWrapper(const FJsonObjectWrapper& State, EJsonObjectWrapperType StateType)
+{
+    PublishState(FromJsonWrapper(State, StateType));
+}
+
+void UJsonStateStream::Acknowledge(const TScriptInterface<IMessageSender>& Subscriber, int32 Version)
+{
+    FSubscriber* ExistingSubscriber = Subscribers.Find(Subscriber.GetObject());
+    if (ExistingSubscriber == nullptr || Version > CurrentVersion)
+        return;
+
+    ExistingSubscriber->BaseVersion = FMath::Max(ExistingSubscriber->BaseVersion, Version);
+}
+
+void UJsonStateStream::Resync(const TScriptInterface<IMessageSender>& Subscriber)
+{
+    FSubscriber* ExistingSubscriber = Subscribers.Find(Subscriber.GetObject());
+    if (ExistingSubscriber == nullptr)
+        return;
+
+    ExistingSubscriber->BaseVersion = INDEX_NONE;
+    if (!History.IsEmpty())
+        SendCurrentState(*ExistingSubscriber);
+}
+
+void UJsonStateStream::SendCurrentState(FSubscriber& Subscriber)
+{
+    UObject* Object = Subscriber.Object.Get();
+    if (!IsValid(Object) || Subscriber.BaseVersion == CurrentVersion)
+        return;
+
+    const FString* Message = nullptr;
+    if (Subscriber.BaseVersion != INDEX_NONE)
+    {
+        const FString& PatchMessage = GetPatchMessage(Subscriber.BaseVersion);
+        if (!PatchMessage.IsEmpty())
+        {
+            INC_DWORD_STAT(STAT_WebApiServer_StateStreamPatches);
+            Message = &PatchMessage;
+        }
+    }
+    if (Message == nullptr)
+    {
+        INC_DWORD_STAT(STAT_WebApiServer_StateStreamSnapshots);
+        Message = &GetSnapshotMessage();
+    }
+
+    INC_DWORD_STAT_BY(STAT_WebApiServer_StateStreamBytesSent, Message->Len());
+    IMessageSender::Execute_SendMessage(Object, *Message);
+
+    if (!bRequireAcknowledge)
+        Subscriber.BaseVersion = CurrentVersion;
+}
+
+const FString& UJsonStateStream::GetSnapshotMessage()
+{
+    if (SnapshotMessage.IsEmpty() && !History.IsEmpty())
+    {
+        SnapshotMessage = FString::Printf(TEXT("{\"" JSONRPC_METHOD "\":%s,\"" JSONRPC_PARAMS "\":{\"version\":%d,\"snapshot\":%s}}"),
+            *SerializeCondensed(MakeShared<FJsonValueString>(Method)), CurrentVersion, *SerializeCondensed(History.Last().State));
+    }
+    return SnapshotMessage;
+}
+
+const FString& UJsonStateStream::GetPatchMessage(int32 BaseVersion)
+{
+    if (const FString* Existing = PatchMessages.Find(BaseVersion))
+        return *Existing;
+
+    FString& PatchMessage = PatchMessages.Add(BaseVersion);
+
+    const FVersion* Base = History.FindByPredicate([BaseVersion](const FVersion& Version) { return Version.Version == BaseVersion; });
+    if (Base == nullptr)
+        return PatchMessage;
+
+    TSharedPtr<FJsonValue> Patch;
+    if (!MakeMergePatch(Base->State, History.Last().State, Patch))
+        return PatchMessage;
+
+    PatchMessage = FString::Printf(TEXT("{\"" JSONRPC_METHOD "\":%s,\"" JSONRPC_PARAMS "\":{\"version\":%d,\"base\":%d"),
+        *SerializeCondensed(MakeShared<FJsonValueString>(Method)), CurrentVersion, BaseVersion);
+    if (Patch.IsValid())
+        PatchMessage += TEXT(",\"patch\":") + SerializeCondensed(Patch);
+    PatchMessage += TEXT("}}");
+
+    // Not worth it, the subscriber gets the snapshot instead
+    if (PatchMessage.Len() >= GetSnapshotMessage().Len())
+        PatchMessage.Reset();
+
+    return PatchMessage;
+}
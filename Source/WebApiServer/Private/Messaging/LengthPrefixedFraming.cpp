@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Messaging/LengthPrefixedFraming.h"
+
+void FLengthPrefixedFraming::QueueMessage(const FString& Message)
+{
+    FTCHARToUTF8 Converter(*Message, Message.Len());
+    QueueData(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+}
+
+void FLengthPrefixedFraming::QueueData(const uint8* Data, int32 Size)
+{
+    const uint32 Length = static_cast<uint32>(Size);
+    const uint8 Header[LENGTH_PREFIX_SIZE] = {
+        static_cast<uint8>(Length >> 24),
+        static_cast<uint8>(Length >> 16),
+        static_cast<uint8>(Length >> 8),
+        static_cast<uint8>(Length),
+    };
+
+    SendBuffer.Reserve(SendBuffer.Num() + LENGTH_PREFIX_SIZE + Size);
+    SendBuffer.Append(Header, LENGTH_PREFIX_SIZE);
+    SendBuffer.Append(Data, Size);
+}
+
+void FLengthPrefixedFraming::ConsumeSent(int32 Count)
+{
+    SendOffset += Count;
+    if (SendOffset >= SendBuffer.Num())
+    {
+        SendBuffer.Reset();
+        SendOffset = 0;
+    }
+}
+
+uint8* FLengthPrefixedFraming::GetReceiveSlack(int32 MinSize)
+{
+    // Drop the consumed head before growing so the buffer doesn't creep
+    if (ReceiveOffset > 0)
+    {
+        ReceiveBuffer.RemoveAt(0, ReceiveOffset, EAllowShrinking::No);
+        ScanOffset = FMath::Max(ScanOffset - ReceiveOffset, 0);
+        ReceiveOffset = 0;
+    }
+
+    const int32 Used = ReceiveBuffer.Num();
+    ReceiveBuffer.Reserve(Used + MinSize);
+    return ReceiveBuffer.GetData() + Used;
+}
+
+void FLengthPrefixedFraming::CommitReceived(int32 Count)
+{
+    check(ReceiveBuffer.Num() + Count <= ReceiveBuffer.Max());
+    ReceiveBuffer.SetNumUninitialized(ReceiveBuffer.Num() + Count, EAllowShrinking::No);
+}
+
+static uint32 ReadLengthPrefix(const uint8* Header)
+{
+    return (static_cast<uint32>(Header[0]) << 24)
+        | (static_cast<uint32>(Header[1]) << 16)
+        | (static_cast<uint32>(Header[2]) << 8)
+        | static_cast<uint32>(Header[3]);
+}
+
+bool FLengthPrefixedFraming::HasOversizedFrame()
+{
+    // Every header of the buffered range, not only the next one: a small frame may be followed by an oversized one
+    ScanOffset = FMath::Max(ScanOffset, ReceiveOffset);
+    while (ReceiveBuffer.Num() - ScanOffset >= LENGTH_PREFIX_SIZE)
+    {
+        const uint32 Length = ReadLengthPrefix(ReceiveBuffer.GetData() + ScanOffset);
+        if (Length > static_cast<uint32>(MaxFrameSize))
+            return true;
+
+        // Incomplete frame, its header is read again once more bytes arrive
+        if (static_cast<uint32>(ReceiveBuffer.Num() - ScanOffset - LENGTH_PREFIX_SIZE) < Length)
+            return false;
+
+        ScanOffset += LENGTH_PREFIX_SIZE + static_cast<int32>(Length);
+    }
+    return false;
+}
+
+ELengthPrefixedReadResult FLengthPrefixedFraming::TryReadMessage(FString& OutMessage)
+{
+    const int32 Available = ReceiveBuffer.Num() - ReceiveOffset;
+    if (Available < LENGTH_PREFIX_SIZE)
+        return ELengthPrefixedReadResult::NeedMoreData;
+
+    const uint8* Header = ReceiveBuffer.GetData() + ReceiveOffset;
+    const uint32 Length = ReadLengthPrefix(Header);
+
+    if (Length > static_cast<uint32>(MaxFrameSize))
+        return ELengthPrefixedReadResult::Oversized;
+
+    if (static_cast<uint32>(Available - LENGTH_PREFIX_SIZE) < Length)
+        return ELengthPrefixedReadResult::NeedMoreData;
+
+    const ANSICHAR* Payload = reinterpret_cast<const ANSICHAR*>(Header + LENGTH_PREFIX_SIZE);
+    FUTF8ToTCHAR Converter(Payload, static_cast<int32>(Length));
+    OutMessage = FString(Converter.Length(), Converter.Get());
+
+    ReceiveOffset += LENGTH_PREFIX_SIZE + static_cast<int32>(Length);
+    if (ReceiveOffset == ReceiveBuffer.Num())
+    {
+        ReceiveBuffer.Reset();
+        ReceiveOffset = 0;
+        ScanOffset = 0;
+    }
+    return ELengthPrefixedReadResult::Frame;
+}
+
+void FLengthPrefixedFraming::Reset()
+{
+    SendBuffer.Reset();
+    SendOffset = 0;
+    ReceiveBuffer.Reset();
+    ReceiveOffset = 0;
+    ScanOffset = 0;
+}
@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Messaging/MessageDeflate.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+/** Ends every sync flush, stripped by the sender and restored by the receiver */
+static const uint8 FlushMarker[] = { 0x00, 0x00, 0xFF, 0xFF };
+
+struct FMessageDeflate::FStreams
+{
+    z_stream Deflate;
+    z_stream Inflate;
+    bool bDeflateInit = false;
+    bool bInflateInit = false;
+
+    FStreams()
+    {
+        FMemory::Memzero(Deflate);
+        FMemory::Memzero(Inflate);
+    }
+
+    ~FStreams()
+    {
+        End();
+    }
+
+    void End()
+    {
+        if (bDeflateInit)
+            deflateEnd(&Deflate);
+        if (bInflateInit)
+            inflateEnd(&Inflate);
+        bDeflateInit = false;
+        bInflateInit = false;
+    }
+};
+
+FMessageDeflate::FMessageDeflate()
+    : Streams(MakeUnique<FStreams>())
+{
+    Reset(false);
+}
+
+FMessageDeflate::~FMessageDeflate()
+{
+}
+
+void FMessageDeflate::Reset(bool bInContextTakeover)
+{
+    bContextTakeover = bInContextTakeover;
+    FrameBuffer.Reset();
+
+    Streams->End();
+    FMemory::Memzero(Streams->Deflate);
+    FMemory::Memzero(Streams->Inflate);
+
+    // Negative window bits: raw deflate without zlib header, as permessage-deflate
+    Streams->bDeflateInit = deflateInit2(&Streams->Deflate, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    Streams->bInflateInit = inflateInit2(&Streams->Inflate, -MAX_WBITS) == Z_OK;
+}
+
+bool FMessageDeflate::Compress(const uint8* Data, int32 Count, TArray<uint8>& OutFrame)
+{
+    if (!Streams->bDeflateInit)
+        return false;
+
+    z_stream& Stream = Streams->Deflate;
+    const int32 Start = OutFrame.Num();
+    const int32 PayloadStart = Start + MESSAGE_DEFLATE_HEADER_SIZE;
+
+    // Usually enough for the whole message and the flush in one pass
+    OutFrame.SetNumUninitialized(PayloadStart + static_cast<int32>(deflateBound(&Stream, Count)) + 16);
+
+    Stream.next_in = const_cast<Bytef*>(Data);
+    Stream.avail_in = Count;
+    int32 End = PayloadStart;
+    for (;;)
+    {
+        Stream.next_out = OutFrame.GetData() + End;
+        Stream.avail_out = OutFrame.Num() - End;
+        const int Result = deflate(&Stream, Z_SYNC_FLUSH);
+        End = OutFrame.Num() - static_cast<int32>(Stream.avail_out);
+
+        if (Result != Z_OK && Result != Z_BUF_ERROR)
+        {
+            OutFrame.SetNum(Start);
+            return false;
+        }
+
+        // The flush is complete once it didn't fill the output
+        if (Stream.avail_out > 0)
+            break;
+        OutFrame.SetNumUninitialized(OutFrame.Num() * 2);
+    }
+
+    if (End - PayloadStart >= 4 && FMemory::Memcmp(OutFrame.GetData() + End - 4, FlushMarker, 4) == 0)
+        End -= 4;
+
+    if (!bContextTakeover)
+        deflateReset(&Stream);
+
+    const uint32 PayloadSize = static_cast<uint32>(End - PayloadStart);
+    uint8* Header = OutFrame.GetData() + Start;
+    Header[0] = MESSAGE_DEFLATE_MARKER;
+    Header[1] = static_cast<uint8>(PayloadSize >> 24);
+    Header[2] = static_cast<uint8>(PayloadSize >> 16);
+    Header[3] = static_cast<uint8>(PayloadSize >> 8);
+    Header[4] = static_cast<uint8>(PayloadSize);
+
+    OutFrame.SetNum(End);
+    return true;
+}
+
+int32 FMessageDeflate::FeedFrame(const uint8* Data, int32 Count, int32 MaxFrameSize, bool& bOutComplete, bool& bOutOversized)
+{
+    bOutComplete = false;
+    bOutOversized = false;
+
+    // The header itself may be split over two fragments
+    int32 Consumed = 0;
+    if (FrameBuffer.Num() < MESSAGE_DEFLATE_HEADER_SIZE)
+    {
+        Consumed = FMath::Min(MESSAGE_DEFLATE_HEADER_SIZE - FrameBuffer.Num(), Count);
+        FrameBuffer.Append(Data, Consumed);
+        if (FrameBuffer.Num() < MESSAGE_DEFLATE_HEADER_SIZE)
+            return Consumed;
+    }
+
+    const uint32 PayloadSize = (static_cast<uint32>(FrameBuffer[1]) << 24) | (static_cast<uint32>(FrameBuffer[2]) << 16)
+        | (static_cast<uint32>(FrameBuffer[3]) << 8) | static_cast<uint32>(FrameBuffer[4]);
+    if (PayloadSize > static_cast<uint32>(MaxFrameSize))
+    {
+        FrameBuffer.Reset();
+        bOutOversized = true;
+        return Count;
+    }
+
+    const int32 FrameSize = MESSAGE_DEFLATE_HEADER_SIZE + static_cast<int32>(PayloadSize);
+    const int32 PayloadBytes = FMath::Min(FrameSize - FrameBuffer.Num(), Count - Consumed);
+    FrameBuffer.Reserve(FrameSize + sizeof(FlushMarker));
+    FrameBuffer.Append(Data + Consumed, PayloadBytes);
+
+    bOutComplete = FrameBuffer.Num() == FrameSize;
+    return Consumed + PayloadBytes;
+}
+
+bool FMessageDeflate::DecompressFrame(int32 MaxSize, TArray<uint8>& OutMessage)
+{
+    if (!Streams->bInflateInit)
+        return false;
+
+    FrameBuffer.Append(FlushMarker, sizeof(FlushMarker));
+
+    z_stream& Stream = Streams->Inflate;
+    Stream.next_in = FrameBuffer.GetData() + MESSAGE_DEFLATE_HEADER_SIZE;
+    Stream.avail_in = FrameBuffer.Num() - MESSAGE_DEFLATE_HEADER_SIZE;
+
+    // One byte over the limit tells an oversized message apart from one that just fits
+    const int32 Limit = FMath::Min(MaxSize, MAX_int32 - 1) + 1;
+    OutMessage.SetNumUninitialized(FMath::Min(FMath::Max(static_cast<int32>(Stream.avail_in) * 4, 4096), Limit));
+
+    bool bSuccess = true;
+    bool bStreamEnded = false;
+    int32 Produced = 0;
+    for (;;)
+    {
+        Stream.next_out = OutMessage.GetData() + Produced;
+        Stream.avail_out = OutMessage.Num() - Produced;
+        const int Result = inflate(&Stream, Z_SYNC_FLUSH);
+        Produced = OutMessage.Num() - static_cast<int32>(Stream.avail_out);
+
+        if (Produced > MaxSize || (Result != Z_OK && Result != Z_BUF_ERROR && Result != Z_STREAM_END))
+        {
+            bSuccess = false;
+            break;
+        }
+
+        // A final block from the peer ends the stream, the next message starts a new one
+        bStreamEnded = Result == Z_STREAM_END;
+        if (bStreamEnded || (Stream.avail_in == 0 && Stream.avail_out > 0))
+            break;
+
+        // No progress with output space left: truncated input
+        if (Stream.avail_out > 0)
+        {
+            bSuccess = false;
+            break;
+        }
+        OutMessage.SetNumUninitialized(FMath::Min(OutMessage.Num() * 2, Limit));
+    }
+
+    FrameBuffer.Reset();
+    OutMessage.SetNum(bSuccess ? Produced : 0);
+
+    if (!bContextTakeover || !bSuccess || bStreamEnded)
+        inflateReset(&Stream);
+    return bSuccess;
+}
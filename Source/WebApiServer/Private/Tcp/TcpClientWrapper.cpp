@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Tcp/TcpClientWrapper.h"
+
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "WebApiServerStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Tcp Pump"), STAT_WebApiServer_TcpPump, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tcp Bytes Sent"), STAT_WebApiServer_TcpBytesSent, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tcp Bytes Received"), STAT_WebApiServer_TcpBytesReceived, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tcp Messages Received"), STAT_WebApiServer_TcpMessagesReceived, STATGROUP_WebApiServer);
+
+/** Bytes requested from the socket per Recv call */
+static constexpr int32 TcpReceiveChunkSize = 64 * 1024;
+
+UTcpClientWrapper::~UTcpClientWrapper()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+    CloseSocket();
+}
+
+UTcpClientWrapper* UTcpClientWrapper::NewTcpConnection(UObject* Outer, const FString& Host, int32 Port)
+{
+    UTcpClientWrapper* NewClient = NewObject<UTcpClientWrapper>(Outer);
+    NewClient->Connect(Host, Port);
+
+    return NewClient;
+}
+
+bool UTcpClientWrapper::Connect(const FString& Host, int32 Port)
+{
+    if (Socket != nullptr)
+        return false;
+
+    ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+    FAddressInfoResult AddressInfo = SocketSubsystem->GetAddressInfo(*Host, nullptr, EAddressInfoFlags::Default, NAME_None, ESocketType::SOCKTYPE_Streaming);
+    if (AddressInfo.ReturnCode != SE_NO_ERROR || AddressInfo.Results.IsEmpty())
+    {
+        OnError.Broadcast(this);
+        return false;
+    }
+
+    TSharedRef<FInternetAddr> ServerAddr = AddressInfo.Results[0].Address;
+    ServerAddr->SetPort(Port);
+
+    FSocket* NewSocket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("WebApiServer Tcp Client"), ServerAddr->GetProtocolType());
+    if (NewSocket == nullptr)
+    {
+        OnError.Broadcast(this);
+        return false;
+    }
+
+    NewSocket->SetNonBlocking(true);
+    NewSocket->SetNoDelay(true);
+
+    if (!NewSocket->Connect(*ServerAddr))
+    {
+        SocketSubsystem->DestroySocket(NewSocket);
+        OnError.Broadcast(this);
+        return false;
+    }
+
+    Initialize(nullptr, NewSocket);
+
+    TWeakObjectPtr<UTcpClientWrapper> WeakThis(this);
+    TickHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateLambda([WeakThis](float DeltaTime) {
+            if (WeakThis.IsValid() && WeakThis->Socket != nullptr)
+                return WeakThis->Pump();
+            return false;
+        }));
+
+    return true;
+}
+
+void UTcpClientWrapper::Disconnect()
+{
+    if (Socket == nullptr)
+        return;
+
+    // Best effort to deliver what is still queued
+    FlushSendBuffer();
+    HandleConnectionLost(false);
+}
+
+bool UTcpClientWrapper::IsConnected() const
+{
+    return Socket != nullptr && bConnected;
+}
+
+void UTcpClientWrapper::Initialize(UTcpServerWrapper* InServer, FSocket* InSocket)
+{
+    Server = InServer;
+    Socket = InSocket;
+    Framing.Reset();
+
+    // Accepted sockets are connected already, outbound ones are reported from Pump
+    bConnected = InServer != nullptr;
+}
+
+bool UTcpClientWrapper::SendMessage_Implementation(const FString& Message)
+{
+    if (Socket == nullptr)
+        return false;
+
+    Framing.QueueMessage(Message);
+    return !bConnected || FlushSendBuffer();
+}
+
+bool UTcpClientWrapper::SendData(const TArray<uint8>& Data)
+{
+    if (Socket == nullptr)
+        return false;
+
+    Framing.QueueData(Data.GetData(), Data.Num());
+    return !bConnected || FlushSendBuffer();
+}
+
+bool UTcpClientWrapper::Pump()
+{
+    SCOPE_CYCLE_COUNTER(STAT_WebApiServer_TcpPump);
+
+    if (Socket == nullptr)
+        return false;
+
+    Framing.MaxFrameSize = MaxMessageSize;
+
+    if (!bConnected)
+    {
+        switch (Socket->GetConnectionState())
+        {
+        case SCS_Connected:
+            bConnected = true;
+            OnConnected.Broadcast(this);
+            break;
+        case SCS_ConnectionError:
+            HandleConnectionLost(true);
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    if (!FlushSendBuffer() || !ReceiveAvailable())
+        return false;
+
+    FString Message;
+    for (;;)
+    {
+        ELengthPrefixedReadResult Result = Framing.TryReadMessage(Message);
+        if (Result == ELengthPrefixedReadResult::NeedMoreData)
+            break;
+
+        if (Result == ELengthPrefixedReadResult::Oversized)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("TcpClientWrapper: Closing connection after oversized frame (max %d bytes)"), MaxMessageSize);
+            HandleConnectionLost(true);
+            return false;
+        }
+
+        INC_DWORD_STAT(STAT_WebApiServer_TcpMessagesReceived);
+        OnMessageRecieved.Broadcast(this, Message);
+
+        // A listener may have closed the connection
+        if (Socket == nullptr)
+            return false;
+    }
+
+    return true;
+}
+
+bool UTcpClientWrapper::FlushSendBuffer()
+{
+    while (Framing.GetPendingSendBytes() > 0)
+    {
+        int32 BytesSent = 0;
+        if (!Socket->Send(Framing.GetPendingSendData(), Framing.GetPendingSendBytes(), BytesSent))
+        {
+            if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK)
+                return true;
+
+            HandleConnectionLost(true);
+            return false;
+        }
+
+        if (BytesSent <= 0)
+            return true;
+
+        INC_DWORD_STAT_BY(STAT_WebApiServer_TcpBytesSent, BytesSent);
+        Framing.ConsumeSent(BytesSent);
+    }
+    return true;
+}
+
+bool UTcpClientWrapper::ReceiveAvailable()
+{
+    for (;;)
+    {
+        uint8* Slack = Framing.GetReceiveSlack(TcpReceiveChunkSize);
+        int32 BytesRead = 0;
+
+        // Streaming sockets report a graceful close as a failed read
+        if (!Socket->Recv(Slack, TcpReceiveChunkSize, BytesRead))
+        {
+            HandleConnectionLost(false);
+            return false;
+        }
+
+        if (BytesRead <= 0)
+            return true;
+
+        INC_DWORD_STAT_BY(STAT_WebApiServer_TcpBytesReceived, BytesRead);
+        Framing.CommitReceived(BytesRead);
+
+        // Let Pump reject an oversized frame before buffering the rest of it, and drain complete frames before reading more
+        if (BytesRead < TcpReceiveChunkSize || Framing.HasOversizedFrame() || Framing.IsReceiveBufferFull())
+            return true;
+    }
+}
+
+void UTcpClientWrapper::CloseSocket()
+{
+    if (Socket == nullptr)
+        return;
+
+    Socket->Close();
+    ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+    Socket = nullptr;
+    bConnected = false;
+    Framing.Reset();
+}
+
+void UTcpClientWrapper::HandleConnectionLost(bool bError)
+{
+    if (Socket == nullptr)
+        return;
+
+    CloseSocket();
+
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+
+    if (bError)
+        OnError.Broadcast(this);
+    OnDisconnected.Broadcast(this);
+    ClosedDelegate.Broadcast();
+    Server = nullptr;
+}
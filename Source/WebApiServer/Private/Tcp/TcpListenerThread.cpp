@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Tcp/TcpListenerThread.h"
+
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+/** Longest the thread waits for a connection before checking whether it should stop */
+static const FTimespan AcceptWaitTime = FTimespan::FromMilliseconds(100);
+
+FTcpListenerThread::FTcpListenerThread(FSocket* InListenSocket, FTcpAcceptedSocketQueue& InAcceptedSockets, int32 InIndex)
+    : ListenSocket(InListenSocket)
+    , AcceptedSockets(InAcceptedSockets)
+{
+    Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("WebApiServerTcpListener%d"), InIndex), 0, TPri_Normal);
+}
+
+FTcpListenerThread::~FTcpListenerThread()
+{
+    if (Thread != nullptr)
+    {
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    ListenSocket->Close();
+    ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenSocket);
+    ListenSocket = nullptr;
+}
+
+uint32 FTcpListenerThread::Run()
+{
+    while (!bStopping.load(std::memory_order_relaxed))
+    {
+        bool bHasPendingConnection = false;
+        if (!ListenSocket->WaitForPendingConnection(bHasPendingConnection, AcceptWaitTime))
+        {
+            // Don't spin on a listening socket in error
+            FPlatformProcess::Sleep(AcceptWaitTime.GetTotalSeconds());
+            continue;
+        }
+        if (!bHasPendingConnection)
+            continue;
+
+        // The peer may have given up between the wait and the accept
+        FSocket* ClientSocket = ListenSocket->Accept(TEXT("WebApiServer Tcp Connection"));
+        if (ClientSocket == nullptr)
+            continue;
+
+        ClientSocket->SetNonBlocking(true);
+        ClientSocket->SetNoDelay(true);
+        AcceptedSockets.Enqueue(ClientSocket);
+    }
+    return 0;
+}
+
+void FTcpListenerThread::Stop()
+{
+    bStopping = true;
+}
@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tcp/TcpServerWrapper.h"
+
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Tcp/TcpClientWrapper.h"
+#include "WebApiServerStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Tcp Server Tick"), STAT_WebApiServer_TcpServerTick, STATGROUP_WebApiServer);
+
+static constexpr int32 ListenBacklog = 128;
+
+/** Several sockets may listen on the same port and share its connections */
+#define WEBAPISERVER_WITH_REUSEPORT PLATFORM_LINUX
+
+static FSocket* CreateListenSocket(ISocketSubsystem* SocketSubsystem, const FInternetAddr& BindAddr)
+{
+    FSocket* ListenSocket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("WebApiServer Tcp Listener"), BindAddr.GetProtocolType());
+    if (ListenSocket == nullptr)
+        return nullptr;
+
+    // Also sets SO_REUSEPORT where the socket subsystem supports it
+    ListenSocket->SetReuseAddr(true);
+    // The listener thread waits for connections, an accept must not block once the peer gave up
+    ListenSocket->SetNonBlocking(true);
+
+    if (!ListenSocket->Bind(BindAddr) || !ListenSocket->Listen(ListenBacklog))
+    {
+        SocketSubsystem->DestroySocket(ListenSocket);
+        return nullptr;
+    }
+    return ListenSocket;
+}
+
+UTcpServerWrapper::~UTcpServerWrapper()
+{
+    StopServer();
+}
+
+UTcpServerWrapper* UTcpServerWrapper::NewTcpServer(UObject* Outer, int32 Port)
+{
+    UTcpServerWrapper* NewServer = NewObject<UTcpServerWrapper>(Outer);
+    NewServer->StartServer(Port);
+
+    return NewServer;
+}
+
+bool UTcpServerWrapper::StartServer(int32 Port)
+{
+    if (IsRunning())
+        return false;
+
+    TcpPort = Port;
+    ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+    TSharedRef<FInternetAddr> BindAddr = SocketSubsystem->CreateInternetAddr();
+    BindAddr->SetAnyAddress();
+    BindAddr->SetPort(Port);
+
+#if WEBAPISERVER_WITH_REUSEPORT
+    const int32 ListenerCount = FMath::Max(NumListeners, 1);
+#else
+    const int32 ListenerCount = 1;
+#endif
+
+    for (int32 Index = 0; Index < ListenerCount; ++Index)
+    {
+        FSocket* ListenSocket = CreateListenSocket(SocketSubsystem, *BindAddr);
+        if (ListenSocket == nullptr)
+            break;
+        Listeners.Add(MakeUnique<FTcpListenerThread>(ListenSocket, AcceptedSockets, Index));
+    }
+
+    // Extra listeners are an optimization, the server runs as long as the first one could be bound
+    if (Listeners.IsEmpty())
+        return false;
+
+    TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick));
+    return true;
+}
+
+void UTcpServerWrapper::StopServer()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+
+    // Closed like a disconnect so the dispatcher fails what is pending on each client
+    TArray<TObjectPtr<UTcpClientWrapper>> Clients = TcpClients.Array();
+    TcpClients.Empty();
+    for (auto&& Client : Clients)
+    {
+        if (!Client)
+            continue;
+
+        // Nobody is left to notify once the server itself is being collected
+        if (HasAnyFlags(RF_BeginDestroyed))
+        {
+            Client->CloseSocket();
+            continue;
+        }
+        Client->HandleConnectionLost(false);
+        OnClientDisconnect.Broadcast(this, Client);
+    }
+
+    // Joins the threads, then nothing is added to the queue any more
+    Listeners.Empty();
+
+    FSocket* AcceptedSocket;
+    while (AcceptedSockets.Dequeue(AcceptedSocket))
+    {
+        AcceptedSocket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(AcceptedSocket);
+    }
+}
+
+bool UTcpServerWrapper::IsRunning() const
+{
+    return !Listeners.IsEmpty();
+}
+
+void UTcpServerWrapper::Broadcast(const FString& Payload)
+{
+    if (!IsRunning())
+        return;
+
+    TArray<uint8> Data;
+    FTCHARToUTF8 Converter(*Payload, Payload.Len());
+    Data.Append((uint8*)Converter.Get(), Converter.Length());
+
+    for (auto&& Client : TcpClients)
+    {
+        if (!Client->SendData(Data))
+        {
+            // Failing clients are reaped on the next tick
+        }
+    }
+}
+
+bool UTcpServerWrapper::Tick(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_WebApiServer_TcpServerTick);
+
+    if (!IsRunning())
+        return false;
+
+    AcceptPendingConnections();
+
+    // Listeners may stop the server or disconnect clients while we pump
+    TArray<TObjectPtr<UTcpClientWrapper>> Clients = TcpClients.Array();
+    TArray<TObjectPtr<UTcpClientWrapper>> Disconnected;
+    for (auto&& Client : Clients)
+    {
+        Client->MaxMessageSize = MaxMessageSize;
+        if (!Client->Pump())
+            Disconnected.Add(Client);
+    }
+
+    for (UTcpClientWrapper* Client : Disconnected)
+    {
+        if (TcpClients.Remove(Client) > 0)
+            OnClientDisconnect.Broadcast(this, Client);
+    }
+
+    return IsRunning();
+}
+
+void UTcpServerWrapper::AcceptPendingConnections()
+{
+    // Listeners of OnClientConnect may stop the server
+    FSocket* ClientSocket;
+    while (IsRunning() && AcceptedSockets.Dequeue(ClientSocket))
+    {
+        UTcpClientWrapper* NewClient = NewObject<UTcpClientWrapper>(this);
+        NewClient->Initialize(this, ClientSocket);
+        TcpClients.Add(NewClient);
+
+        OnClientConnect.Broadcast(this, NewClient);
+    }
+}
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Messaging/ClientInterestGrid.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FClientInterestGridLocationTest, "WebApiServer.InterestGrid.Location",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FClientInterestGridLocationTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UObject> Near(NewObject<UTestMessageSender>());
+    TStrongObjectPtr<UObject> Far(NewObject<UTestMessageSender>());
+
+    FClientInterestGrid Grid(100.0f);
+    Grid.SetInterest(Near.Get(), FVector(0.0, 0.0, 0.0), 150.0f);
+    Grid.SetInterest(Far.Get(), FVector(1000.0, 1000.0, 0.0), 50.0f);
+
+    TArray<UObject*> Clients;
+    Grid.QueryLocation(FVector(100.0, -100.0, 0.0), Clients);
+    TestTrue(TEXT("Inside the sphere, in another cell than its center"), Clients.Num() == 1 && Clients[0] == Near.Get());
+
+    Clients.Reset();
+    Grid.QueryLocation(FVector(140.0, 140.0, 0.0), Clients);
+    TestEqual(TEXT("In an overlapped cell but outside the sphere"), Clients.Num(), 0);
+
+    // Moving across cells relinks the client
+    Grid.SetInterest(Near.Get(), FVector(1000.0, 1000.0, 0.0), 150.0f);
+    Clients.Reset();
+    Grid.QueryLocation(FVector(0.0, 0.0, 0.0), Clients);
+    TestEqual(TEXT("Old location no longer matches"), Clients.Num(), 0);
+    Clients.Reset();
+    Grid.QueryLocation(FVector(1010.0, 1000.0, 0.0), Clients);
+    TestEqual(TEXT("Both at the new location"), Clients.Num(), 2);
+
+    // A radius <= 0 removes the spatial interest
+    Grid.SetInterest(Far.Get(), FVector::ZeroVector, 0.0f);
+    Clients.Reset();
+    Grid.QueryLocation(FVector(1010.0, 1000.0, 0.0), Clients);
+    TestTrue(TEXT("Interest removed"), Clients.Num() == 1 && Clients[0] == Near.Get());
+
+    Grid.RemoveClient(Near.Get());
+    Clients.Reset();
+    Grid.QueryLocation(FVector(1010.0, 1000.0, 0.0), Clients);
+    TestEqual(TEXT("Client removed"), Clients.Num(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FClientInterestGridOversizedTest, "WebApiServer.InterestGrid.Oversized",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FClientInterestGridOversizedTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UObject> Wide(NewObject<UTestMessageSender>());
+    TStrongObjectPtr<UObject> Huge(NewObject<UTestMessageSender>());
+
+    FClientInterestGrid Grid(100.0f);
+    Grid.MaxCellsPerClient = 16;
+
+    // Over the cell limit, tested on every query instead
+    Grid.SetInterest(Wide.Get(), FVector::ZeroVector, 1000.0f);
+    // Cell coordinates of this radius don't fit an int32
+    Grid.SetInterest(Huge.Get(), FVector(1e12, -1e12, 0.0), 1e30f);
+
+    TArray<UObject*> Clients;
+    Grid.QueryLocation(FVector(900.0, 0.0, 0.0), Clients);
+    TestEqual(TEXT("Both oversized spheres match"), Clients.Num(), 2);
+
+    Clients.Reset();
+    Grid.QueryLocation(FVector(5000.0, 0.0, 0.0), Clients);
+    TestTrue(TEXT("Only the huge sphere reaches that far"), Clients.Num() == 1 && Clients[0] == Huge.Get());
+
+    // Shrinking back under the limit indexes the client in the grid again
+    Grid.SetInterest(Wide.Get(), FVector::ZeroVector, 50.0f);
+    Grid.SetInterest(Huge.Get(), FVector::ZeroVector, 0.0f);
+    Clients.Reset();
+    Grid.QueryLocation(FVector(10.0, 10.0, 0.0), Clients);
+    TestTrue(TEXT("Indexed again"), Clients.Num() == 1 && Clients[0] == Wide.Get());
+
+    Grid.Reset();
+    TestEqual(TEXT("Reset"), Grid.Num(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FClientInterestGridTagsTest, "WebApiServer.InterestGrid.Tags",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FClientInterestGridTagsTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UObject> First(NewObject<UTestMessageSender>());
+    TStrongObjectPtr<UObject> Second(NewObject<UTestMessageSender>());
+
+    FClientInterestGrid Grid;
+    Grid.SetTags(First.Get(), { TEXT("chat"), TEXT("score") });
+    Grid.SetTags(Second.Get(), { TEXT("score") });
+
+    TArray<UObject*> Clients;
+    Grid.QueryTag(TEXT("score"), Clients);
+    TestEqual(TEXT("Both on score"), Clients.Num(), 2);
+
+    Grid.SetTags(First.Get(), { TEXT("chat") });
+    Clients.Reset();
+    Grid.QueryTag(TEXT("score"), Clients);
+    TestTrue(TEXT("Tags replaced"), Clients.Num() == 1 && Clients[0] == Second.Get());
+
+    Clients.Reset();
+    Grid.QueryTag(TEXT("unknown"), Clients);
+    TestEqual(TEXT("Unknown tag"), Clients.Num(), 0);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
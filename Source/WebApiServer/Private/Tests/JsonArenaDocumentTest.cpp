@@ -0,0 +1,232 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Json/JsonArenaDocument.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonArenaDocumentValuesTest, "WebApiServer.Json.Arena.Values",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonArenaDocumentValuesTest::RunTest(const FString& Parameters)
+{
+    FJsonArenaDocument Document;
+    const bool bParsed = Document.Parse(TEXT(" {\"id\": 7, \"method\": \"a\\tb\\u00e9\\ud83d\\ude00\", \"params\": [true, false, null, -1.5e2, {}, []]} "));
+    TestTrue(TEXT("Parsed"), bParsed);
+    if (!bParsed)
+        return false;
+
+    const FJsonArenaView Root = Document.GetRoot();
+    TestTrue(TEXT("Root is an object"), Root.GetType() == EJsonArenaType::Object);
+    TestEqual(TEXT("Members"), Root.Num(), 3);
+
+    int32 Id = 0;
+    TestTrue(TEXT("Id read"), Root.Find(TEXT("id")).TryGetNumber(Id));
+    TestEqual(TEXT("Id"), Id, 7);
+
+    FString Method;
+    TestTrue(TEXT("Method read"), Root.Find(TEXT("method")).TryGetString(Method));
+    TestEqual(TEXT("Escapes and surrogate pairs decoded"), Method, FString(TEXT("a\tb\u00e9")) + FString(TEXT("\U0001F600")));
+
+    const FJsonArenaView Params = Root.Find(TEXT("params"));
+    TestEqual(TEXT("Elements"), Params.Num(), 6);
+    TestTrue(TEXT("true"), Params[0].AsBool());
+    TestTrue(TEXT("false"), Params[1].GetType() == EJsonArenaType::Boolean && !Params[1].AsBool());
+    TestTrue(TEXT("null"), Params[2].IsNull() && Params[2].IsValid());
+    TestEqual(TEXT("Number"), Params[3].AsNumber(), -150.0);
+    TestEqual(TEXT("Empty object"), Params[4].Num(), 0);
+    TestEqual(TEXT("Empty array"), Params[5].Num(), 0);
+    TestFalse(TEXT("Out of range"), Params[6].IsValid());
+    TestFalse(TEXT("Missing member"), Root.Find(TEXT("result")).IsValid());
+
+    // Same content as the FJsonValue the engine parser builds
+    TSharedPtr<FJsonValue> Expected;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(TEXT("{\"id\":7,\"method\":\"a\\tb\\u00e9\\ud83d\\ude00\",\"params\":[true,false,null,-150,{},[]]}"));
+    FJsonSerializer::Deserialize(Reader, Expected);
+    const TSharedPtr<FJsonValue> Converted = Root.ToJsonValue();
+    TestTrue(TEXT("Converted to FJsonValue"), Converted.IsValid() && Expected.IsValid() && FJsonValue::CompareEqual(*Converted, *Expected));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonArenaDocumentNumbersTest, "WebApiServer.Json.Arena.Numbers",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonArenaDocumentNumbersTest::RunTest(const FString& Parameters)
+{
+    const TArray<TPair<const TCHAR*, double>> Valid = {
+        { TEXT("0"), 0.0 },
+        { TEXT("-0"), 0.0 },
+        { TEXT("12"), 12.0 },
+        { TEXT("-12.25"), -12.25 },
+        { TEXT("0.5"), 0.5 },
+        { TEXT("1e3"), 1000.0 },
+        { TEXT("1E+3"), 1000.0 },
+        { TEXT("25e-2"), 0.25 },
+        { TEXT("1.5e1"), 15.0 },
+    };
+    for (const TPair<const TCHAR*, double>& Case : Valid)
+    {
+        FJsonArenaDocument Document;
+        const bool bParsed = Document.Parse(Case.Key);
+        TestTrue(*FString::Printf(TEXT("%s accepted"), Case.Key), bParsed);
+        if (bParsed)
+            TestEqual(*FString::Printf(TEXT("%s value"), Case.Key), Document.GetRoot().AsNumber(), Case.Value);
+    }
+
+    const TArray<const TCHAR*> Invalid = {
+        TEXT("1-2"), TEXT("--1"), TEXT("1e"), TEXT("1e+"), TEXT("-"), TEXT("+1"), TEXT("01"), TEXT("1."), TEXT(".5"), TEXT("1.e3"), TEXT("0x10"), TEXT("[1,-]"),
+    };
+    for (const TCHAR* Case : Invalid)
+    {
+        FJsonArenaDocument Document;
+        TestFalse(*FString::Printf(TEXT("%s rejected"), Case), Document.Parse(Case));
+        TestFalse(*FString::Printf(TEXT("%s leaves the document empty"), Case), Document.GetRoot().IsValid());
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonArenaDocumentDuplicateKeysTest, "WebApiServer.Json.Arena.DuplicateKeys",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonArenaDocumentDuplicateKeysTest::RunTest(const FString& Parameters)
+{
+    const TCHAR* Text = TEXT("{\"id\":1,\"method\":\"first\",\"id\":2}");
+
+    FJsonArenaDocument Document;
+    TestTrue(TEXT("Parsed"), Document.Parse(Text));
+
+    int32 Id = 0;
+    Document.GetRoot().Find(TEXT("id")).TryGetNumber(Id);
+    TestEqual(TEXT("Last duplicate wins"), Id, 2);
+
+    // Same answer as FJsonObject
+    TSharedPtr<FJsonObject> Object;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Text);
+    FJsonSerializer::Deserialize(Reader, Object);
+    TestEqual(TEXT("Matches FJsonObject"), Object.IsValid() ? static_cast<int32>(Object->GetNumberField(TEXT("id"))) : 0, Id);
+
+    const TSharedPtr<FJsonValue> Converted = Document.GetRoot().ToJsonValue();
+    TestEqual(TEXT("Conversion keeps the last duplicate"), Converted.IsValid() ? static_cast<int32>(Converted->AsObject()->GetNumberField(TEXT("id"))) : 0, 2);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonArenaDocumentMalformedTest, "WebApiServer.Json.Arena.Malformed",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonArenaDocumentMalformedTest::RunTest(const FString& Parameters)
+{
+    const TArray<const TCHAR*> Invalid = {
+        TEXT(""), TEXT("{"), TEXT("{\"a\"}"), TEXT("{\"a\":1,}"), TEXT("[1,]"), TEXT("[1 2]"), TEXT("\"abc"), TEXT("\"\\x\""), TEXT("tru"), TEXT("{} {}"), TEXT("{a:1}"),
+    };
+    for (const TCHAR* Case : Invalid)
+    {
+        FJsonArenaDocument Document;
+        TestFalse(*FString::Printf(TEXT("'%s' rejected"), Case), Document.Parse(Case));
+    }
+
+    // Nesting past the limit fails instead of exhausting the stack
+    FJsonArenaDocument Document;
+    TestFalse(TEXT("Deep nesting rejected"), Document.Parse(FString::ChrN(10000, TEXT('[')) + FString::ChrN(10000, TEXT(']'))));
+    TestTrue(TEXT("Moderate nesting accepted"), Document.Parse(FString::ChrN(64, TEXT('[')) + FString::ChrN(64, TEXT(']'))));
+    return true;
+}
+
+/** Forwards to the engine allocator, counting the calls made from one thread */
+class FCountingMalloc final : public FMalloc
+{
+public:
+
+    explicit FCountingMalloc(FMalloc* InInner) : Inner(InInner), ThreadId(FPlatformTLS::GetCurrentThreadId()) {}
+
+    virtual void* Malloc(SIZE_T Count, uint32 Alignment) override { CountCall(); return Inner->Malloc(Count, Alignment); }
+    virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override { CountCall(); return Inner->Realloc(Original, Count, Alignment); }
+    virtual void Free(void* Original) override { Inner->Free(Original); }
+    virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+    virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+    virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+    virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+    virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+    FMalloc* Inner;
+    uint32 ThreadId;
+    /** Only written from the counted thread */
+    int64 Allocations = 0;
+
+private:
+
+    void CountCall()
+    {
+        if (FPlatformTLS::GetCurrentThreadId() == ThreadId)
+            ++Allocations;
+    }
+};
+
+/** Parse the message Iterations times, returning the seconds spent and the allocations made */
+static double MeasureParse(int32 Iterations, TFunctionRef<bool ()> Parse, int64& OutAllocations, bool& bOutParsed)
+{
+    // Other threads keep allocating through the proxy while it is installed, it forwards everything and is never destroyed
+    static FCountingMalloc* Counter = nullptr;
+    if (Counter == nullptr)
+        Counter = new FCountingMalloc(GMalloc);
+    Counter->ThreadId = FPlatformTLS::GetCurrentThreadId();
+    Counter->Allocations = 0;
+
+    bOutParsed = true;
+    FMalloc* Previous = GMalloc;
+    GMalloc = Counter;
+    const double Start = FPlatformTime::Seconds();
+    for (int32 Index = 0; Index < Iterations; ++Index)
+        bOutParsed &= Parse();
+    const double Elapsed = FPlatformTime::Seconds() - Start;
+    GMalloc = Previous;
+
+    OutAllocations = Counter->Allocations;
+    return FMath::Max(Elapsed, 1e-6);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonArenaDocumentParseBenchmark, "WebApiServer.Benchmark.Json.Parse",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FJsonArenaDocumentParseBenchmark::RunTest(const FString& Parameters)
+{
+    constexpr int32 Iterations = 20000;
+
+    // A typical request: a few scalars, a nested object and small arrays
+    const FString Message = TEXT("{\"id\":1234,\"method\":\"actor.setTransform\",\"params\":{\"name\":\"BP_Door_C_12\",")
+        TEXT("\"location\":[1024.5,-512.25,88.0],\"rotation\":[0.0,90.0,0.0],\"scale\":[1.0,1.0,1.0],")
+        TEXT("\"tags\":[\"interactive\",\"door\",\"level_03\"],\"options\":{\"sweep\":true,\"teleport\":false,\"tolerance\":0.001}}}");
+    const double Megabytes = static_cast<double>(FTCHARToUTF8(*Message).Length()) * Iterations / (1024.0 * 1024.0);
+
+    bool bParsed;
+    int64 Allocations;
+
+    // Engine DOM, one shared allocation per value and a map per object
+    const double SharedSeconds = MeasureParse(Iterations, [&Message]()
+    {
+        TSharedPtr<FJsonObject> Object;
+        TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Message);
+        return FJsonSerializer::Deserialize(Reader, Object) && Object.IsValid();
+    }, Allocations, bParsed);
+    TestTrue(TEXT("FJsonObject parse"), bParsed);
+    AddInfo(FString::Printf(TEXT("FJsonObject: %.0f messages/s, %.2f MB/s, %.1f allocations per message"),
+        Iterations / SharedSeconds, Megabytes / SharedSeconds, static_cast<double>(Allocations) / Iterations));
+
+    // Arena document reused across messages, as the dispatcher does
+    FJsonArenaDocument Document;
+    Document.Parse(Message);
+    const double ArenaSeconds = MeasureParse(Iterations, [&Message, &Document]()
+    {
+        return Document.Parse(Message);
+    }, Allocations, bParsed);
+    TestTrue(TEXT("Arena parse"), bParsed);
+    AddInfo(FString::Printf(TEXT("FJsonArenaDocument: %.0f messages/s, %.2f MB/s, %.1f allocations per message"),
+        Iterations / ArenaSeconds, Megabytes / ArenaSeconds, static_cast<double>(Allocations) / Iterations));
+
+    TestEqual(TEXT("Warm arena does not allocate"), Allocations, static_cast<int64>(0));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
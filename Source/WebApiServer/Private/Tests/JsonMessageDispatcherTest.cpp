@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcFailPendingOnCloseTest, "WebApiServer.Dispatcher.FailPendingOnClose",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcFailPendingOnCloseTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+
+    bool bCompleted = false;
+    FString CompletionError;
+    Dispatcher->SendRequest(TScriptInterface<IMessageSender>(Sender.Get()), TEXT("ping"), nullptr,
+        [&bCompleted, &CompletionError](bool bSuccess, const TSharedPtr<FJsonValue>& Result, const FString& Error)
+        {
+            bCompleted = !bSuccess;
+            CompletionError = Error;
+        }, 60.0f);
+    TestFalse(TEXT("Waiting for the response"), bCompleted);
+
+    // The request fails as soon as the connection closes instead of waiting for its timeout
+    Sender->ClosedDelegate.Broadcast();
+    TestTrue(TEXT("Failed on close"), bCompleted);
+    TestEqual(TEXT("Error"), CompletionError, FString(TEXT("disconnected")));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcAdaptiveTimeoutTest, "WebApiServer.Dispatcher.AdaptiveTimeout",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcAdaptiveTimeoutTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+
+    // Fixed timeouts, including the default one, are kept as they are
+    TestEqual(TEXT("Fixed timeout"), Dispatcher->GetRequestTimeout(MessageSender, 5.0f), 5.0f);
+
+    // Opting in without a round trip measurement waits the longest adaptive timeout
+    Dispatcher->MaxAdaptiveTimeout = 7.0f;
+    TestEqual(TEXT("Adaptive without a measurement"), Dispatcher->GetRequestTimeout(MessageSender, JSONRPC_ADAPTIVE_TIMEOUT), 7.0f);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
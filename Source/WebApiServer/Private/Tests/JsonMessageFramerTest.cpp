@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Json/JsonMessageFramer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Feed the text split in fragments of FragmentSize bytes, collecting the messages and the worst result */
+static EJsonFramerResult FeedText(FJsonMessageFramer& Framer, const FString& Text, int32 FragmentSize, TArray<FString>& OutMessages)
+{
+    FTCHARToUTF8 Converter(*Text, Text.Len());
+    const uint8* Bytes = reinterpret_cast<const uint8*>(Converter.Get());
+
+    EJsonFramerResult Result = EJsonFramerResult::Ok;
+    for (int32 Offset = 0; Offset < Converter.Length(); Offset += FragmentSize)
+    {
+        const int32 Count = FMath::Min(FragmentSize, Converter.Length() - Offset);
+        const EJsonFramerResult FragmentResult = Framer.Feed(Bytes + Offset, Count, [&OutMessages](const FString& Message)
+        {
+            OutMessages.Add(Message);
+        });
+
+        if (FragmentResult == EJsonFramerResult::Oversized || Result == EJsonFramerResult::Ok)
+            Result = FragmentResult;
+    }
+    return Result;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonMessageFramerSplitTest, "WebApiServer.Framing.JsonMessage.Split",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonMessageFramerSplitTest::RunTest(const FString& Parameters)
+{
+    // Braces and brackets inside strings, escaped quotes and nested containers must not end a message early
+    const TArray<FString> Expected = {
+        TEXT("{\"method\":\"a\",\"params\":{\"s\":\"}]\\\"{\"}}"),
+        TEXT("[1,[2,{\"x\":[]}]]"),
+        TEXT("{\"params\":\"\u00e9\u4e2d\"}"),
+    };
+    const FString Text = Expected[0] + TEXT("\r\n") + Expected[1] + TEXT(" ") + Expected[2];
+
+    for (int32 FragmentSize : { 1, 3, 7, 1024 })
+    {
+        FJsonMessageFramer Framer;
+        TArray<FString> Messages;
+        const EJsonFramerResult Result = FeedText(Framer, Text, FragmentSize, Messages);
+
+        TestTrue(*FString::Printf(TEXT("Fragments of %d: Ok"), FragmentSize), Result == EJsonFramerResult::Ok);
+        TestTrue(*FString::Printf(TEXT("Fragments of %d: messages"), FragmentSize), Messages == Expected);
+        TestFalse(*FString::Printf(TEXT("Fragments of %d: nothing pending"), FragmentSize), Framer.IsInMessage());
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonMessageFramerOversizedTest, "WebApiServer.Framing.JsonMessage.Oversized",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonMessageFramerOversizedTest::RunTest(const FString& Parameters)
+{
+    const FString Big = FString::Printf(TEXT("{\"params\":\"%s\"}"), *FString::ChrN(100, TEXT('x')));
+    const FString Small = TEXT("{\"method\":\"a\"}");
+
+    for (int32 FragmentSize : { 5, 1024 })
+    {
+        FJsonMessageFramer Framer;
+        Framer.MaxMessageSize = 64;
+
+        TArray<FString> Messages;
+        const EJsonFramerResult Result = FeedText(Framer, Small + Big + Small, FragmentSize, Messages);
+
+        TestTrue(*FString::Printf(TEXT("Fragments of %d: oversized reported"), FragmentSize), Result == EJsonFramerResult::Oversized);
+        TestTrue(*FString::Printf(TEXT("Fragments of %d: messages around it kept"), FragmentSize), Messages == TArray<FString>{ Small, Small });
+        TestTrue(*FString::Printf(TEXT("Fragments of %d: nothing stored"), FragmentSize), Framer.GetBufferedSize() <= 64);
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonMessageFramerSkippedTest, "WebApiServer.Framing.JsonMessage.Skipped",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonMessageFramerSkippedTest::RunTest(const FString& Parameters)
+{
+    const FString First = TEXT("{\"method\":\"a\"}");
+    const FString Second = TEXT("[{\"method\":\"b\"}]");
+
+    // A bad prefix and garbage between messages are skipped, the messages after them still come out
+    FJsonMessageFramer Framer;
+    TArray<FString> Messages;
+    EJsonFramerResult Result = FeedText(Framer, TEXT("garbage ") + First + TEXT(" 42 null ") + Second, 1024, Messages);
+
+    TestTrue(TEXT("Skipped reported"), Result == EJsonFramerResult::Skipped);
+    TestTrue(TEXT("Messages behind the garbage"), Messages == TArray<FString>{ First, Second });
+
+    // Clean input afterwards is Ok again
+    Messages.Reset();
+    Result = FeedText(Framer, First, 1024, Messages);
+    TestTrue(TEXT("Ok after skipping"), Result == EJsonFramerResult::Ok);
+    TestTrue(TEXT("Message after skipping"), Messages == TArray<FString>{ First });
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
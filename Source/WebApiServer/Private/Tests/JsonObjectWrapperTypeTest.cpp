@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Json/JsonObjectWrapperType.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static TSharedPtr<FJsonValue> MakeNumberArray(int32 Count)
+{
+    TArray<TSharedPtr<FJsonValue>> Elements;
+    Elements.Reserve(Count);
+    for (int32 Index = 0; Index < Count; ++Index)
+        Elements.Add(MakeShared<FJsonValueNumber>(Index));
+    return MakeShared<FJsonValueArray>(MoveTemp(Elements));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonObjectWrapperArrayTest, "WebApiServer.Json.Wrapper.Array",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonObjectWrapperArrayTest::RunTest(const FString& Parameters)
+{
+    // Past the preformatted key range too
+    for (int32 Count : { 0, 3, 5000 })
+    {
+        const TSharedPtr<FJsonValue> Array = MakeNumberArray(Count);
+        const FJsonObjectWrapper Wrapper = ToJsonWrapper(Array);
+        TestTrue(*FString::Printf(TEXT("%d elements: wrapper object"), Count), Wrapper.JsonObject.IsValid());
+        if (!Wrapper.JsonObject.IsValid())
+            continue;
+
+        TestEqual(*FString::Printf(TEXT("%d elements: keys"), Count), Wrapper.JsonObject->Values.Num(), Count);
+        if (Count > 0)
+            TestEqual(*FString::Printf(TEXT("%d elements: last key"), Count), Wrapper.JsonObject->GetNumberField(FString::FromInt(Count - 1)), static_cast<double>(Count - 1));
+
+        const TSharedPtr<FJsonValue> RoundTrip = FromJsonWrapper(Wrapper, EJsonObjectWrapperType::JOWT_Array);
+        TestTrue(*FString::Printf(TEXT("%d elements: round trip"), Count), RoundTrip.IsValid() && FJsonValue::CompareEqual(*RoundTrip, *Array));
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonObjectWrapperSparseTest, "WebApiServer.Json.Wrapper.Sparse",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonObjectWrapperSparseTest::RunTest(const FString& Parameters)
+{
+    // Holes become null, keys that are not plain indices are ignored
+    FJsonObjectWrapper Wrapper;
+    Wrapper.JsonObject = MakeShared<FJsonObject>();
+    Wrapper.JsonObject->SetNumberField(TEXT("3"), 3);
+    Wrapper.JsonObject->SetNumberField(TEXT("0"), 0);
+    Wrapper.JsonObject->SetStringField(TEXT("name"), TEXT("ignored"));
+    Wrapper.JsonObject->SetStringField(TEXT("-1"), TEXT("ignored"));
+    Wrapper.JsonObject->SetStringField(TEXT("99999999999"), TEXT("ignored"));
+
+    const TSharedPtr<FJsonValue> Value = FromJsonWrapper(Wrapper, EJsonObjectWrapperType::JOWT_Array);
+    TestTrue(TEXT("Array"), Value.IsValid() && Value->Type == EJson::Array);
+    if (!Value.IsValid() || Value->Type != EJson::Array)
+        return false;
+
+    const TArray<TSharedPtr<FJsonValue>>& Elements = Value->AsArray();
+    TestEqual(TEXT("Sized by the highest index"), Elements.Num(), 4);
+    if (Elements.Num() == 4)
+    {
+        TestEqual(TEXT("First"), Elements[0]->AsNumber(), 0.0);
+        TestTrue(TEXT("Hole is null"), Elements[1]->IsNull() && Elements[2]->IsNull());
+        TestEqual(TEXT("Last"), Elements[3]->AsNumber(), 3.0);
+    }
+
+    // Scalars go through the "value" field
+    const FJsonObjectWrapper ScalarWrapper = ToJsonWrapper(MakeShared<FJsonValueString>(TEXT("Hello")));
+    const TSharedPtr<FJsonValue> Scalar = FromJsonWrapper(ScalarWrapper, EJsonObjectWrapperType::JOWT_Value);
+    TestEqual(TEXT("Scalar round trip"), Scalar.IsValid() ? Scalar->AsString() : FString(), FString(TEXT("Hello")));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonObjectWrapperBenchmark, "WebApiServer.Benchmark.Json.WrapperArray",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FJsonObjectWrapperBenchmark::RunTest(const FString& Parameters)
+{
+    constexpr int32 Iterations = 20;
+
+    for (int32 Count : { 1000, 100000 })
+    {
+        const TSharedPtr<FJsonValue> Array = MakeNumberArray(Count);
+
+        double ToSeconds = 0.0;
+        double FromSeconds = 0.0;
+        bool bRoundTrip = true;
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            double Start = FPlatformTime::Seconds();
+            const FJsonObjectWrapper Wrapper = ToJsonWrapper(Array);
+            ToSeconds += FPlatformTime::Seconds() - Start;
+
+            Start = FPlatformTime::Seconds();
+            const TSharedPtr<FJsonValue> RoundTrip = FromJsonWrapper(Wrapper, EJsonObjectWrapperType::JOWT_Array);
+            FromSeconds += FPlatformTime::Seconds() - Start;
+
+            bRoundTrip &= RoundTrip.IsValid() && RoundTrip->AsArray().Num() == Count;
+        }
+
+        TestTrue(*FString::Printf(TEXT("%d elements: round trip"), Count), bRoundTrip);
+        AddInfo(FString::Printf(TEXT("%d elements: ToJsonWrapper %.3f ms, FromJsonWrapper %.3f ms, %.1f ns per element"),
+            Count, ToSeconds * 1000.0 / Iterations, FromSeconds * 1000.0 / Iterations,
+            (ToSeconds + FromSeconds) * 1e9 / (static_cast<double>(Iterations) * Count)));
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
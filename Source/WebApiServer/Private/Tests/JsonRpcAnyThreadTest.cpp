@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Async/Async.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Completion of a request sent off the game thread */
+struct FAnyThreadTestResult
+{
+    int32 Calls = 0;
+    bool bSuccess = false;
+    bool bOnGameThread = false;
+    FString Value;
+};
+
+static FJsonRpcResponseHandlerLambda MakeRecordingHandler(const TSharedRef<FAnyThreadTestResult>& Result)
+{
+    return [Result](bool bSuccess, const TSharedPtr<FJsonValue>& Value, const FString& Error)
+    {
+        ++Result->Calls;
+        Result->bSuccess = bSuccess;
+        Result->bOnGameThread = IsInGameThread();
+        Result->Value = bSuccess ? Value->AsString() : Error;
+    };
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcAnyThreadSendTest, "WebApiServer.Dispatcher.AnyThread.Send",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcAnyThreadSendTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+    const TSharedRef<FAnyThreadTestResult> Result = MakeShared<FAnyThreadTestResult>();
+
+    Async(EAsyncExecution::Thread, [Dispatcher = Dispatcher.Get(), MessageSender, Result]()
+    {
+        Dispatcher->SendNotificationAnyThread(MessageSender, TEXT("progress"), MakeShared<FJsonValueNumber>(1));
+        Dispatcher->SendRequestAnyThread(MessageSender, TEXT("confirm"), nullptr, MakeRecordingHandler(Result));
+    }).Wait();
+
+    // Only sent from the game thread, in the order queued
+    TestEqual(TEXT("Nothing sent from the worker"), Sender->Messages.Num(), 0);
+    Dispatcher->FlushOutboundQueue();
+    if (!TestEqual(TEXT("Both sent on flush"), Sender->Messages.Num(), 2))
+        return false;
+    TestEqual(TEXT("Notification"), Sender->Messages[0], FString(TEXT("{\"method\":\"progress\",\"params\":1}")));
+
+    TSharedPtr<FJsonObject> Request;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Sender->Messages[1]);
+    int32 RequestId = 0;
+    TestTrue(TEXT("Request"), FJsonSerializer::Deserialize(Reader, Request) && Request.IsValid()
+        && Request->GetStringField(TEXT(JSONRPC_METHOD)) == TEXT("confirm") && Request->TryGetNumberField(TEXT(JSONRPC_ID), RequestId));
+
+    // The response handler was registered by the flush
+    Dispatcher->HandleMessage(FString::Printf(TEXT("{\"id\":%d,\"result\":\"ok\"}"), RequestId), MessageSender);
+    TestEqual(TEXT("Completed once"), Result->Calls, 1);
+    TestTrue(TEXT("Completed on the game thread with the result"), Result->bSuccess && Result->bOnGameThread && Result->Value == TEXT("ok"));
+
+    // Nothing left to send
+    Dispatcher->FlushOutboundQueue();
+    TestEqual(TEXT("Queue emptied"), Sender->Messages.Num(), 2);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcAnyThreadSendFailureTest, "WebApiServer.Dispatcher.AnyThread.SendFailure",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcAnyThreadSendFailureTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    const TSharedRef<FAnyThreadTestResult> Result = MakeShared<FAnyThreadTestResult>();
+
+    // Without a sender the request fails through its handler, once on the game thread
+    Async(EAsyncExecution::Thread, [Dispatcher = Dispatcher.Get(), Result]()
+    {
+        Dispatcher->SendRequestAnyThread(TScriptInterface<IMessageSender>(), TEXT("confirm"), nullptr, MakeRecordingHandler(Result));
+    }).Wait();
+    TestEqual(TEXT("Not completed from the worker"), Result->Calls, 0);
+
+    Dispatcher->FlushOutboundQueue();
+    TestEqual(TEXT("Completed once"), Result->Calls, 1);
+    TestTrue(TEXT("Failed on the game thread"), !Result->bSuccess && Result->bOnGameThread && Result->Value == TEXT("failed_to_send_message"));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+#include "Tests/TestAsyncRequestHandler.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformProcess.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** "slow" runs one call at a time with one more queued */
+static void SetSingleSlotPolicy(UJsonMessageDispatcher* Dispatcher, float QueueTimeout)
+{
+    FJsonRpcMethodPolicy Policy;
+    Policy.MaxInFlight = 1;
+    Policy.MaxQueued = 1;
+    Policy.QueueTimeout = QueueTimeout;
+    Dispatcher->SetMethodPolicy(TEXT("slow"), Policy);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcBulkheadQueueTest, "WebApiServer.Dispatcher.Bulkhead.Queue",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcBulkheadQueueTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+    TStrongObjectPtr<UTestAsyncRequestHandler> Handler(NewObject<UTestAsyncRequestHandler>());
+    Handler->Register(Dispatcher.Get(), TEXT("slow"));
+    SetSingleSlotPolicy(Dispatcher.Get(), 10.0f);
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"slow\"}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"slow\"}"), MessageSender);
+    TestEqual(TEXT("Only the first one started"), Handler->Promises.Num(), 1);
+    TestEqual(TEXT("In flight"), Dispatcher->GetInFlightCount(TEXT("slow")), 1);
+    TestEqual(TEXT("Queued"), Dispatcher->GetQueuedCount(TEXT("slow")), 1);
+
+    // Over the queue, refused right away
+    Dispatcher->HandleMessage(TEXT("{\"id\":3,\"method\":\"slow\"}"), MessageSender);
+    TestTrue(TEXT("Busy"), Sender->Messages == TArray<FString>({ TEXT("{\"id\":3,\"error\":\"method_busy\"}") }));
+
+    // The queued request starts when the slot is given back
+    Handler->Promises[0]->ResolveWithString(TEXT("first"));
+    TestEqual(TEXT("Queued request started"), Handler->Promises.Num(), 2);
+    TestEqual(TEXT("Still one in flight"), Dispatcher->GetInFlightCount(TEXT("slow")), 1);
+    TestEqual(TEXT("Queue empty"), Dispatcher->GetQueuedCount(TEXT("slow")), 0);
+
+    Handler->Promises[1]->ResolveWithString(TEXT("second"));
+    TestTrue(TEXT("Answered in order"), Sender->Messages == TArray<FString>({ TEXT("{\"id\":3,\"error\":\"method_busy\"}"),
+        TEXT("{\"id\":1,\"result\":\"first\"}"), TEXT("{\"id\":2,\"result\":\"second\"}") }));
+    TestEqual(TEXT("Slot free"), Dispatcher->GetInFlightCount(TEXT("slow")), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcBulkheadQueueTimeoutTest, "WebApiServer.Dispatcher.Bulkhead.QueueTimeout",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcBulkheadQueueTimeoutTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+    TStrongObjectPtr<UTestAsyncRequestHandler> Handler(NewObject<UTestAsyncRequestHandler>());
+    Handler->Register(Dispatcher.Get(), TEXT("slow"));
+    SetSingleSlotPolicy(Dispatcher.Get(), 0.2f);
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"slow\"}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"slow\"}"), MessageSender);
+
+    // Kept while the timeout isn't reached
+    FTSTicker::GetCoreTicker().Tick(0.0f);
+    TestEqual(TEXT("Still queued"), Dispatcher->GetQueuedCount(TEXT("slow")), 1);
+    TestEqual(TEXT("Nothing answered"), Sender->Messages.Num(), 0);
+
+    // Expired on the first tick past it
+    FPlatformProcess::Sleep(0.3f);
+    FTSTicker::GetCoreTicker().Tick(0.0f);
+    TestEqual(TEXT("Queue emptied"), Dispatcher->GetQueuedCount(TEXT("slow")), 0);
+    TestTrue(TEXT("Timed out"), Sender->Messages == TArray<FString>({ TEXT("{\"id\":2,\"error\":\"queue_timeout\"}") }));
+
+    // The running request isn't affected and nothing runs after it
+    Handler->Promises[0]->ResolveWithString(TEXT("first"));
+    TestEqual(TEXT("Expired request never started"), Handler->Promises.Num(), 1);
+    TestTrue(TEXT("Running request answered"), Sender->Messages.Num() == 2 && Sender->Messages[1] == TEXT("{\"id\":1,\"result\":\"first\"}"));
+    TestEqual(TEXT("Slot free"), Dispatcher->GetInFlightCount(TEXT("slow")), 0);
+
+    // A request queued now gets the whole timeout again
+    Dispatcher->HandleMessage(TEXT("{\"id\":3,\"method\":\"slow\"}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"id\":4,\"method\":\"slow\"}"), MessageSender);
+    FTSTicker::GetCoreTicker().Tick(0.0f);
+    TestEqual(TEXT("New request queued"), Dispatcher->GetQueuedCount(TEXT("slow")), 1);
+    Handler->Promises[1]->ResolveWithString(TEXT("third"));
+    TestEqual(TEXT("Started before its timeout"), Handler->Promises.Num(), 3);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
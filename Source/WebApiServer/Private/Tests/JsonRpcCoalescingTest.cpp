@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+#include "Tests/TestAsyncRequestHandler.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcCoalescingFanOutTest, "WebApiServer.Dispatcher.Coalescing.FanOut",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcCoalescingFanOutTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    TStrongObjectPtr<UTestMessageSender> OtherSender(NewObject<UTestMessageSender>());
+    TStrongObjectPtr<UTestAsyncRequestHandler> Handler(NewObject<UTestAsyncRequestHandler>());
+    Handler->Register(Dispatcher.Get(), TEXT("slow"));
+
+    FJsonRpcMethodPolicy Policy;
+    Policy.bCoalesceInFlight = true;
+    Dispatcher->SetMethodPolicy(TEXT("slow"), Policy);
+
+    // Same method and params while the first one runs, from both clients
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"slow\",\"params\":{\"x\":1}}"), TScriptInterface<IMessageSender>(Sender.Get()));
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"slow\",\"params\":{\"x\":1}}"), TScriptInterface<IMessageSender>(Sender.Get()));
+    Dispatcher->HandleMessage(TEXT("{\"id\":7,\"method\":\"slow\",\"params\":{\"x\":1}}"), TScriptInterface<IMessageSender>(OtherSender.Get()));
+    // Other params run on their own
+    Dispatcher->HandleMessage(TEXT("{\"id\":3,\"method\":\"slow\",\"params\":{\"x\":2}}"), TScriptInterface<IMessageSender>(Sender.Get()));
+
+    TestEqual(TEXT("One call per distinct request"), Handler->Promises.Num(), 2);
+    TestEqual(TEXT("Nothing answered yet"), Sender->Messages.Num() + OtherSender->Messages.Num(), 0);
+
+    // One result answers every waiter, each with its own id
+    Handler->Promises[0]->ResolveWithString(TEXT("done"));
+    TestTrue(TEXT("Both requests of the sender answered"), Sender->Messages == TArray<FString>({
+        TEXT("{\"id\":1,\"result\":\"done\"}"), TEXT("{\"id\":2,\"result\":\"done\"}") }));
+    TestTrue(TEXT("Other sender answered"), OtherSender->Messages == TArray<FString>({ TEXT("{\"id\":7,\"result\":\"done\"}") }));
+
+    Handler->Promises[1]->ResolveWithString(TEXT("other"));
+    TestTrue(TEXT("Distinct request answered alone"), Sender->Messages.Num() == 3 && Sender->Messages[2] == TEXT("{\"id\":3,\"result\":\"other\"}"));
+
+    // Once completed, the same request runs the handler again
+    Dispatcher->HandleMessage(TEXT("{\"id\":4,\"method\":\"slow\",\"params\":{\"x\":1}}"), TScriptInterface<IMessageSender>(Sender.Get()));
+    TestEqual(TEXT("Not joined after completion"), Handler->Promises.Num(), 3);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcCoalescingFailureTest, "WebApiServer.Dispatcher.Coalescing.Failure",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcCoalescingFailureTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+    TStrongObjectPtr<UTestAsyncRequestHandler> Handler(NewObject<UTestAsyncRequestHandler>());
+    Handler->Register(Dispatcher.Get(), TEXT("slow"));
+
+    FJsonRpcMethodPolicy Policy;
+    Policy.bCoalesceInFlight = true;
+    Dispatcher->SetMethodPolicy(TEXT("slow"), Policy);
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"slow\"}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"slow\"}"), MessageSender);
+    TestEqual(TEXT("Joined"), Handler->Promises.Num(), 1);
+
+    // The error goes to every waiter too
+    Handler->Promises[0]->Reject(TEXT("failed"));
+    TestTrue(TEXT("Both requests failed"), Sender->Messages == TArray<FString>({
+        TEXT("{\"id\":1,\"error\":\"failed\"}"), TEXT("{\"id\":2,\"error\":\"failed\"}") }));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
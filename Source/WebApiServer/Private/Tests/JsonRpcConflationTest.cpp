@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcConflationLatestWinsTest, "WebApiServer.Dispatcher.Conflation.LatestWins",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcConflationLatestWinsTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    TStrongObjectPtr<UTestMessageSender> OtherSender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+
+    // Replaced values keep the position of the first one of their key
+    Dispatcher->SendNotificationConflated(MessageSender, TEXT("moved"), TEXT("a"), MakeShared<FJsonValueNumber>(1));
+    Dispatcher->SendNotificationConflated(MessageSender, TEXT("moved"), TEXT("b"), MakeShared<FJsonValueNumber>(10));
+    Dispatcher->SendNotificationConflated(MessageSender, TEXT("moved"), TEXT("a"), MakeShared<FJsonValueNumber>(2));
+    Dispatcher->SendNotificationConflated(MessageSender, TEXT("health"), TEXT("a"), MakeShared<FJsonValueNumber>(50));
+    Dispatcher->SendNotificationConflated(MessageSender, TEXT("moved"), TEXT("a"), MakeShared<FJsonValueNumber>(3));
+    Dispatcher->SendNotificationConflated(TScriptInterface<IMessageSender>(OtherSender.Get()), TEXT("moved"), TEXT("a"), MakeShared<FJsonValueNumber>(7));
+    TestEqual(TEXT("Held until the flush"), Sender->Messages.Num(), 0);
+
+    Dispatcher->FlushConflatedNotifications();
+    TestTrue(TEXT("Latest value per method and key, in one batch"), Sender->Messages == TArray<FString>({
+        TEXT("[{\"method\":\"moved\",\"params\":3},{\"method\":\"moved\",\"params\":10},{\"method\":\"health\",\"params\":50}]") }));
+    TestTrue(TEXT("Queued per sender, a single one sent as is"), OtherSender->Messages == TArray<FString>({ TEXT("{\"method\":\"moved\",\"params\":7}") }));
+
+    // Nothing left for the next flush
+    Dispatcher->FlushConflatedNotifications();
+    TestEqual(TEXT("Queue emptied"), Sender->Messages.Num(), 1);
+
+    Dispatcher->SendNotificationConflated(MessageSender, TEXT("moved"), TEXT("a"), MakeShared<FJsonValueNumber>(4));
+    Dispatcher->FlushConflatedNotifications();
+    TestTrue(TEXT("Next value sent"), Sender->Messages.Num() == 2 && Sender->Messages[1] == TEXT("{\"method\":\"moved\",\"params\":4}"));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
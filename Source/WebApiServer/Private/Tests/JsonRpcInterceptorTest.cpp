@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static void RegisterPingHandler(UJsonMessageDispatcher* Dispatcher)
+{
+    Dispatcher->RegisterRequestHandler(TEXT("ping"), [](const TSharedPtr<FJsonValue>& Params) -> TSharedPtr<FJsonValue>
+    {
+        return MakeShared<FJsonValueString>(TEXT("pong"));
+    });
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcInterceptorChangeDuringDispatchTest, "WebApiServer.Dispatcher.Interceptor.ChangeDuringDispatch",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcInterceptorChangeDuringDispatchTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+    RegisterPingHandler(Dispatcher.Get());
+
+    int32 FirstCalls = 0;
+    int32 SecondCalls = 0;
+    int32 FirstHandle = INDEX_NONE;
+
+    // The first interceptor replaces itself with the second one while the request goes through it
+    FJsonRpcInterceptor Second;
+    Second.OnRequest = [&SecondCalls](const FString& Method, const TSharedPtr<FJsonValue>& Params, const TScriptInterface<IMessageSender>& RequestSender, FString& OutError)
+    {
+        ++SecondCalls;
+        return true;
+    };
+    FJsonRpcInterceptor First;
+    First.OnRequest = [&FirstCalls, &FirstHandle, &Second, Dispatcher = Dispatcher.Get()](const FString& Method, const TSharedPtr<FJsonValue>& Params, const TScriptInterface<IMessageSender>& RequestSender, FString& OutError)
+    {
+        ++FirstCalls;
+        Dispatcher->AddInterceptor(Second);
+        Dispatcher->RemoveInterceptor(FirstHandle);
+        return true;
+    };
+    FirstHandle = Dispatcher->AddInterceptor(First);
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"ping\"}"), MessageSender);
+    TestEqual(TEXT("First interceptor ran"), FirstCalls, 1);
+    TestEqual(TEXT("Second interceptor waits for the next message"), SecondCalls, 0);
+    TestEqual(TEXT("Replaced"), Dispatcher->GetInterceptorCount(), 1);
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"ping\"}"), MessageSender);
+    TestEqual(TEXT("First interceptor removed"), FirstCalls, 1);
+    TestEqual(TEXT("Second interceptor ran"), SecondCalls, 1);
+
+    TestTrue(TEXT("Both requests answered"), Sender->Messages.Num() == 2
+        && Sender->Messages[0] == TEXT("{\"id\":1,\"result\":\"pong\"}") && Sender->Messages[1] == TEXT("{\"id\":2,\"result\":\"pong\"}"));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcInterceptorOutgoingTest, "WebApiServer.Dispatcher.Interceptor.Outgoing",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcInterceptorOutgoingTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+    RegisterPingHandler(Dispatcher.Get());
+
+    // Responses skip the dispatcher while no outgoing hook is installed, request hooks don't count
+    FJsonRpcInterceptor RequestOnly;
+    RequestOnly.OnRequest = [](const FString& Method, const TSharedPtr<FJsonValue>& Params, const TScriptInterface<IMessageSender>& RequestSender, FString& OutError)
+    {
+        return true;
+    };
+    Dispatcher->AddInterceptor(RequestOnly);
+    TestFalse(TEXT("No outgoing hook"), Dispatcher->HasOutgoingInterceptors());
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"ping\"}"), MessageSender);
+    TestTrue(TEXT("Sent as is"), Sender->Messages.Num() == 1 && Sender->Messages[0] == TEXT("{\"id\":1,\"result\":\"pong\"}"));
+
+    FJsonRpcInterceptor Outgoing;
+    Outgoing.OnOutgoing = [](const TScriptInterface<IMessageSender>& RequestSender, FString& Message)
+    {
+        Message = TEXT("intercepted");
+        return true;
+    };
+    const int32 OutgoingHandle = Dispatcher->AddInterceptor(Outgoing);
+    TestTrue(TEXT("Outgoing hook installed"), Dispatcher->HasOutgoingInterceptors());
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"ping\"}"), MessageSender);
+    TestTrue(TEXT("Rewritten"), Sender->Messages.Num() == 2 && Sender->Messages[1] == TEXT("intercepted"));
+
+    TestTrue(TEXT("Removed"), Dispatcher->RemoveInterceptor(OutgoingHandle));
+    TestFalse(TEXT("Back to the fast path"), Dispatcher->HasOutgoingInterceptors());
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":3,\"method\":\"ping\"}"), MessageSender);
+    TestTrue(TEXT("Sent as is again"), Sender->Messages.Num() == 3 && Sender->Messages[2] == TEXT("{\"id\":3,\"result\":\"pong\"}"));
+
+    // A null owner doesn't match the interceptors added without one
+    Dispatcher->RemoveInterceptorsFromOwner(nullptr);
+    TestEqual(TEXT("Ownerless interceptor kept"), Dispatcher->GetInterceptorCount(), 1);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Dom/JsonObject.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+#include "Dispatcher/JsonRpcResponseCache.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static TSharedPtr<FJsonValue> MakeParams(int32 A, const FString& B)
+{
+    TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+    Object->SetNumberField(TEXT("a"), A);
+    Object->SetStringField(TEXT("b"), B);
+    return MakeShared<FJsonValueObject>(Object);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcRequestKeyTest, "WebApiServer.Dispatcher.ResponseCache.Key",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcRequestKeyTest::RunTest(const FString& Parameters)
+{
+    // Member order doesn't matter, values and method do
+    TSharedPtr<FJsonObject> Reordered = MakeShared<FJsonObject>();
+    Reordered->SetStringField(TEXT("b"), TEXT("x"));
+    Reordered->SetNumberField(TEXT("a"), 1);
+
+    const FJsonRpcRequestKey Key(TEXT("m"), MakeParams(1, TEXT("x")));
+    TestTrue(TEXT("Same params in another order"), Key == FJsonRpcRequestKey(TEXT("m"), MakeShared<FJsonValueObject>(Reordered)));
+    TestEqual(TEXT("Same hash"), GetTypeHash(Key), GetTypeHash(FJsonRpcRequestKey(TEXT("m"), MakeShared<FJsonValueObject>(Reordered))));
+    TestFalse(TEXT("Other value"), Key == FJsonRpcRequestKey(TEXT("m"), MakeParams(2, TEXT("x"))));
+    TestFalse(TEXT("Other method"), Key == FJsonRpcRequestKey(TEXT("n"), MakeParams(1, TEXT("x"))));
+    TestFalse(TEXT("Missing params"), Key == FJsonRpcRequestKey(TEXT("m"), nullptr));
+    TestTrue(TEXT("Both without params"), FJsonRpcRequestKey(TEXT("m"), nullptr) == FJsonRpcRequestKey(TEXT("m"), nullptr));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcResponseCacheEntriesTest, "WebApiServer.Dispatcher.ResponseCache.Entries",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcResponseCacheEntriesTest::RunTest(const FString& Parameters)
+{
+    FJsonRpcResponseCache Cache;
+    const FJsonRpcRequestKey First(TEXT("m"), MakeParams(1, TEXT("x")));
+    const FJsonRpcRequestKey Second(TEXT("m"), MakeParams(2, TEXT("x")));
+    const FJsonRpcRequestKey Other(TEXT("n"), MakeParams(1, TEXT("x")));
+
+    Cache.Add(First, TEXT("1"), 10.0);
+    Cache.Add(Second, TEXT("2"), 20.0);
+    Cache.Add(Other, TEXT("3"), 10.0);
+    TestEqual(TEXT("Entries"), Cache.Num(), 3);
+
+    const FString* Found = Cache.Find(First, 5.0);
+    TestTrue(TEXT("Live entry found"), Found != nullptr && *Found == TEXT("1"));
+    TestNull(TEXT("Expired entry dropped"), Cache.Find(First, 10.0));
+    TestEqual(TEXT("Expired entry removed"), Cache.Num(), 2);
+
+    Cache.Invalidate(TEXT("m"));
+    TestNull(TEXT("Invalidated by method"), Cache.Find(Second, 5.0));
+    TestNotNull(TEXT("Other methods kept"), Cache.Find(Other, 5.0));
+
+    Cache.Reset();
+    TestEqual(TEXT("Reset"), Cache.Num(), 0);
+    TestEqual(TEXT("Reset bytes"), static_cast<int64>(Cache.GetUsedBytes()), static_cast<int64>(0));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcResponseCacheSizeTest, "WebApiServer.Dispatcher.ResponseCache.Size",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcResponseCacheSizeTest::RunTest(const FString& Parameters)
+{
+    // Large params count against the budget even with a tiny result
+    const FString LargeString = FString::ChrN(4096, TEXT('x'));
+    FJsonRpcResponseCache Cache;
+    Cache.Add(FJsonRpcRequestKey(TEXT("m"), MakeParams(0, LargeString)), TEXT("1"), 10.0);
+    TestTrue(TEXT("Params counted"), Cache.GetUsedBytes() >= LargeString.Len() * sizeof(TCHAR));
+
+    // Least recently used entries are evicted first
+    const SIZE_T EntrySize = Cache.GetUsedBytes();
+    Cache.Reset();
+    Cache.MaxBytes = EntrySize * 2 + EntrySize / 2;
+
+    const FJsonRpcRequestKey A(TEXT("m"), MakeParams(1, LargeString));
+    const FJsonRpcRequestKey B(TEXT("m"), MakeParams(2, LargeString));
+    const FJsonRpcRequestKey C(TEXT("m"), MakeParams(3, LargeString));
+    Cache.Add(A, TEXT("1"), 10.0);
+    Cache.Add(B, TEXT("1"), 10.0);
+    Cache.Find(A, 0.0);
+    Cache.Add(C, TEXT("1"), 10.0);
+
+    TestNotNull(TEXT("Recently used kept"), Cache.Find(A, 0.0));
+    TestNull(TEXT("Least recently used evicted"), Cache.Find(B, 0.0));
+    TestNotNull(TEXT("Newest kept"), Cache.Find(C, 0.0));
+    TestTrue(TEXT("Within budget"), Cache.GetUsedBytes() <= Cache.MaxBytes);
+
+    // An entry over the whole budget is not stored
+    Cache.MaxBytes = 64;
+    Cache.Add(FJsonRpcRequestKey(TEXT("m"), MakeParams(4, LargeString)), TEXT("1"), 10.0);
+    TestNull(TEXT("Oversized entry skipped"), Cache.Find(FJsonRpcRequestKey(TEXT("m"), MakeParams(4, LargeString)), 0.0));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcResponseCacheOverrideTest, "WebApiServer.Dispatcher.ResponseCache.Override",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcResponseCacheOverrideTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    TStrongObjectPtr<UObject> Owner(NewObject<UTestMessageSender>());
+
+    FJsonRpcMethodPolicy Policy;
+    Policy.bCacheResponses = true;
+    Policy.CacheTimeToLive = 60.0f;
+    Dispatcher->SetMethodPolicy(TEXT("version"), Policy);
+
+    const auto RegisterVersion = [&Dispatcher, &Owner](int32 Version, bool bOverride)
+    {
+        const FJsonRpcRequestHandlerLambda Handler = [Version](const TSharedPtr<FJsonValue>&)
+        {
+            return MakeShared<FJsonValueNumber>(Version);
+        };
+        Dispatcher->RegisterRequestHandler(TEXT("version"), Handler, Owner.Get(), bOverride);
+    };
+    const auto Call = [&Dispatcher, &Sender]()
+    {
+        Sender->Messages.Reset();
+        Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"version\",\"params\":[]}"), TScriptInterface<IMessageSender>(Sender.Get()));
+        return Sender->Messages.Num() == 1 ? Sender->Messages[0] : FString();
+    };
+
+    RegisterVersion(1, false);
+    TestEqual(TEXT("First handler"), Call(), FString(TEXT("{\"id\":1,\"result\":1}")));
+    TestEqual(TEXT("Cached"), Call(), FString(TEXT("{\"id\":1,\"result\":1}")));
+
+    RegisterVersion(2, true);
+    TestEqual(TEXT("Override invalidates the cache"), Call(), FString(TEXT("{\"id\":1,\"result\":2}")));
+
+    Dispatcher->UnregisterRequestHandlersFromOwner(Owner.Get());
+    RegisterVersion(3, false);
+    TestEqual(TEXT("Unregistering by owner invalidates the cache"), Call(), FString(TEXT("{\"id\":1,\"result\":3}")));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
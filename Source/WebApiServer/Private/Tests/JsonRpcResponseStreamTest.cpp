@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Containers/Ticker.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** "count" streams the numbers up to its params, Produced counts the calls of the producer */
+static void RegisterCountingStream(UJsonMessageDispatcher* Dispatcher, const TSharedRef<int32>& Produced)
+{
+    Dispatcher->RegisterStreamingRequestHandler(TEXT("count"), [Produced](const TSharedPtr<FJsonValue>& Params)
+    {
+        const int32 Total = static_cast<int32>(Params->AsNumber());
+        TSharedRef<int32> Next = MakeShared<int32>(0);
+        return FJsonRpcChunkProducer([Produced, Total, Next](TSharedPtr<FJsonValue>& OutChunk, FString& OutError)
+        {
+            ++*Produced;
+            if (*Next >= Total)
+                return false;
+            OutChunk = MakeShared<FJsonValueNumber>((*Next)++);
+            return true;
+        });
+    });
+}
+
+static int32 CountChunks(const UTestMessageSender* Sender)
+{
+    return Sender->Messages.FilterByPredicate([](const FString& Message) { return Message.Contains(TEXT("\"" JSONRPC_CHUNK "\"")); }).Num();
+}
+
+/** Runs the dispatcher tick, where the streams waiting for the connection or for credits are pumped */
+static void TickStreams(int32 Ticks = 1)
+{
+    for (int32 Tick = 0; Tick < Ticks; ++Tick)
+        FTSTicker::GetCoreTicker().Tick(0.0f);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcStreamCreditTest, "WebApiServer.Dispatcher.Stream.Credit",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcStreamCreditTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+    Dispatcher->MaxStreamChunksPerTick = 2;
+    RegisterCountingStream(Dispatcher.Get(), MakeShared<int32>(0));
+
+    // Without credits the stream is only paced by the connection and the per tick cap
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"count\",\"params\":100}"), MessageSender);
+    TestEqual(TEXT("First chunks"), CountChunks(Sender.Get()), 2);
+
+    // Credits count the chunks already sent, one more is allowed
+    Dispatcher->HandleMessage(TEXT("{\"method\":\"" JSONRPC_STREAM_CREDIT "\",\"params\":{\"id\":1,\"chunks\":3}}"), MessageSender);
+    TickStreams(5);
+    TestEqual(TEXT("Stopped at zero credits"), CountChunks(Sender.Get()), 3);
+    TestEqual(TEXT("Still active"), Dispatcher->GetActiveStreamCount(), 1);
+
+    Dispatcher->HandleMessage(TEXT("{\"method\":\"" JSONRPC_STREAM_CREDIT "\",\"params\":{\"id\":1,\"chunks\":4}}"), MessageSender);
+    TickStreams(5);
+    TestEqual(TEXT("Resumed on credit"), CountChunks(Sender.Get()), 7);
+
+    // Credits of another stream id don't apply
+    Dispatcher->HandleMessage(TEXT("{\"method\":\"" JSONRPC_STREAM_CREDIT "\",\"params\":{\"id\":2,\"chunks\":4}}"), MessageSender);
+    TickStreams(5);
+    TestEqual(TEXT("Other id ignored"), CountChunks(Sender.Get()), 7);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcStreamCollectedCapTest, "WebApiServer.Dispatcher.Stream.CollectedCap",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcStreamCollectedCapTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    Sender->bCanStreamResponses = false;
+    Dispatcher->MaxStreamChunksPerTick = 4;
+    const TSharedRef<int32> Produced = MakeShared<int32>(0);
+    RegisterCountingStream(Dispatcher.Get(), Produced);
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"count\",\"params\":10}"), TScriptInterface<IMessageSender>(Sender.Get()));
+    TestEqual(TEXT("Capped on the request"), *Produced, 4);
+    TestEqual(TEXT("Nothing sent while collecting"), Sender->Messages.Num(), 0);
+
+    TickStreams();
+    TestEqual(TEXT("Capped on the next tick"), *Produced, 8);
+    TestEqual(TEXT("Still collecting"), Sender->Messages.Num(), 0);
+
+    // 10 chunks, then the call ending the stream
+    TickStreams();
+    TestEqual(TEXT("Producer calls"), *Produced, 11);
+    TestTrue(TEXT("One result with every chunk"), Sender->Messages.Num() == 1 && Sender->Messages[0].Contains(TEXT("[0,1,2,3,4,5,6,7,8,9]")));
+    TestEqual(TEXT("Stream done"), Dispatcher->GetActiveStreamCount(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcStreamSenderClosedTest, "WebApiServer.Dispatcher.Stream.SenderClosed",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcStreamSenderClosedTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    TStrongObjectPtr<UTestMessageSender> OtherSender(NewObject<UTestMessageSender>());
+    Dispatcher->MaxStreamChunksPerTick = 1;
+    RegisterCountingStream(Dispatcher.Get(), MakeShared<int32>(0));
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"count\",\"params\":100}"), TScriptInterface<IMessageSender>(Sender.Get()));
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"count\",\"params\":100}"), TScriptInterface<IMessageSender>(OtherSender.Get()));
+    TestEqual(TEXT("Both streaming"), Dispatcher->GetActiveStreamCount(), 2);
+
+    Sender->ClosedDelegate.Broadcast();
+    TestEqual(TEXT("Stream of the closed sender dropped"), Dispatcher->GetActiveStreamCount(), 1);
+
+    const int32 SentBeforeTick = CountChunks(Sender.Get());
+    TickStreams();
+    TestEqual(TEXT("Nothing more sent to the closed sender"), CountChunks(Sender.Get()), SentBeforeTick);
+    TestEqual(TEXT("Other stream goes on"), CountChunks(OtherSender.Get()), 2);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Calls of the handlers, appended from the shard threads and the game thread */
+struct FShardTestCalls
+{
+    FCriticalSection Lock;
+    TArray<int32> Ids;
+    TArray<bool> OnGameThread;
+
+    void Add(int32 Id)
+    {
+        FScopeLock ScopeLock(&Lock);
+        Ids.Add(Id);
+        OnGameThread.Add(IsInGameThread());
+    }
+
+    int32 Num()
+    {
+        FScopeLock ScopeLock(&Lock);
+        return Ids.Num();
+    }
+};
+
+/** Tick the dispatcher until the handlers ran Count times, false after a few seconds */
+static bool PumpShardsUntil(FShardTestCalls& Calls, int32 Count)
+{
+    const double Deadline = FPlatformTime::Seconds() + 5.0;
+    while (Calls.Num() < Count)
+    {
+        if (FPlatformTime::Seconds() > Deadline)
+            return false;
+        FPlatformProcess::Sleep(0.001f);
+        FTSTicker::GetCoreTicker().Tick(0.0f);
+    }
+    return true;
+}
+
+/** "echo" runs on the shards, "bound" is handed back to the game thread */
+static void RegisterShardTestHandlers(UJsonMessageDispatcher* Dispatcher, FShardTestCalls& Calls)
+{
+    const auto Handler = [&Calls](const TSharedPtr<FJsonValue>& Params)
+    {
+        Calls.Add(static_cast<int32>(Params->AsNumber()));
+        return Params;
+    };
+    Dispatcher->RegisterRequestHandler(TEXT("echo"), Handler);
+    Dispatcher->RegisterRequestHandler(TEXT("bound"), Handler);
+
+    FJsonRpcMethodPolicy Policy;
+    Policy.bGameThreadBound = true;
+    Dispatcher->SetMethodPolicy(TEXT("bound"), Policy);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcShardOrderTest, "WebApiServer.Dispatcher.Shards.Order",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcShardOrderTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+
+    FShardTestCalls Calls;
+    RegisterShardTestHandlers(Dispatcher.Get(), Calls);
+    Dispatcher->StartShards(2);
+
+    // The messages behind the one handed back wait for it, even though a shard could run them
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"echo\",\"params\":1}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"bound\",\"params\":2}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"id\":3,\"method\":\"echo\",\"params\":3}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"id\":4,\"method\":\"echo\",\"params\":4}"), MessageSender);
+
+    TestTrue(TEXT("Every request handled"), PumpShardsUntil(Calls, 4));
+    Dispatcher->StopShards();
+
+    TestTrue(TEXT("Handled in the order received"), Calls.Ids == TArray<int32>({ 1, 2, 3, 4 }));
+    TestTrue(TEXT("Threads"), Calls.OnGameThread == TArray<bool>({ false, true, true, true }));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcShardDrainOnCloseTest, "WebApiServer.Dispatcher.Shards.DrainOnClose",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcShardDrainOnCloseTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+
+    FShardTestCalls Calls;
+    RegisterShardTestHandlers(Dispatcher.Get(), Calls);
+    Dispatcher->StartShards(2);
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"bound\",\"params\":1}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"echo\",\"params\":2}"), MessageSender);
+
+    // Closed while its messages wait for the game thread, they still run once and release their hold
+    Sender->ClosedDelegate.Broadcast();
+    TestTrue(TEXT("Deferred messages drained"), PumpShardsUntil(Calls, 2));
+
+    // Messages received afterwards don't queue behind the old ones
+    Dispatcher->HandleMessage(TEXT("{\"id\":3,\"method\":\"echo\",\"params\":3}"), MessageSender);
+    TestTrue(TEXT("Later message handled"), PumpShardsUntil(Calls, 3));
+    Dispatcher->StopShards();
+
+    TestTrue(TEXT("Handled in the order received"), Calls.Ids == TArray<int32>({ 1, 2, 3 }));
+    TestTrue(TEXT("Later message on a shard"), Calls.OnGameThread.Num() == 3 && !Calls.OnGameThread[2]);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcSnapshotPerFrameTest, "WebApiServer.Dispatcher.Snapshot.PerFrame",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcSnapshotPerFrameTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    TStrongObjectPtr<UTestMessageSender> OtherSender(NewObject<UTestMessageSender>());
+
+    int32 Produced = 0;
+    Dispatcher->RegisterSnapshotProducer(TEXT("state"), [&Produced]()
+    {
+        ++Produced;
+        TSharedPtr<FJsonObject> State = MakeShared<FJsonObject>();
+        State->SetNumberField(TEXT("build"), Produced);
+        return MakeShared<FJsonValueObject>(State);
+    });
+    TestTrue(TEXT("Registered"), Dispatcher->RegisterSnapshotRequestHandler(TEXT("getState"), TEXT("state")));
+
+    // Every request of the frame is answered from one build
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"getState\"}"), TScriptInterface<IMessageSender>(Sender.Get()));
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"getState\"}"), TScriptInterface<IMessageSender>(Sender.Get()));
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"getState\"}"), TScriptInterface<IMessageSender>(OtherSender.Get()));
+    TestEqual(TEXT("Built once"), Produced, 1);
+    TestTrue(TEXT("Same snapshot for the sender"), Sender->Messages == TArray<FString>({
+        TEXT("{\"id\":1,\"result\":{\"build\":1}}"), TEXT("{\"id\":2,\"result\":{\"build\":1}}") }));
+    TestTrue(TEXT("Same snapshot for the other sender"), OtherSender->Messages == TArray<FString>({ TEXT("{\"id\":1,\"result\":{\"build\":1}}") }));
+
+    FString Serialized;
+    TestTrue(TEXT("Read directly"), Dispatcher->GetSerializedSnapshot(TEXT("state"), Serialized));
+    TestEqual(TEXT("Reused when read directly"), Produced, 1);
+    TestEqual(TEXT("Serialized value"), Serialized, FString(TEXT("{\"build\":1}")));
+
+    // Built again on the next frame
+    ++GFrameCounter;
+    Dispatcher->HandleMessage(TEXT("{\"id\":3,\"method\":\"getState\"}"), TScriptInterface<IMessageSender>(Sender.Get()));
+    TestEqual(TEXT("Rebuilt"), Produced, 2);
+    TestTrue(TEXT("New snapshot"), Sender->Messages.Num() == 3 && Sender->Messages[2] == TEXT("{\"id\":3,\"result\":{\"build\":2}}"));
+
+    // Without its producer the request fails
+    Dispatcher->UnregisterSnapshotProducer(TEXT("state"));
+    Dispatcher->HandleMessage(TEXT("{\"id\":4,\"method\":\"getState\"}"), TScriptInterface<IMessageSender>(Sender.Get()));
+    TestTrue(TEXT("Unavailable"), Sender->Messages.Num() == 4 && Sender->Messages[3] == TEXT("{\"id\":4,\"error\":\"snapshot state unavailable\"}"));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
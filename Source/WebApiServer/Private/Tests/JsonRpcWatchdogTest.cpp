@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "HAL/PlatformProcess.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** "slow" and "slowNotify" take 20ms, well over the budget of the tests, "fast" returns right away */
+static void RegisterWatchdogTestHandlers(UJsonMessageDispatcher* Dispatcher)
+{
+    Dispatcher->HandlerBudgetMs = 5.0f;
+    Dispatcher->RegisterRequestHandler(TEXT("slow"), [](const TSharedPtr<FJsonValue>& Params) -> TSharedPtr<FJsonValue>
+    {
+        FPlatformProcess::Sleep(0.02f);
+        return nullptr;
+    });
+    Dispatcher->RegisterRequestHandler(TEXT("fast"), [](const TSharedPtr<FJsonValue>& Params) -> TSharedPtr<FJsonValue>
+    {
+        return nullptr;
+    });
+    Dispatcher->RegisterNotificationHandler(TEXT("slowNotify"), [](const TSharedPtr<FJsonValue>& Params)
+    {
+        FPlatformProcess::Sleep(0.02f);
+    });
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcWatchdogSlowCallTest, "WebApiServer.Dispatcher.Watchdog.SlowCall",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcWatchdogSlowCallTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+    RegisterWatchdogTestHandlers(Dispatcher.Get());
+
+    const FString Request = TEXT("{\"id\":1,\"method\":\"slow\",\"params\":{\"padding\":\"xxxxxxxxxxxxxxxx\"}}");
+    const FString Notification = TEXT("{\"method\":\"slowNotify\"}");
+    const FString Batch = TEXT("[{\"id\":2,\"method\":\"fast\"},{\"id\":3,\"method\":\"slow\"}]");
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":4,\"method\":\"fast\"}"), MessageSender);
+    TestEqual(TEXT("Fast call not recorded"), Dispatcher->GetSlowCallCount(), 0);
+
+    Dispatcher->HandleMessage(Request, MessageSender);
+    Dispatcher->HandleMessage(Notification, MessageSender);
+    Dispatcher->HandleMessage(Batch, MessageSender);
+
+    const TArray<FJsonRpcSlowCall> SlowCalls = Dispatcher->GetSlowCalls();
+    if (!TestEqual(TEXT("Slow calls recorded"), SlowCalls.Num(), 3))
+        return false;
+
+    // Sized on the raw message, not on the params
+    TestEqual(TEXT("Request method"), SlowCalls[0].Method, FString(TEXT("slow")));
+    TestFalse(TEXT("Request"), SlowCalls[0].bNotification);
+    TestEqual(TEXT("Request message size"), SlowCalls[0].MessageSize, Request.Len());
+    TestTrue(TEXT("Request duration over the budget"), SlowCalls[0].DurationMs > Dispatcher->HandlerBudgetMs);
+
+    TestEqual(TEXT("Notification method"), SlowCalls[1].Method, FString(TEXT("slowNotify")));
+    TestTrue(TEXT("Notification"), SlowCalls[1].bNotification);
+    TestEqual(TEXT("Notification message size"), SlowCalls[1].MessageSize, Notification.Len());
+
+    // Only the slow element of the batch, with the size of the whole batch
+    TestEqual(TEXT("Batched method"), SlowCalls[2].Method, FString(TEXT("slow")));
+    TestEqual(TEXT("Batch message size"), SlowCalls[2].MessageSize, Batch.Len());
+
+    // Disabled at 0
+    Dispatcher->ClearSlowCalls();
+    Dispatcher->HandlerBudgetMs = 0.0f;
+    Dispatcher->HandleMessage(Request, MessageSender);
+    TestEqual(TEXT("Nothing recorded without a budget"), Dispatcher->GetSlowCallCount(), 0);
+    TestEqual(TEXT("Cleared"), Dispatcher->GetSlowCalls().Num(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcWatchdogHistoryTest, "WebApiServer.Dispatcher.Watchdog.History",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcWatchdogHistoryTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+    RegisterWatchdogTestHandlers(Dispatcher.Get());
+    Dispatcher->SlowCallHistorySize = 2;
+
+    Dispatcher->HandleMessage(TEXT("{\"id\":1,\"method\":\"slow\"}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"id\":2,\"method\":\"slow\",\"params\":1}"), MessageSender);
+    Dispatcher->HandleMessage(TEXT("{\"method\":\"slowNotify\"}"), MessageSender);
+
+    // The oldest record is overwritten, the count keeps every call
+    const TArray<FJsonRpcSlowCall> SlowCalls = Dispatcher->GetSlowCalls();
+    TestEqual(TEXT("Every call counted"), Dispatcher->GetSlowCallCount(), 3);
+    TestTrue(TEXT("Latest calls kept, oldest first"), SlowCalls.Num() == 2
+        && SlowCalls[0].Method == TEXT("slow") && SlowCalls[0].MessageSize == FString(TEXT("{\"id\":2,\"method\":\"slow\",\"params\":1}")).Len()
+        && SlowCalls[1].Method == TEXT("slowNotify"));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Messaging/JsonStateStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static TSharedPtr<FJsonValue> ParseJson(const FString& Text)
+{
+    TSharedPtr<FJsonValue> Value;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Text);
+    FJsonSerializer::Deserialize(Reader, Value);
+    return Value;
+}
+
+/** Json merge patch (RFC 7396) application, as a subscriber does it */
+static TSharedPtr<FJsonValue> ApplyMergePatch(const TSharedPtr<FJsonValue>& Target, const TSharedPtr<FJsonValue>& Patch)
+{
+    if (!Patch.IsValid() || Patch->Type != EJson::Object)
+        return Patch;
+
+    TSharedPtr<FJsonObject> Result = MakeShared<FJsonObject>();
+    if (Target.IsValid() && Target->Type == EJson::Object)
+        Result->Values = Target->AsObject()->Values;
+
+    for (const auto& [Name, Member] : Patch->AsObject()->Values)
+    {
+        if (Member->IsNull())
+            Result->Values.Remove(Name);
+        else
+            Result->Values.Add(Name, ApplyMergePatch(Result->Values.FindRef(Name), Member));
+    }
+    return MakeShared<FJsonValueObject>(Result);
+}
+
+/** Rebuild the state a subscriber holds from the notifications it received */
+static bool ApplyNotifications(FAutomationTestBase& Test, const TArray<FString>& Messages, TSharedPtr<FJsonValue>& InOutState, int32& InOutVersion)
+{
+    for (const FString& Message : Messages)
+    {
+        const TSharedPtr<FJsonValue> Notification = ParseJson(Message);
+        if (!Notification.IsValid() || Notification->Type != EJson::Object)
+            return false;
+
+        const TSharedPtr<FJsonObject> Params = Notification->AsObject()->GetObjectField(TEXT("params"));
+        if (Params->HasField(TEXT("snapshot")))
+        {
+            InOutState = Params->TryGetField(TEXT("snapshot"));
+        }
+        else
+        {
+            if (static_cast<int32>(Params->GetNumberField(TEXT("base"))) != InOutVersion)
+            {
+                Test.AddError(TEXT("Patch on a base the subscriber doesn't have"));
+                return false;
+            }
+            if (Params->HasField(TEXT("patch")))
+                InOutState = ApplyMergePatch(InOutState, Params->TryGetField(TEXT("patch")));
+        }
+        InOutVersion = static_cast<int32>(Params->GetNumberField(TEXT("version")));
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonStateStreamMergePatchTest, "WebApiServer.StateStream.MergePatch",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonStateStreamMergePatchTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonStateStream> Stream(UJsonStateStream::NewJsonStateStream(GetTransientPackage(), TEXT("state")));
+    TStrongObjectPtr<UTestMessageSender> Subscriber(NewObject<UTestMessageSender>());
+
+    // Large enough that patches are smaller than snapshots
+    const FString Padding = FString::ChrN(256, TEXT('p'));
+    const TArray<FString> States = {
+        FString::Printf(TEXT("{\"padding\":\"%s\",\"hp\":100,\"pos\":{\"x\":1,\"y\":2},\"tags\":[\"a\"]}"), *Padding),
+        FString::Printf(TEXT("{\"padding\":\"%s\",\"hp\":90,\"pos\":{\"x\":1,\"y\":3},\"tags\":[\"a\"]}"), *Padding),
+        FString::Printf(TEXT("{\"padding\":\"%s\",\"hp\":90,\"pos\":{\"x\":1},\"tags\":[\"a\",\"b\"],\"new\":{\"k\":true}}"), *Padding),
+        FString::Printf(TEXT("{\"padding\":\"%s\",\"pos\":{\"x\":1},\"tags\":[],\"new\":{\"k\":true}}"), *Padding),
+    };
+
+    Stream->PublishState(ParseJson(States[0]));
+    Stream->Subscribe(TScriptInterface<IMessageSender>(Subscriber.Get()));
+
+    TSharedPtr<FJsonValue> State;
+    int32 Version = 0;
+    for (int32 Index = 1; Index < States.Num(); ++Index)
+        Stream->PublishState(ParseJson(States[Index]));
+
+    TestEqual(TEXT("Snapshot then one message per version"), Subscriber->Messages.Num(), States.Num());
+    TestTrue(TEXT("First message is a snapshot"), Subscriber->Messages.Num() > 0 && Subscriber->Messages[0].Contains(TEXT("\"snapshot\"")));
+    TestTrue(TEXT("Later messages are patches"), Subscriber->Messages.Num() > 1 && Subscriber->Messages[1].Contains(TEXT("\"patch\"")));
+
+    TestTrue(TEXT("Notifications applied"), ApplyNotifications(*this, Subscriber->Messages, State, Version));
+    TestEqual(TEXT("Subscriber at the last version"), Version, Stream->GetVersion());
+    TestTrue(TEXT("Subscriber state matches"), State.IsValid() && FJsonValue::CompareEqual(*State, *ParseJson(States.Last())));
+
+    // Publishing the same state again sends nothing
+    Subscriber->Messages.Reset();
+    Stream->PublishState(ParseJson(States.Last()));
+    TestEqual(TEXT("Unchanged state not sent"), Subscriber->Messages.Num(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonStateStreamNullsTest, "WebApiServer.StateStream.Nulls",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonStateStreamNullsTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonStateStream> Stream(UJsonStateStream::NewJsonStateStream(GetTransientPackage(), TEXT("state")));
+    TStrongObjectPtr<UTestMessageSender> Subscriber(NewObject<UTestMessageSender>());
+
+    // A member set to null can't be expressed as a merge patch, the subscriber gets a snapshot
+    const FString Padding = FString::ChrN(256, TEXT('p'));
+    Stream->PublishState(ParseJson(FString::Printf(TEXT("{\"padding\":\"%s\",\"target\":1}"), *Padding)));
+    Stream->Subscribe(TScriptInterface<IMessageSender>(Subscriber.Get()));
+    Stream->PublishState(ParseJson(FString::Printf(TEXT("{\"padding\":\"%s\",\"target\":null}"), *Padding)));
+
+    TestEqual(TEXT("Two messages"), Subscriber->Messages.Num(), 2);
+    TestTrue(TEXT("Null member sent as snapshot"), Subscriber->Messages.Num() == 2 && Subscriber->Messages[1].Contains(TEXT("\"snapshot\"")));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonStateStreamCopyTest, "WebApiServer.StateStream.Copy",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonStateStreamCopyTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonStateStream> Stream(UJsonStateStream::NewJsonStateStream(GetTransientPackage(), TEXT("state")));
+    TStrongObjectPtr<UTestMessageSender> Subscriber(NewObject<UTestMessageSender>());
+    Stream->Subscribe(TScriptInterface<IMessageSender>(Subscriber.Get()));
+
+    // The publisher keeps one object and modifies it in place between publications
+    TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+    Object->SetNumberField(TEXT("hp"), 100);
+    const TSharedPtr<FJsonValue> State = MakeShared<FJsonValueObject>(Object);
+    Stream->PublishState(State);
+
+    Object->SetNumberField(TEXT("hp"), 50);
+    Stream->PublishState(State);
+
+    TestEqual(TEXT("In place change detected as a new version"), Stream->GetVersion(), 2);
+    TestEqual(TEXT("Both versions sent"), Subscriber->Messages.Num(), 2);
+    TestTrue(TEXT("Second message carries the change"), Subscriber->Messages.Num() == 2 && Subscriber->Messages[1].Contains(TEXT("50")));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
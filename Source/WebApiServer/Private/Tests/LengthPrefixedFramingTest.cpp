@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Messaging/LengthPrefixedFraming.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Deliver the bytes as if they were read from the socket */
+static void ReceiveBytes(FLengthPrefixedFraming& Framing, const uint8* Data, int32 Count)
+{
+    uint8* Slack = Framing.GetReceiveSlack(Count);
+    FMemory::Memcpy(Slack, Data, Count);
+    Framing.CommitReceived(Count);
+}
+
+/** Frames queued for sending, as the peer would receive them */
+static TArray<uint8> FrameMessages(const TArray<FString>& Messages)
+{
+    FLengthPrefixedFraming Sender;
+    for (const FString& Message : Messages)
+        Sender.QueueMessage(Message);
+    return TArray<uint8>(Sender.GetPendingSendData(), Sender.GetPendingSendBytes());
+}
+
+static void AppendHeader(TArray<uint8>& Bytes, uint32 Length)
+{
+    Bytes.Add(static_cast<uint8>(Length >> 24));
+    Bytes.Add(static_cast<uint8>(Length >> 16));
+    Bytes.Add(static_cast<uint8>(Length >> 8));
+    Bytes.Add(static_cast<uint8>(Length));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLengthPrefixedFramingRoundTripTest, "WebApiServer.Framing.LengthPrefixed.RoundTrip",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLengthPrefixedFramingRoundTripTest::RunTest(const FString& Parameters)
+{
+    const TArray<FString> Messages = { TEXT("{\"method\":\"a\"}"), TEXT(""), TEXT("{\"params\":\"\u00e9\u4e2d\"}") };
+    const TArray<uint8> Bytes = FrameMessages(Messages);
+
+    // Delivered one byte at a time, frames come out whole and in order
+    FLengthPrefixedFraming Framing;
+    TArray<FString> Received;
+    for (uint8 Byte : Bytes)
+    {
+        ReceiveBytes(Framing, &Byte, 1);
+
+        FString Message;
+        while (Framing.TryReadMessage(Message) == ELengthPrefixedReadResult::Frame)
+            Received.Add(Message);
+    }
+
+    TestEqual(TEXT("Frames received"), Received.Num(), Messages.Num());
+    for (int32 Index = 0; Index < FMath::Min(Received.Num(), Messages.Num()); ++Index)
+        TestEqual(FString::Printf(TEXT("Frame %d"), Index), Received[Index], Messages[Index]);
+
+    FString Message;
+    TestTrue(TEXT("Nothing left"), Framing.TryReadMessage(Message) == ELengthPrefixedReadResult::NeedMoreData);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLengthPrefixedFramingSendBufferTest, "WebApiServer.Framing.LengthPrefixed.SendBuffer",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLengthPrefixedFramingSendBufferTest::RunTest(const FString& Parameters)
+{
+    FLengthPrefixedFraming Framing;
+    Framing.QueueMessage(TEXT("abc"));
+    TestEqual(TEXT("Header and payload pending"), Framing.GetPendingSendBytes(), LENGTH_PREFIX_SIZE + 3);
+    TestEqual(TEXT("Big-endian length"), static_cast<int32>(Framing.GetPendingSendData()[3]), 3);
+
+    Framing.ConsumeSent(2);
+    TestEqual(TEXT("Partially sent"), Framing.GetPendingSendBytes(), LENGTH_PREFIX_SIZE + 1);
+
+    Framing.ConsumeSent(LENGTH_PREFIX_SIZE + 1);
+    TestEqual(TEXT("Fully sent"), Framing.GetPendingSendBytes(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLengthPrefixedFramingOversizedTest, "WebApiServer.Framing.LengthPrefixed.Oversized",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLengthPrefixedFramingOversizedTest::RunTest(const FString& Parameters)
+{
+    FLengthPrefixedFraming Framing;
+    Framing.MaxFrameSize = 64;
+
+    // A small valid frame, then the header of a frame far over the limit and the start of its payload
+    TArray<uint8> Bytes = FrameMessages({ TEXT("small") });
+    AppendHeader(Bytes, 1024 * 1024);
+    Bytes.AddZeroed(16);
+    ReceiveBytes(Framing, Bytes.GetData(), Bytes.Num());
+
+    TestTrue(TEXT("Oversized frame behind a complete one is detected"), Framing.HasOversizedFrame());
+
+    FString Message;
+    TestTrue(TEXT("Small frame read"), Framing.TryReadMessage(Message) == ELengthPrefixedReadResult::Frame);
+    TestEqual(TEXT("Small frame payload"), Message, FString(TEXT("small")));
+    TestTrue(TEXT("Oversized frame rejected"), Framing.TryReadMessage(Message) == ELengthPrefixedReadResult::Oversized);
+
+    // Headers split across reads are checked once complete
+    FLengthPrefixedFraming SplitFraming;
+    SplitFraming.MaxFrameSize = 64;
+    TArray<uint8> SplitBytes = FrameMessages({ TEXT("a"), TEXT("b") });
+    AppendHeader(SplitBytes, 65);
+    ReceiveBytes(SplitFraming, SplitBytes.GetData(), SplitBytes.Num() - 2);
+    TestFalse(TEXT("Partial header not judged"), SplitFraming.HasOversizedFrame());
+    ReceiveBytes(SplitFraming, SplitBytes.GetData() + SplitBytes.Num() - 2, 2);
+    TestTrue(TEXT("Completed header detected"), SplitFraming.HasOversizedFrame());
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLengthPrefixedFramingReceiveBoundTest, "WebApiServer.Framing.LengthPrefixed.ReceiveBound",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLengthPrefixedFramingReceiveBoundTest::RunTest(const FString& Parameters)
+{
+    FLengthPrefixedFraming Framing;
+    Framing.MaxFrameSize = 64;
+
+    // Many small frames are all valid, but receiving stops once a maximal frame worth of bytes is buffered
+    TArray<FString> Messages;
+    for (int32 Index = 0; Index < 32; ++Index)
+        Messages.Add(TEXT("xx"));
+    const TArray<uint8> Bytes = FrameMessages(Messages);
+
+    int32 Delivered = 0;
+    while (Delivered < Bytes.Num() && !Framing.IsReceiveBufferFull())
+    {
+        ReceiveBytes(Framing, Bytes.GetData() + Delivered, 1);
+        ++Delivered;
+    }
+
+    TestFalse(TEXT("No oversized frame"), Framing.HasOversizedFrame());
+    TestTrue(TEXT("Buffer bounded before everything was received"), Delivered < Bytes.Num());
+    TestEqual(TEXT("Bound is one maximal frame"), Delivered, 64 + LENGTH_PREFIX_SIZE);
+
+    FString Message;
+    while (Framing.TryReadMessage(Message) == ELengthPrefixedReadResult::Frame)
+    {
+    }
+    TestFalse(TEXT("Reading frames releases the bound"), Framing.IsReceiveBufferFull());
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Messaging/MessageDeflate.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static constexpr int32 DeflateTestMaxSize = 1024 * 1024;
+
+static TArray<uint8> ToUtf8(const FString& Message)
+{
+    FTCHARToUTF8 Converter(*Message);
+    return TArray<uint8>(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+}
+
+static FString FromUtf8(const TArray<uint8>& Bytes)
+{
+    FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Bytes.GetData()), Bytes.Num());
+    return FString(Converter.Length(), Converter.Get());
+}
+
+/** Frames of the messages, as the peer would receive them */
+static TArray<uint8> CompressMessages(FMessageDeflate& Sender, const TArray<FString>& Messages, TArray<int32>* OutFrameSizes = nullptr)
+{
+    TArray<uint8> Bytes;
+    for (const FString& Message : Messages)
+    {
+        const int32 Start = Bytes.Num();
+        const TArray<uint8> Utf8 = ToUtf8(Message);
+        Sender.Compress(Utf8.GetData(), Utf8.Num(), Bytes);
+        if (OutFrameSizes != nullptr)
+            OutFrameSizes->Add(Bytes.Num() - Start);
+    }
+    return Bytes;
+}
+
+/** Deliver the bytes in fragments of ChunkSize, false as soon as a frame is refused */
+static bool ReceiveFrames(FMessageDeflate& Receiver, const TArray<uint8>& Bytes, int32 ChunkSize, int32 MaxSize, TArray<FString>& OutMessages)
+{
+    for (int32 Offset = 0; Offset < Bytes.Num(); Offset += ChunkSize)
+    {
+        const uint8* Chunk = Bytes.GetData() + Offset;
+        int32 Count = FMath::Min(ChunkSize, Bytes.Num() - Offset);
+        while (Count > 0)
+        {
+            bool bComplete, bOversized;
+            const int32 Consumed = Receiver.FeedFrame(Chunk, Count, MaxSize, bComplete, bOversized);
+            if (bOversized)
+                return false;
+
+            if (bComplete)
+            {
+                TArray<uint8> Message;
+                if (!Receiver.DecompressFrame(MaxSize, Message))
+                    return false;
+                OutMessages.Add(FromUtf8(Message));
+            }
+            Chunk += Consumed;
+            Count -= Consumed;
+        }
+    }
+    return true;
+}
+
+static TArray<FString> MakeDeflateTestMessages()
+{
+    return {
+        TEXT("{\"id\":1,\"method\":\"move\",\"params\":{\"x\":1.5,\"y\":-2.25,\"name\":\"\u00e9\u4e2d\"}}"),
+        TEXT(""),
+        TEXT("{\"id\":2,\"method\":\"move\",\"params\":{\"x\":1.5,\"y\":-2.25,\"name\":\"\u00e9\u4e2d\"}}"),
+        FString::ChrN(70000, TEXT('a')),
+        TEXT("{\"id\":3,\"result\":[1,2,3]}")
+    };
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMessageDeflateRoundTripTest, "WebApiServer.Framing.Deflate.RoundTrip",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FMessageDeflateRoundTripTest::RunTest(const FString& Parameters)
+{
+    const TArray<FString> Messages = MakeDeflateTestMessages();
+
+    for (const bool bContextTakeover : { false, true })
+    {
+        // Whole, then one byte at a time so the header is split as well
+        for (const int32 ChunkSize : { MAX_int32, 1 })
+        {
+            const FString Case = FString::Printf(TEXT("Context takeover %d, fragments of %d"), bContextTakeover, ChunkSize);
+
+            FMessageDeflate Sender;
+            FMessageDeflate Receiver;
+            Sender.Reset(bContextTakeover);
+            Receiver.Reset(bContextTakeover);
+
+            const TArray<uint8> Bytes = CompressMessages(Sender, Messages);
+            TestTrue(*FString::Printf(TEXT("%s: marker"), *Case), Bytes.Num() > 0 && Bytes[0] == MESSAGE_DEFLATE_MARKER);
+
+            TArray<FString> Received;
+            TestTrue(*FString::Printf(TEXT("%s: decompressed"), *Case), ReceiveFrames(Receiver, Bytes, ChunkSize, DeflateTestMaxSize, Received));
+            TestEqual(*FString::Printf(TEXT("%s: messages"), *Case), Received.Num(), Messages.Num());
+            for (int32 Index = 0; Index < FMath::Min(Received.Num(), Messages.Num()); ++Index)
+                TestTrue(*FString::Printf(TEXT("%s: message %d"), *Case, Index), Received[Index] == Messages[Index]);
+
+            TestFalse(*FString::Printf(TEXT("%s: nothing left"), *Case), Receiver.IsInFrame());
+        }
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMessageDeflateContextTakeoverTest, "WebApiServer.Framing.Deflate.ContextTakeover",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FMessageDeflateContextTakeoverTest::RunTest(const FString& Parameters)
+{
+    const FString Message = TEXT("{\"method\":\"state\",\"params\":{\"position\":[10.0,20.0,30.0],\"rotation\":[0.0,90.0,0.0],\"velocity\":[1.0,0.0,0.0]}}");
+
+    FMessageDeflate Sender;
+    Sender.Reset(true);
+    TArray<int32> FrameSizes;
+    CompressMessages(Sender, { Message, Message }, &FrameSizes);
+
+    // The repeated message is a back reference into the window of the first one
+    TestTrue(TEXT("Second frame smaller"), FrameSizes.Num() == 2 && FrameSizes[1] < FrameSizes[0]);
+
+    // Without it every message compresses on its own
+    Sender.Reset(false);
+    FrameSizes.Reset();
+    CompressMessages(Sender, { Message, Message }, &FrameSizes);
+    TestTrue(TEXT("Frames independent"), FrameSizes.Num() == 2 && FrameSizes[1] == FrameSizes[0]);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMessageDeflateOversizedTest, "WebApiServer.Framing.Deflate.Oversized",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FMessageDeflateOversizedTest::RunTest(const FString& Parameters)
+{
+    const FString Message = FString::ChrN(10000, TEXT('a'));
+
+    FMessageDeflate Sender;
+    const TArray<uint8> Bytes = CompressMessages(Sender, { Message });
+
+    // Refused from the header when the compressed payload itself is over the limit
+    FMessageDeflate Receiver;
+    bool bComplete, bOversized;
+    Receiver.FeedFrame(Bytes.GetData(), Bytes.Num(), 4, bComplete, bOversized);
+    TestTrue(TEXT("Frame refused"), bOversized && !bComplete);
+    TestFalse(TEXT("Frame dropped"), Receiver.IsInFrame());
+
+    // Refused while inflating when the message grows past the limit
+    TArray<FString> Received;
+    TestFalse(TEXT("Inflated message refused"), ReceiveFrames(Receiver, Bytes, MAX_int32, Message.Len() - 1, Received));
+
+    Receiver.Reset(false);
+    Received.Reset();
+    TestTrue(TEXT("Exactly the limit"), ReceiveFrames(Receiver, Bytes, MAX_int32, Message.Len(), Received) && Received.Num() == 1 && Received[0] == Message);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMessageDeflateCorruptedTest, "WebApiServer.Framing.Deflate.Corrupted",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FMessageDeflateCorruptedTest::RunTest(const FString& Parameters)
+{
+    // 0xFF starts a block of the reserved type 3, which is never valid deflate
+    const TArray<uint8> Bytes = { MESSAGE_DEFLATE_MARKER, 0, 0, 0, 3, 0xFF, 0xFF, 0xFF };
+
+    FMessageDeflate Receiver;
+    TArray<FString> Received;
+    TestFalse(TEXT("Corrupted frame refused"), ReceiveFrames(Receiver, Bytes, MAX_int32, DeflateTestMaxSize, Received));
+
+    // After a reset the receiver takes valid frames again
+    FMessageDeflate Sender;
+    const FString Message = TEXT("{\"method\":\"ok\"}");
+    Receiver.Reset(false);
+    Received.Reset();
+    TestTrue(TEXT("Valid after reset"), ReceiveFrames(Receiver, CompressMessages(Sender, { Message }), MAX_int32, DeflateTestMaxSize, Received)
+        && Received.Num() == 1 && Received[0] == Message);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
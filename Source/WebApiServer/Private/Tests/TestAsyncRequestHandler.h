@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Async/JsonPromise.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+#include "TestAsyncRequestHandler.generated.h"
+
+/** Async request handler keeping its promises, the test completes them later */
+UCLASS(Transient)
+class UTestAsyncRequestHandler : public UObject
+{
+    GENERATED_BODY()
+
+public:
+
+    UFUNCTION()
+    void Handle(FJsonObjectWrapper Params, UJsonPromise* Promise)
+    {
+        Promises.Add(Promise);
+    }
+
+    /** Registers Handle for Method */
+    void Register(UJsonMessageDispatcher* Dispatcher, const FString& Method)
+    {
+        FJsonRpcRequestHandlerAsyncDelegate Delegate;
+        Delegate.BindDynamic(this, &UTestAsyncRequestHandler::Handle);
+        Dispatcher->RegisterRequestAsyncHandler(Method, Delegate, this);
+    }
+
+    /** Promises of the calls so far, in call order */
+    UPROPERTY()
+    TArray<TObjectPtr<UJsonPromise>> Promises;
+};
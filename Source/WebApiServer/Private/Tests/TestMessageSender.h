@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Messaging/MessageSender.h"
+#include "TestMessageSender.generated.h"
+
+/** Sender recording every message the dispatcher sends to it */
+UCLASS(Transient)
+class UTestMessageSender : public UObject, public IMessageSender
+{
+    GENERATED_BODY()
+
+public:
+
+    virtual bool SendMessage_Implementation(const FString& Message) override
+    {
+        Messages.Add(Message);
+        return true;
+    }
+
+    virtual FSimpleMulticastDelegate* GetClosedDelegate() override { return &ClosedDelegate; }
+
+    virtual bool CanStreamResponses() const override { return bCanStreamResponses; }
+
+    TArray<FString> Messages;
+
+    /** Cleared to get streamed responses as one result */
+    bool bCanStreamResponses = true;
+
+    /** Broadcast by the test to simulate the connection closing */
+    FSimpleMulticastDelegate ClosedDelegate;
+};
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TestMessageSender.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Messaging/TokenBucket.h"
+#include "Dispatcher/JsonMessageDispatcher.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokenBucketBurstTest, "WebApiServer.Admission.TokenBucket.Burst",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokenBucketBurstTest::RunTest(const FString& Parameters)
+{
+    // Starts full: the whole burst is available at once, then nothing until it refills
+    FTokenBucket Bucket;
+    for (int32 Index = 0; Index < 3; ++Index)
+        TestTrue(*FString::Printf(TEXT("Token %d of the burst"), Index), Bucket.TryConsume(100.0, 1.0, 3.0));
+    TestFalse(TEXT("Burst exhausted"), Bucket.TryConsume(100.0, 1.0, 3.0));
+
+    // A burst below one still lets one message through
+    FTokenBucket SmallBucket;
+    TestTrue(TEXT("Capacity of at least one"), SmallBucket.TryConsume(0.0, 1.0, 0.0));
+    TestFalse(TEXT("Then empty"), SmallBucket.TryConsume(0.0, 1.0, 0.0));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokenBucketRefillTest, "WebApiServer.Admission.TokenBucket.Refill",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokenBucketRefillTest::RunTest(const FString& Parameters)
+{
+    FTokenBucket Bucket;
+    TestTrue(TEXT("First token"), Bucket.TryConsume(0.0, 2.0, 2.0));
+    TestTrue(TEXT("Second token"), Bucket.TryConsume(0.0, 2.0, 2.0));
+    TestFalse(TEXT("Empty"), Bucket.TryConsume(0.0, 2.0, 2.0));
+
+    // Two tokens per second: one is back after half a second
+    TestFalse(TEXT("Not refilled yet"), Bucket.TryConsume(0.25, 2.0, 2.0));
+    TestTrue(TEXT("Refilled after 0.5 s"), Bucket.TryConsume(0.5, 2.0, 2.0));
+
+    // A long pause refills up to the burst, not beyond
+    int32 Taken = 0;
+    while (Taken < 10 && Bucket.TryConsume(1000.0, 2.0, 2.0))
+        ++Taken;
+    TestEqual(TEXT("Refill capped by the burst"), Taken, 2);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokenBucketCostTest, "WebApiServer.Admission.TokenBucket.Cost",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokenBucketCostTest::RunTest(const FString& Parameters)
+{
+    // A cost over the tokens left is accepted once, and the debt is paid back before the next call succeeds
+    FTokenBucket Bucket;
+    TestTrue(TEXT("Costly call accepted with a token left"), Bucket.TryConsume(0.0, 1.0, 4.0, 10.0));
+    TestFalse(TEXT("In debt"), Bucket.TryConsume(5.0, 1.0, 4.0));
+    TestTrue(TEXT("Debt paid back"), Bucket.TryConsume(7.0, 1.0, 4.0));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJsonRpcAdmissionMessageLimitTest, "WebApiServer.Admission.MessageLimit",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FJsonRpcAdmissionMessageLimitTest::RunTest(const FString& Parameters)
+{
+    TStrongObjectPtr<UJsonMessageDispatcher> Dispatcher(NewObject<UJsonMessageDispatcher>());
+    TStrongObjectPtr<UTestMessageSender> Sender(NewObject<UTestMessageSender>());
+    const TScriptInterface<IMessageSender> MessageSender(Sender.Get());
+
+    Dispatcher->RegisterRequestHandler(TEXT("echo"), FJsonRpcRequestHandlerLambda([](const TSharedPtr<FJsonValue>& Params)
+    {
+        return Params;
+    }));
+
+    // No refill during the test, only the burst is available
+    Dispatcher->MessagesPerSecondPerClient = 0.001f;
+    Dispatcher->MessageBurstPerClient = 3;
+
+    // A batch of three takes the whole burst
+    Dispatcher->HandleMessage(TEXT("[{\"id\":1,\"method\":\"echo\",\"params\":[\"a,b\"]},{\"id\":2,\"method\":\"echo\",\"params\":{\"c\":[1,2]}},{\"id\":3,\"method\":\"echo\",\"params\":[]}]"), MessageSender);
+    TestEqual(TEXT("Batch answered"), Sender->Messages.Num(), 3);
+
+    Sender->Messages.Reset();
+    Dispatcher->HandleMessage(TEXT("{\"id\":4,\"method\":\"echo\",\"params\":[]}"), MessageSender);
+    TestTrue(TEXT("Batch charged per element"), Sender->Messages.Num() == 1 && Sender->Messages[0].Contains(TEXT("rate_limited")));
+    TestEqual(TEXT("Rejection counted"), Dispatcher->GetAdmissionStats().RejectedMessages, 1);
+
+    // Closing the connection forgets its admission state, a new connection starts with a full bucket
+    Sender->ClosedDelegate.Broadcast();
+    Sender->Messages.Reset();
+    Dispatcher->HandleMessage(TEXT("{\"id\":5,\"method\":\"echo\",\"params\":[]}"), MessageSender);
+    TestTrue(TEXT("Admission released on close"), Sender->Messages.Num() == 1 && !Sender->Messages[0].Contains(TEXT("rate_limited")));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
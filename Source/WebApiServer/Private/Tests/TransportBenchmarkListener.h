@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "TransportBenchmarkListener.generated.h"
+
+class UTcpServerWrapper;
+class UTcpClientWrapper;
+class UWebSocketServerWrapper;
+class UWebSocketClientWrapper;
+
+/**
+ * Binds the dynamic delegates of the transports for the loopback benchmark.
+ * Servers echo every message back, clients count the echoes.
+ */
+UCLASS(Transient)
+class UTransportBenchmarkListener : public UObject
+{
+    GENERATED_BODY()
+
+public:
+
+    UFUNCTION()
+    void OnTcpClientConnect(UTcpServerWrapper* Server, UTcpClientWrapper* Client);
+
+    UFUNCTION()
+    void EchoTcp(UTcpClientWrapper* Client, const FString& Message);
+
+    UFUNCTION()
+    void CountTcp(UTcpClientWrapper* Client, const FString& Message);
+
+    UFUNCTION()
+    void OnWebSocketClientConnect(UWebSocketServerWrapper* Server, UWebSocketClientWrapper* Client);
+
+    UFUNCTION()
+    void EchoWebSocket(UWebSocketClientWrapper* Client, const FString& Message);
+
+    UFUNCTION()
+    void CountWebSocket(UWebSocketClientWrapper* Client, const FString& Message);
+
+    int32 Received = 0;
+};
@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/TransportBenchmarkListener.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Tcp/TcpServerWrapper.h"
+#include "Tcp/TcpClientWrapper.h"
+#include "WebSocket/WebSocketServerWrapper.h"
+#include "WebSocket/WebSocketClientWrapper.h"
+
+void UTransportBenchmarkListener::OnTcpClientConnect(UTcpServerWrapper* Server, UTcpClientWrapper* Client)
+{
+    Client->OnMessageRecieved.AddDynamic(this, &ThisClass::EchoTcp);
+}
+
+void UTransportBenchmarkListener::EchoTcp(UTcpClientWrapper* Client, const FString& Message)
+{
+    Client->SendMessage_Implementation(Message);
+}
+
+void UTransportBenchmarkListener::CountTcp(UTcpClientWrapper* Client, const FString& Message)
+{
+    ++Received;
+}
+
+void UTransportBenchmarkListener::OnWebSocketClientConnect(UWebSocketServerWrapper* Server, UWebSocketClientWrapper* Client)
+{
+    Client->OnMessageRecieved.AddDynamic(this, &ThisClass::EchoWebSocket);
+}
+
+void UTransportBenchmarkListener::EchoWebSocket(UWebSocketClientWrapper* Client, const FString& Message)
+{
+    Client->SendMessage_Implementation(Message);
+}
+
+void UTransportBenchmarkListener::CountWebSocket(UWebSocketClientWrapper* Client, const FString& Message)
+{
+    ++Received;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Echoed messages per run, sent at once and pipelined by the transport */
+static constexpr int32 LoopbackMessageCount = 20000;
+static constexpr int32 LoopbackMessageSize = 256;
+static constexpr double LoopbackTimeout = 30.0;
+
+/**
+ * One loopback run: a server echoing everything and a client sending LoopbackMessageCount messages at once.
+ * Both ends are serviced by their tickers, so the run spans several engine frames and is driven by latent commands.
+ */
+struct FLoopbackBenchmarkRun
+{
+    FString Name;
+    TStrongObjectPtr<UTransportBenchmarkListener> Listener;
+    TStrongObjectPtr<UObject> Server;
+    TStrongObjectPtr<UObject> Client;
+    TFunction<bool ()> IsConnected;
+    TFunction<void (const FString&)> Send;
+    TFunction<void ()> Stop;
+
+    double Deadline = 0.0;
+    double StartTime = 0.0;
+};
+
+static void RunLoopbackBenchmark(FAutomationTestBase* Test, const TSharedRef<FLoopbackBenchmarkRun>& Run)
+{
+    Run->Deadline = FPlatformTime::Seconds() + LoopbackTimeout;
+
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Test, Run]()
+    {
+        if (Run->IsConnected())
+        {
+            // {"method":"bench","params":"xxx..."} padded to LoopbackMessageSize bytes
+            const FString Prefix = TEXT("{\"method\":\"bench\",\"params\":\"");
+            const FString Message = Prefix + FString::ChrN(LoopbackMessageSize - Prefix.Len() - 2, TEXT('x')) + TEXT("\"}");
+
+            Run->StartTime = FPlatformTime::Seconds();
+            for (int32 Index = 0; Index < LoopbackMessageCount; ++Index)
+                Run->Send(Message);
+            return true;
+        }
+
+        if (FPlatformTime::Seconds() < Run->Deadline)
+            return false;
+
+        Test->AddError(FString::Printf(TEXT("%s: could not connect on loopback"), *Run->Name));
+        return true;
+    }));
+
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Test, Run]()
+    {
+        const int32 Received = Run->Listener->Received;
+        const double Now = FPlatformTime::Seconds();
+        if (Run->StartTime > 0.0 && Received < LoopbackMessageCount && Now < Run->Deadline)
+            return false;
+
+        if (Run->StartTime > 0.0)
+        {
+            const double Elapsed = FMath::Max(Now - Run->StartTime, 1e-6);
+            Test->AddInfo(FString::Printf(TEXT("%s: %d/%d messages of %d bytes echoed in %.3f s, %.0f messages/s, %.2f MB/s each way"),
+                *Run->Name, Received, LoopbackMessageCount, LoopbackMessageSize, Elapsed,
+                Received / Elapsed, Received * static_cast<double>(LoopbackMessageSize) / Elapsed / (1024.0 * 1024.0)));
+
+            if (Received < LoopbackMessageCount)
+                Test->AddError(FString::Printf(TEXT("%s: timed out"), *Run->Name));
+        }
+
+        Run->Stop();
+        return true;
+    }));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTcpLoopbackBenchmark, "WebApiServer.Benchmark.Loopback.Tcp",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FTcpLoopbackBenchmark::RunTest(const FString& Parameters)
+{
+    constexpr int32 Port = 18081;
+
+    TSharedRef<FLoopbackBenchmarkRun> Run = MakeShared<FLoopbackBenchmarkRun>();
+    Run->Name = TEXT("Tcp");
+    Run->Listener.Reset(NewObject<UTransportBenchmarkListener>());
+
+    UTcpServerWrapper* Server = NewObject<UTcpServerWrapper>();
+    Server->OnClientConnect.AddDynamic(Run->Listener.Get(), &UTransportBenchmarkListener::OnTcpClientConnect);
+    if (!Server->StartServer(Port))
+    {
+        AddError(FString::Printf(TEXT("Could not listen on port %d"), Port));
+        return false;
+    }
+
+    UTcpClientWrapper* Client = UTcpClientWrapper::NewTcpConnection(Server, TEXT("127.0.0.1"), Port);
+    Client->OnMessageRecieved.AddDynamic(Run->Listener.Get(), &UTransportBenchmarkListener::CountTcp);
+
+    Run->Server.Reset(Server);
+    Run->Client.Reset(Client);
+    Run->IsConnected = [Client]() { return Client->IsConnected(); };
+    Run->Send = [Client](const FString& Message) { Client->SendMessage_Implementation(Message); };
+    Run->Stop = [Server, Client]()
+    {
+        Client->Disconnect();
+        Server->StopServer();
+    };
+
+    RunLoopbackBenchmark(this, Run);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWebSocketLoopbackBenchmark, "WebApiServer.Benchmark.Loopback.WebSocket",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FWebSocketLoopbackBenchmark::RunTest(const FString& Parameters)
+{
+    constexpr int32 Port = 18080;
+
+    TSharedRef<FLoopbackBenchmarkRun> Run = MakeShared<FLoopbackBenchmarkRun>();
+    Run->Name = TEXT("WebSocket");
+    Run->Listener.Reset(NewObject<UTransportBenchmarkListener>());
+
+    UWebSocketServerWrapper* Server = NewObject<UWebSocketServerWrapper>();
+    Server->OnClientConnect.AddDynamic(Run->Listener.Get(), &UTransportBenchmarkListener::OnWebSocketClientConnect);
+    Server->StartServer(Port);
+    if (!Server->IsRunning())
+    {
+        AddError(FString::Printf(TEXT("Could not listen on port %d"), Port));
+        return false;
+    }
+
+    UWebSocketClientWrapper* Client = NewObject<UWebSocketClientWrapper>(Server);
+    Client->bAutoReconnect = false;
+    Client->MaxQueuedMessages = LoopbackMessageCount;
+    Client->OnMessageRecieved.AddDynamic(Run->Listener.Get(), &UTransportBenchmarkListener::CountWebSocket);
+    Client->Connect(TEXT("127.0.0.1"), Port);
+
+    Run->Server.Reset(Server);
+    Run->Client.Reset(Client);
+    Run->IsConnected = [Client]() { return Client->IsConnected(); };
+    Run->Send = [Client](const FString& Message) { Client->SendMessage_Implementation(Message); };
+    Run->Stop = [Server, Client]()
+    {
+        Client->Disconnect();
+        Server->StopServer();
+    };
+
+    RunLoopbackBenchmark(this, Run);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
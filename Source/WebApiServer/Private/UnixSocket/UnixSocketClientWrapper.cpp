@@ -0,0 +1,338 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UnixSocket/UnixSocketClientWrapper.h"
+
+#include "WebApiServerStats.h"
+
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+DECLARE_CYCLE_STAT(TEXT("Unix Socket Pump"), STAT_WebApiServer_UnixSocketPump, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Unix Socket Bytes Sent"), STAT_WebApiServer_UnixSocketBytesSent, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Unix Socket Bytes Received"), STAT_WebApiServer_UnixSocketBytesReceived, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Unix Socket Send Calls"), STAT_WebApiServer_UnixSocketSendCalls, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Unix Socket Receive Calls"), STAT_WebApiServer_UnixSocketReceiveCalls, STATGROUP_WebApiServer);
+
+/** Bytes requested per recv call. Batched reads drain the socket with much larger reads. */
+static constexpr int32 UnixSocketReceiveChunkSize = 16 * 1024;
+static constexpr int32 UnixSocketBatchedReceiveChunkSize = 256 * 1024;
+
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+#ifdef MSG_NOSIGNAL
+static constexpr int UnixSocketSendFlags = MSG_NOSIGNAL;
+#else
+static constexpr int UnixSocketSendFlags = 0;
+#endif
+#endif
+
+UUnixSocketClientWrapper::~UUnixSocketClientWrapper()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+    CloseSocket();
+}
+
+UUnixSocketClientWrapper* UUnixSocketClientWrapper::NewUnixSocketConnection(UObject* Outer, const FString& SocketPath, bool bBatchedIO)
+{
+    UUnixSocketClientWrapper* NewClient = NewObject<UUnixSocketClientWrapper>(Outer);
+    NewClient->bBatchedIO = bBatchedIO;
+    NewClient->Connect(SocketPath);
+
+    return NewClient;
+}
+
+bool UUnixSocketClientWrapper::Connect(const FString& SocketPath)
+{
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+    if (SocketFd >= 0)
+        return false;
+
+    sockaddr_un Address = {};
+    Address.sun_family = AF_UNIX;
+
+    FTCHARToUTF8 PathConverter(*SocketPath, SocketPath.Len());
+    if (PathConverter.Length() <= 0 || PathConverter.Length() >= static_cast<int32>(sizeof(Address.sun_path)))
+    {
+        UE_LOG(LogTemp, Error, TEXT("UnixSocketClientWrapper: Invalid socket path %s"), *SocketPath);
+        OnError.Broadcast(this);
+        return false;
+    }
+    FMemory::Memcpy(Address.sun_path, PathConverter.Get(), PathConverter.Length());
+
+    int32 NewFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (NewFd < 0)
+    {
+        OnError.Broadcast(this);
+        return false;
+    }
+
+    fcntl(NewFd, F_SETFL, fcntl(NewFd, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int NoSigPipe = 1;
+    setsockopt(NewFd, SOL_SOCKET, SO_NOSIGPIPE, &NoSigPipe, sizeof(NoSigPipe));
+#endif
+
+    bool bPending = false;
+    if (connect(NewFd, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0)
+    {
+        // Read once, logging may change errno
+        const int32 ConnectError = errno;
+
+        // On Linux EAGAIN means the listen backlog is full, not that the connect is in progress
+        if (ConnectError == EAGAIN)
+            UE_LOG(LogTemp, Warning, TEXT("UnixSocketClientWrapper: %s is not accepting connections right now, retry later"), *SocketPath);
+
+        if (ConnectError != EINPROGRESS)
+        {
+            close(NewFd);
+            OnError.Broadcast(this);
+            return false;
+        }
+        bPending = true;
+    }
+
+    Initialize(nullptr, NewFd);
+    bConnected = !bPending;
+    ConnectDeadline = bPending ? FPlatformTime::Seconds() + ConnectTimeout : 0.0;
+
+    TWeakObjectPtr<UUnixSocketClientWrapper> WeakThis(this);
+    TickHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateLambda([WeakThis](float DeltaTime) {
+            if (WeakThis.IsValid() && WeakThis->SocketFd >= 0)
+                return WeakThis->Pump();
+            return false;
+        }));
+
+    if (bConnected)
+        OnConnected.Broadcast(this);
+
+    return true;
+#else
+    UE_LOG(LogTemp, Error, TEXT("UnixSocketClientWrapper: Unix domain sockets are not supported on this platform"));
+    OnError.Broadcast(this);
+    return false;
+#endif
+}
+
+void UUnixSocketClientWrapper::Disconnect()
+{
+    if (SocketFd < 0)
+        return;
+
+    // Best effort to deliver what is still queued
+    if (bConnected)
+        FlushSendBuffer();
+    HandleConnectionLost(false);
+}
+
+bool UUnixSocketClientWrapper::IsConnected() const
+{
+    return SocketFd >= 0 && bConnected;
+}
+
+void UUnixSocketClientWrapper::Initialize(UUnixSocketServerWrapper* InServer, int32 InSocketFd)
+{
+    Server = InServer;
+    SocketFd = InSocketFd;
+    Framing.Reset();
+    bConnected = InServer != nullptr;
+}
+
+bool UUnixSocketClientWrapper::SendMessage_Implementation(const FString& Message)
+{
+    if (SocketFd < 0)
+        return false;
+
+    Framing.QueueMessage(Message);
+    return bBatchedIO || !bConnected || FlushSendBuffer();
+}
+
+bool UUnixSocketClientWrapper::SendData(const TArray<uint8>& Data)
+{
+    if (SocketFd < 0)
+        return false;
+
+    Framing.QueueData(Data.GetData(), Data.Num());
+    return bBatchedIO || !bConnected || FlushSendBuffer();
+}
+
+bool UUnixSocketClientWrapper::Pump(bool bReadable)
+{
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+    SCOPE_CYCLE_COUNTER(STAT_WebApiServer_UnixSocketPump);
+
+    if (SocketFd < 0)
+        return false;
+
+    Framing.MaxFrameSize = MaxMessageSize;
+
+    if (!bConnected)
+    {
+        int SocketError = 0;
+        socklen_t ErrorSize = sizeof(SocketError);
+        if (getsockopt(SocketFd, SOL_SOCKET, SO_ERROR, &SocketError, &ErrorSize) != 0 || (SocketError != 0 && SocketError != EINPROGRESS))
+        {
+            HandleConnectionLost(true);
+            return false;
+        }
+
+        // Still connecting as long as the peer address is not known
+        sockaddr_un PeerAddress;
+        socklen_t PeerAddressSize = sizeof(PeerAddress);
+        if (getpeername(SocketFd, reinterpret_cast<sockaddr*>(&PeerAddress), &PeerAddressSize) != 0)
+        {
+            if (FPlatformTime::Seconds() < ConnectDeadline)
+                return true;
+
+            UE_LOG(LogTemp, Warning, TEXT("UnixSocketClientWrapper: Connect timed out after %.1f seconds"), ConnectTimeout);
+            HandleConnectionLost(true);
+            return false;
+        }
+
+        bConnected = true;
+        OnConnected.Broadcast(this);
+    }
+
+    if (!FlushSendBuffer())
+        return false;
+
+    if (!bReadable)
+        return true;
+
+    if (!ReceiveAvailable())
+        return false;
+
+    FString Message;
+    for (;;)
+    {
+        ELengthPrefixedReadResult Result = Framing.TryReadMessage(Message);
+        if (Result == ELengthPrefixedReadResult::NeedMoreData)
+            break;
+
+        if (Result == ELengthPrefixedReadResult::Oversized)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("UnixSocketClientWrapper: Closing connection after oversized frame (max %d bytes)"), MaxMessageSize);
+            HandleConnectionLost(true);
+            return false;
+        }
+
+        OnMessageRecieved.Broadcast(this, Message);
+
+        // A listener may have closed the connection
+        if (SocketFd < 0)
+            return false;
+    }
+
+    // Replies produced by the listeners leave with the same write
+    return !bBatchedIO || FlushSendBuffer();
+#else
+    return false;
+#endif
+}
+
+bool UUnixSocketClientWrapper::FlushSendBuffer()
+{
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+    while (Framing.GetPendingSendBytes() > 0)
+    {
+        INC_DWORD_STAT(STAT_WebApiServer_UnixSocketSendCalls);
+        ssize_t BytesSent = send(SocketFd, Framing.GetPendingSendData(), Framing.GetPendingSendBytes(), UnixSocketSendFlags);
+        if (BytesSent < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            if (errno == EINTR)
+                continue;
+
+            HandleConnectionLost(true);
+            return false;
+        }
+
+        INC_DWORD_STAT_BY(STAT_WebApiServer_UnixSocketBytesSent, BytesSent);
+        Framing.ConsumeSent(static_cast<int32>(BytesSent));
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool UUnixSocketClientWrapper::ReceiveAvailable()
+{
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+    const int32 ChunkSize = bBatchedIO ? UnixSocketBatchedReceiveChunkSize : UnixSocketReceiveChunkSize;
+    for (;;)
+    {
+        uint8* Slack = Framing.GetReceiveSlack(ChunkSize);
+
+        INC_DWORD_STAT(STAT_WebApiServer_UnixSocketReceiveCalls);
+        ssize_t BytesRead = recv(SocketFd, Slack, ChunkSize, 0);
+        if (BytesRead == 0)
+        {
+            HandleConnectionLost(false);
+            return false;
+        }
+        if (BytesRead < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            if (errno == EINTR)
+                continue;
+
+            HandleConnectionLost(true);
+            return false;
+        }
+
+        INC_DWORD_STAT_BY(STAT_WebApiServer_UnixSocketBytesReceived, BytesRead);
+        Framing.CommitReceived(static_cast<int32>(BytesRead));
+
+        // Let Pump reject an oversized frame before buffering the rest of it, and drain complete frames before reading more
+        if (BytesRead < ChunkSize || Framing.HasOversizedFrame() || Framing.IsReceiveBufferFull())
+            return true;
+    }
+#else
+    return false;
+#endif
+}
+
+void UUnixSocketClientWrapper::CloseSocket()
+{
+    if (SocketFd < 0)
+        return;
+
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+    close(SocketFd);
+#endif
+    SocketFd = -1;
+    bConnected = false;
+    Framing.Reset();
+}
+
+void UUnixSocketClientWrapper::HandleConnectionLost(bool bError)
+{
+    if (SocketFd < 0)
+        return;
+
+    CloseSocket();
+
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+
+    if (bError)
+        OnError.Broadcast(this);
+    OnDisconnected.Broadcast(this);
+    ClosedDelegate.Broadcast();
+    Server = nullptr;
+}
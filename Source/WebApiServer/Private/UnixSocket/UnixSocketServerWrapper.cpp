@@ -0,0 +1,267 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "UnixSocket/UnixSocketServerWrapper.h"
+
+#include "UnixSocket/UnixSocketClientWrapper.h"
+#include "WebApiServerStats.h"
+
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+DECLARE_CYCLE_STAT(TEXT("Unix Socket Server Tick"), STAT_WebApiServer_UnixSocketServerTick, STATGROUP_WebApiServer);
+
+static constexpr int32 UnixSocketListenBacklog = 128;
+
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+/**
+ * Make the path available for bind. Only a socket file nobody listens on any more is removed,
+ * so a regular file or another live server at the same path is never clobbered.
+ */
+static bool RemoveStaleSocket(const sockaddr_un& Address, const FString& SocketPath)
+{
+    struct stat Status;
+    if (lstat(Address.sun_path, &Status) != 0)
+        return errno == ENOENT;
+
+    if (!S_ISSOCK(Status.st_mode))
+    {
+        UE_LOG(LogTemp, Error, TEXT("UnixSocketServerWrapper: %s exists and is not a socket"), *SocketPath);
+        return false;
+    }
+
+    int32 ProbeFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (ProbeFd < 0)
+        return false;
+
+    // A blocking connect to a local socket either succeeds at once or is refused
+    const bool bConnected = connect(ProbeFd, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) == 0;
+    const int32 ConnectError = errno;
+    close(ProbeFd);
+
+    if (!bConnected && ConnectError == ENOENT)
+        return true;
+
+    if (bConnected || ConnectError != ECONNREFUSED)
+    {
+        UE_LOG(LogTemp, Error, TEXT("UnixSocketServerWrapper: Address %s already in use"), *SocketPath);
+        return false;
+    }
+
+    // Left behind by a previous run
+    return unlink(Address.sun_path) == 0 || errno == ENOENT;
+}
+#endif
+
+UUnixSocketServerWrapper::~UUnixSocketServerWrapper()
+{
+    StopServer();
+}
+
+UUnixSocketServerWrapper* UUnixSocketServerWrapper::NewUnixSocketServer(UObject* Outer, const FString& SocketPath, bool bBatchedIO)
+{
+    UUnixSocketServerWrapper* NewServer = NewObject<UUnixSocketServerWrapper>(Outer);
+    NewServer->bBatchedIO = bBatchedIO;
+    NewServer->StartServer(SocketPath);
+
+    return NewServer;
+}
+
+bool UUnixSocketServerWrapper::StartServer(const FString& SocketPath)
+{
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+    if (IsRunning())
+        return false;
+
+    sockaddr_un Address = {};
+    Address.sun_family = AF_UNIX;
+
+    FTCHARToUTF8 PathConverter(*SocketPath, SocketPath.Len());
+    if (PathConverter.Length() <= 0 || PathConverter.Length() >= static_cast<int32>(sizeof(Address.sun_path)))
+    {
+        UE_LOG(LogTemp, Error, TEXT("UnixSocketServerWrapper: Invalid socket path %s"), *SocketPath);
+        return false;
+    }
+    FMemory::Memcpy(Address.sun_path, PathConverter.Get(), PathConverter.Length());
+
+    if (!RemoveStaleSocket(Address, SocketPath))
+        return false;
+
+    int32 NewFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (NewFd < 0)
+        return false;
+
+    fcntl(NewFd, F_SETFL, fcntl(NewFd, F_GETFL, 0) | O_NONBLOCK);
+
+    if (bind(NewFd, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0 || listen(NewFd, UnixSocketListenBacklog) != 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("UnixSocketServerWrapper: Failed to listen on %s (errno %d)"), *SocketPath, errno);
+        close(NewFd);
+        return false;
+    }
+
+    // Remember which file we created so StopServer never removes a socket that replaced it
+    struct stat Status;
+    if (lstat(Address.sun_path, &Status) == 0)
+    {
+        BoundDevice = static_cast<uint64>(Status.st_dev);
+        BoundInode = static_cast<uint64>(Status.st_ino);
+    }
+
+    UnixSocketPath = SocketPath;
+    ListenFd = NewFd;
+    TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick));
+    return true;
+#else
+    UE_LOG(LogTemp, Error, TEXT("UnixSocketServerWrapper: Unix domain sockets are not supported on this platform"));
+    return false;
+#endif
+}
+
+void UUnixSocketServerWrapper::StopServer()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+
+    // Closed like a disconnect so the dispatcher fails what is pending on each client
+    TArray<TObjectPtr<UUnixSocketClientWrapper>> Clients = UnixSocketClients.Array();
+    UnixSocketClients.Empty();
+    for (auto&& Client : Clients)
+    {
+        if (!Client)
+            continue;
+
+        // Nobody is left to notify once the server itself is being collected
+        if (HasAnyFlags(RF_BeginDestroyed))
+        {
+            Client->CloseSocket();
+            continue;
+        }
+        Client->HandleConnectionLost(false);
+        OnClientDisconnect.Broadcast(this, Client);
+    }
+
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+    if (ListenFd >= 0)
+    {
+        close(ListenFd);
+        ListenFd = -1;
+
+        const FTCHARToUTF8 PathConverter(*UnixSocketPath);
+        struct stat Status;
+        if (BoundInode != 0 && lstat(PathConverter.Get(), &Status) == 0 && S_ISSOCK(Status.st_mode)
+            && static_cast<uint64>(Status.st_dev) == BoundDevice && static_cast<uint64>(Status.st_ino) == BoundInode)
+        {
+            unlink(PathConverter.Get());
+        }
+        BoundDevice = 0;
+        BoundInode = 0;
+    }
+#endif
+}
+
+bool UUnixSocketServerWrapper::IsRunning() const
+{
+    return ListenFd >= 0;
+}
+
+void UUnixSocketServerWrapper::Broadcast(const FString& Payload)
+{
+    if (!IsRunning())
+        return;
+
+    TArray<uint8> Data;
+    FTCHARToUTF8 Converter(*Payload, Payload.Len());
+    Data.Append((uint8*)Converter.Get(), Converter.Length());
+
+    for (auto&& Client : UnixSocketClients)
+    {
+        if (!Client->SendData(Data))
+        {
+            // Failing clients are reaped on the next tick
+        }
+    }
+}
+
+bool UUnixSocketServerWrapper::Tick(float DeltaTime)
+{
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+    SCOPE_CYCLE_COUNTER(STAT_WebApiServer_UnixSocketServerTick);
+
+    if (!IsRunning())
+        return false;
+
+    // Listeners may stop the server or disconnect clients while we pump
+    TArray<TObjectPtr<UUnixSocketClientWrapper>> Clients = UnixSocketClients.Array();
+
+    // One poll over the listener and every client instead of a read attempt per connection
+    TArray<pollfd> PollFds;
+    PollFds.SetNumUninitialized(Clients.Num() + 1);
+    PollFds[0] = { ListenFd, POLLIN, 0 };
+    for (int32 i = 0; i < Clients.Num(); ++i)
+        PollFds[i + 1] = { Clients[i]->SocketFd, POLLIN, 0 };
+
+    if (poll(PollFds.GetData(), PollFds.Num(), 0) < 0 && errno != EINTR)
+        return true;
+
+    if (PollFds[0].revents & POLLIN)
+        AcceptPendingConnections();
+
+    TArray<TObjectPtr<UUnixSocketClientWrapper>> Disconnected;
+    for (int32 i = 0; i < Clients.Num(); ++i)
+    {
+        UUnixSocketClientWrapper* Client = Clients[i];
+        Client->bBatchedIO = bBatchedIO;
+        Client->MaxMessageSize = MaxMessageSize;
+
+        const bool bReadable = (PollFds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+        if (!Client->Pump(bReadable))
+            Disconnected.Add(Client);
+    }
+
+    for (UUnixSocketClientWrapper* Client : Disconnected)
+    {
+        if (UnixSocketClients.Remove(Client) > 0)
+            OnClientDisconnect.Broadcast(this, Client);
+    }
+
+    return IsRunning();
+#else
+    return false;
+#endif
+}
+
+void UUnixSocketServerWrapper::AcceptPendingConnections()
+{
+#if WEBAPISERVER_WITH_UNIX_SOCKETS
+    for (;;)
+    {
+        int32 ClientFd = accept(ListenFd, nullptr, nullptr);
+        if (ClientFd < 0)
+            return;
+
+        fcntl(ClientFd, F_SETFL, fcntl(ClientFd, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+        int NoSigPipe = 1;
+        setsockopt(ClientFd, SOL_SOCKET, SO_NOSIGPIPE, &NoSigPipe, sizeof(NoSigPipe));
+#endif
+
+        UUnixSocketClientWrapper* NewClient = NewObject<UUnixSocketClientWrapper>(this);
+        NewClient->bBatchedIO = bBatchedIO;
+        NewClient->MaxMessageSize = MaxMessageSize;
+        NewClient->Initialize(this, ClientFd);
+        UnixSocketClients.Add(NewClient);
+
+        OnClientConnect.Broadcast(this, NewClient);
+    }
+#endif
+}
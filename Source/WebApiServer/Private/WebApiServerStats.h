@@ -0,0 +1,8 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Stats/Stats.h"
+
+/** Runtime counters of the plugin, visible with `stat WebApiServer` */
+DECLARE_STATS_GROUP(TEXT("WebApiServer"), STATGROUP_WebApiServer, STATCAT_Advanced);
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WebSocket/WebSocketClientPool.h"
+
+#include "WebSocket/WebSocketClientWrapper.h"
+
+UWebSocketClientPool* UWebSocketClientPool::NewWebSocketClientPool(UObject* Outer, const FString& Url, int32 PoolSize)
+{
+    UWebSocketClientPool* NewPool = NewObject<UWebSocketClientPool>(Outer);
+    NewPool->Connect(Url, PoolSize);
+
+    return NewPool;
+}
+
+bool UWebSocketClientPool::Connect(const FString& Url, int32 PoolSize)
+{
+    if (!Connections.IsEmpty())
+        return false;
+
+    FString Host;
+    int32 Port;
+    if (!UWebSocketClientWrapper::ParseEndpoint(Url, Host, Port))
+        return false;
+
+    for (int32 Index = 0; Index < FMath::Max(PoolSize, 1); ++Index)
+    {
+        UWebSocketClientWrapper* Connection = NewObject<UWebSocketClientWrapper>(this);
+        Connection->OnMessageRecieved.AddDynamic(this, &ThisClass::HandleConnectionMessage);
+        Connection->GetClosedDelegate()->AddUObject(this, &ThisClass::HandleConnectionClosed);
+        Connection->Connect(Host, Port);
+        Connections.Add(Connection);
+    }
+    return true;
+}
+
+void UWebSocketClientPool::Disconnect()
+{
+    if (Connections.IsEmpty())
+        return;
+
+    for (UWebSocketClientWrapper* Connection : Connections)
+    {
+        if (IsValid(Connection))
+        {
+            Connection->OnMessageRecieved.RemoveDynamic(this, &ThisClass::HandleConnectionMessage);
+            Connection->GetClosedDelegate()->RemoveAll(this);
+            Connection->Disconnect();
+        }
+    }
+    Connections.Empty();
+    NextConnection = 0;
+    ClosedDelegate.Broadcast();
+}
+
+int32 UWebSocketClientPool::GetConnectedCount() const
+{
+    int32 Count = 0;
+    for (const UWebSocketClientWrapper* Connection : Connections)
+    {
+        if (IsValid(Connection) && Connection->IsConnected())
+            ++Count;
+    }
+    return Count;
+}
+
+bool UWebSocketClientPool::SendMessage_Implementation(const FString& Message)
+{
+    const int32 Count = Connections.Num();
+    if (Count == 0)
+        return false;
+
+    // Round-robin over the connected members first
+    for (int32 Offset = 0; Offset < Count; ++Offset)
+    {
+        UWebSocketClientWrapper* Connection = Connections[(NextConnection + Offset) % Count];
+        if (IsValid(Connection) && Connection->IsConnected())
+        {
+            NextConnection = (NextConnection + Offset + 1) % Count;
+            return Connection->SendMessage_Implementation(Message);
+        }
+    }
+
+    // Nobody is connected: queue on the members while they reconnect
+    for (int32 Offset = 0; Offset < Count; ++Offset)
+    {
+        UWebSocketClientWrapper* Connection = Connections[(NextConnection + Offset) % Count];
+        if (IsValid(Connection) && Connection->SendMessage_Implementation(Message))
+        {
+            NextConnection = (NextConnection + Offset + 1) % Count;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool UWebSocketClientPool::GetRoundTripTime(float& OutSmoothedRtt, float& OutRttVariation) const
+{
+    bool bHasSample = false;
+    OutSmoothedRtt = 0.0f;
+    OutRttVariation = 0.0f;
+    for (const UWebSocketClientWrapper* Connection : Connections)
+    {
+        float SmoothedRtt, RttVariation;
+        if (IsValid(Connection) && Connection->IsConnected() && Connection->GetRoundTripTime(SmoothedRtt, RttVariation))
+        {
+            OutSmoothedRtt = FMath::Max(OutSmoothedRtt, SmoothedRtt);
+            OutRttVariation = FMath::Max(OutRttVariation, RttVariation);
+            bHasSample = true;
+        }
+    }
+    return bHasSample;
+}
+
+int32 UWebSocketClientPool::GetPendingSendBytes() const
+{
+    int32 PendingBytes = INDEX_NONE;
+    for (const UWebSocketClientWrapper* Connection : Connections)
+    {
+        const int32 ConnectionBytes = IsValid(Connection) ? Connection->GetPendingSendBytes() : INDEX_NONE;
+        if (ConnectionBytes != INDEX_NONE)
+            PendingBytes = FMath::Max(PendingBytes, 0) + ConnectionBytes;
+    }
+    return PendingBytes;
+}
+
+void UWebSocketClientPool::HandleConnectionClosed()
+{
+    ClosedDelegate.Broadcast();
+}
+
+void UWebSocketClientPool::HandleConnectionMessage(UWebSocketClientWrapper* Client, const FString& Message)
+{
+    OnMessageRecieved.Broadcast(this, Message);
+}
@@ -2,15 +2,41 @@
 
 
 #include "WebSocket/WebSocketClientWrapper.h"
+#include "WebSocket/WebSocketServerWrapper.h"
 
+#include "Async/Async.h"
 #include "SocketSubsystem.h"
 #include "IWebSocketNetworkingModule.h"
 #include "INetworkingWebSocket.h"
+#include "WebApiServerStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Bytes Sent"), STAT_WebApiServer_WebSocketBytesSent, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Bytes Received"), STAT_WebApiServer_WebSocketBytesReceived, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Messages Received"), STAT_WebApiServer_WebSocketMessagesReceived, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Pings Sent"), STAT_WebApiServer_WebSocketPingsSent, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Bytes Before Compression"), STAT_WebApiServer_WebSocketBytesBeforeCompression, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Bytes After Compression"), STAT_WebApiServer_WebSocketBytesAfterCompression, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Messages Inflated"), STAT_WebApiServer_WebSocketMessagesInflated, STATGROUP_WebApiServer);
+DECLARE_CYCLE_STAT(TEXT("WebSocket Compress"), STAT_WebApiServer_WebSocketCompress, STATGROUP_WebApiServer);
+DECLARE_CYCLE_STAT(TEXT("WebSocket Decompress"), STAT_WebApiServer_WebSocketDecompress, STATGROUP_WebApiServer);
+
+static const FString PingPrefix = TEXT("{\"method\":\"rpc.ping\",\"params\":");
+static const FString PongPrefix = TEXT("{\"method\":\"rpc.pong\",\"params\":");
+static const FString CompressPrefix = TEXT("{\"method\":\"rpc.compress\",\"params\":");
 
 UWebSocketClientWrapper::UWebSocketClientWrapper()
 {
 }
 
+UWebSocketClientWrapper::~UWebSocketClientWrapper()
+{
+	if (TickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+	}
+}
+
 UWebSocketClientWrapper* UWebSocketClientWrapper::NewWebSocketConnection(UObject* Outer, const FString& Ip, int32 Port)
 {
 	UWebSocketClientWrapper *NewClient = NewObject<UWebSocketClientWrapper>(Outer);
@@ -19,38 +45,169 @@ UWebSocketClientWrapper* UWebSocketClientWrapper::NewWebSocketConnection(UObject
 	return NewClient;
 }
 
+bool UWebSocketClientWrapper::ParseEndpoint(const FString& Url, FString& OutHost, int32& OutPort)
+{
+	FString Remaining = Url.TrimStartAndEnd();
+
+	int32 SchemeEnd = Remaining.Find(TEXT("://"));
+	if (SchemeEnd != INDEX_NONE)
+	{
+		// WebSocketNetworking has no TLS support
+		if (!Remaining.Left(SchemeEnd).Equals(TEXT("ws"), ESearchCase::IgnoreCase))
+			return false;
+		Remaining.RightChopInline(SchemeEnd + 3);
+	}
+
+	int32 PathStart;
+	if (Remaining.FindChar(TEXT('/'), PathStart))
+		Remaining.LeftInline(PathStart);
+
+	FString PortString;
+	if (Remaining.StartsWith(TEXT("[")))
+	{
+		int32 BracketEnd;
+		if (!Remaining.FindChar(TEXT(']'), BracketEnd))
+			return false;
+		OutHost = Remaining.Mid(1, BracketEnd - 1);
+		FString AfterHost = Remaining.Mid(BracketEnd + 1);
+		if (AfterHost.StartsWith(TEXT(":")))
+			PortString = AfterHost.Mid(1);
+		else if (!AfterHost.IsEmpty())
+			return false;
+	}
+	else
+	{
+		int32 FirstColon, LastColon;
+		// More than one colon without brackets is a bare ipv6 address
+		if (Remaining.FindChar(TEXT(':'), FirstColon) && Remaining.FindLastChar(TEXT(':'), LastColon) && FirstColon == LastColon)
+		{
+			OutHost = Remaining.Left(FirstColon);
+			PortString = Remaining.Mid(FirstColon + 1);
+		}
+		else
+		{
+			OutHost = Remaining;
+		}
+	}
+
+	if (OutHost.IsEmpty())
+		return false;
+
+	if (PortString.IsEmpty())
+	{
+		OutPort = 80;
+		return true;
+	}
+
+	if (!PortString.IsNumeric())
+		return false;
+	OutPort = FCString::Atoi(*PortString);
+	return OutPort > 0 && OutPort <= 65535;
+}
+
 void UWebSocketClientWrapper::Connect(const FString& Ip, int32 Port)
 {
-	if (bInitialized)
+	if (bServerSide || State != EWebSocketClientState::Disconnected)
 		return;
 
-	TSharedPtr<FInternetAddr> ServerAddr = ISocketSubsystem::Get()->CreateInternetAddr();
+	RemoteHost = Ip.TrimStartAndEnd();
+	if (RemoteHost.StartsWith(TEXT("[")) && RemoteHost.EndsWith(TEXT("]")))
+		RemoteHost = RemoteHost.Mid(1, RemoteHost.Len() - 2);
+	RemotePort = Port;
+	CurrentReconnectDelay = InitialReconnectDelay;
 
-	TArray<uint8> RawIp;
-	FTCHARToUTF8 Converter(*Ip);
-	RawIp.Append((uint8*)Converter.Get(), Converter.Length());
+	if (!TickHandle.IsValid())
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick));
 
-	ServerAddr->SetRawIp(RawIp);
-	ServerAddr->SetPort(Port);
+	StartConnection();
+}
 
-	IWebSocketNetworkingModule& WebSocketModule = FModuleManager::Get().LoadModuleChecked<IWebSocketNetworkingModule>("WebSocketNetworkingModule");
+bool UWebSocketClientWrapper::ConnectToUrl(const FString& Url)
+{
+	FString Host;
+	int32 Port;
+	if (!ParseEndpoint(Url, Host, Port))
+	{
+		UE_LOG(LogTemp, Error, TEXT("WebSocketClientWrapper: Invalid url %s"), *Url);
+		return false;
+	}
 
-	TSharedPtr<INetworkingWebSocket> Connection = WebSocketModule.CreateConnection(*ServerAddr);
+	Connect(Host, Port);
+	return true;
+}
 
-	Initialize(nullptr, Connection.Get());
+void UWebSocketClientWrapper::StartConnection()
+{
+	const uint32 Attempt = ++ConnectionAttempt;
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+	// Literal addresses don't need a lookup
+	TSharedPtr<FInternetAddr> Address = SocketSubsystem->GetAddressFromString(RemoteHost);
+	if (Address.IsValid())
+	{
+		OnAddressResolved(Address);
+		return;
+	}
+
+	State = EWebSocketClientState::Resolving;
+	StateDeadline = FPlatformTime::Seconds() + ConnectTimeout;
+
+	TWeakObjectPtr<UWebSocketClientWrapper> WeakThis(this);
+	SocketSubsystem->GetAddressInfoAsync([WeakThis, Attempt](FAddressInfoResult Result)
+	{
+		TSharedPtr<FInternetAddr> ResolvedAddress;
+		if (Result.ReturnCode == SE_NO_ERROR && !Result.Results.IsEmpty())
+			ResolvedAddress = Result.Results[0].Address;
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Attempt, ResolvedAddress]()
+		{
+			if (!WeakThis.IsValid() || WeakThis->ConnectionAttempt != Attempt || WeakThis->State != EWebSocketClientState::Resolving)
+				return;
+
+			if (ResolvedAddress.IsValid())
+				WeakThis->OnAddressResolved(ResolvedAddress);
+			else
+				WeakThis->HandleConnectionFailure();
+		});
+	}, *RemoteHost, nullptr, EAddressInfoFlags::Default, NAME_None, ESocketType::SOCKTYPE_Streaming);
 }
 
-void UWebSocketClientWrapper::Disconnect()
+void UWebSocketClientWrapper::OnAddressResolved(TSharedPtr<FInternetAddr> Address)
 {
-	if (Server != nullptr)
+	Address->SetPort(RemotePort);
+
+	IWebSocketNetworkingModule& WebSocketModule = FModuleManager::Get().LoadModuleChecked<IWebSocketNetworkingModule>(TEXT("WebSocketNetworking"));
+
+	TSharedPtr<INetworkingWebSocket> Connection = WebSocketModule.CreateConnection(*Address);
+	if (!Connection.IsValid())
+	{
+		HandleConnectionFailure();
 		return;
+	}
 
-	if (NetworkingWebSocket == nullptr)
+	OwnedWebSocket = Connection;
+	State = EWebSocketClientState::Connecting;
+	StateDeadline = FPlatformTime::Seconds() + ConnectTimeout;
+	Initialize(nullptr, Connection.Get());
+}
+
+void UWebSocketClientWrapper::Disconnect()
+{
+	if (bServerSide)
 		return;
 
-	NetworkingWebSocket = nullptr;
+	++ConnectionAttempt;
+	State = EWebSocketClientState::Disconnected;
+	QueuedMessages.Empty();
+	QueuedBytes = 0;
+	ReleaseConnection();
 
-	bInitialized = false;
+	if (TickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+	}
+	ReleasedWebSockets.Empty();
 }
 
 void UWebSocketClientWrapper::Initialize(UWebSocketServerWrapper *InServer, INetworkingWebSocket *InNetworkingWebSocket)
@@ -58,6 +215,13 @@ void UWebSocketClientWrapper::Initialize(UWebSocketServerWrapper *InServer, INet
 	Server = InServer;
 	NetworkingWebSocket = InNetworkingWebSocket;
 
+	if (InServer != nullptr)
+	{
+		bServerSide = true;
+		State = EWebSocketClientState::Connected;
+	}
+	LastReceiveTime = FPlatformTime::Seconds();
+
 	FWebSocketInfoCallBack ConnectedCallBack;
 	ConnectedCallBack.BindUObject(this, &ThisClass::OnClientConnected);
 	NetworkingWebSocket->SetConnectedCallBack(ConnectedCallBack);
@@ -88,25 +252,202 @@ bool UWebSocketClientWrapper::SendMessage_Implementation(const FString& Message)
 
 bool UWebSocketClientWrapper::SendData(const TArray<uint8>& Data)
 {
-	return NetworkingWebSocket->Send(Data.GetData(), Data.Num(), false);
+	if (State == EWebSocketClientState::Connected && NetworkingWebSocket != nullptr)
+	{
+		if (bCompressionActive && Data.Num() >= CompressionThreshold)
+		{
+			TArray<uint8> Frame;
+			bool bCompressed;
+			{
+				SCOPE_CYCLE_COUNTER(STAT_WebApiServer_WebSocketCompress);
+				bCompressed = Deflate.Compress(Data.GetData(), Data.Num(), Frame);
+			}
+
+			// Without context takeover the peer doesn't depend on the frame, a message that didn't shrink goes out as is
+			if (bCompressed && (Deflate.HasContextTakeover() || Frame.Num() < Data.Num()))
+			{
+				INC_DWORD_STAT_BY(STAT_WebApiServer_WebSocketBytesBeforeCompression, Data.Num());
+				INC_DWORD_STAT_BY(STAT_WebApiServer_WebSocketBytesAfterCompression, Frame.Num());
+				CompressedInputBytes += Data.Num();
+				CompressedOutputBytes += Frame.Num();
+				return SendFrame(Frame);
+			}
+		}
+		return SendFrame(Data);
+	}
+
+	// Outbound connections keep the messages until they are connected again
+	if (IsOutbound() && State != EWebSocketClientState::Disconnected && QueuedMessages.Num() < MaxQueuedMessages)
+	{
+		QueuedMessages.Add(Data);
+		QueuedBytes += Data.Num();
+		return true;
+	}
+
+	return false;
+}
+
+bool UWebSocketClientWrapper::SendFrame(const TArray<uint8>& Frame)
+{
+	INC_DWORD_STAT_BY(STAT_WebApiServer_WebSocketBytesSent, Frame.Num());
+	if (UWebSocketServerWrapper* OwningServer = Server.Get())
+		OwningServer->NotifyActivity();
+	return NetworkingWebSocket->Send(Frame.GetData(), Frame.Num(), false);
+}
+
+bool UWebSocketClientWrapper::SendControlMessage(const FString& Message)
+{
+	FTCHARToUTF8 Converter(*Message);
+	return SendData(TArray<uint8>((const uint8*)Converter.Get(), Converter.Length()));
+}
+
+void UWebSocketClientWrapper::FlushQueuedMessages()
+{
+	if (QueuedMessages.IsEmpty())
+		return;
+
+	// Pipeline everything that accumulated while the connection was down
+	TArray<TArray<uint8>> Pending = MoveTemp(QueuedMessages);
+	QueuedMessages.Reset();
+	QueuedBytes = 0;
+	for (int32 Index = 0; Index < Pending.Num(); ++Index)
+	{
+		if (!SendData(Pending[Index]))
+		{
+			// Lost again while flushing: keep the remaining ones for the next connection
+			for (int32 Remaining = Index; Remaining < Pending.Num() && QueuedMessages.Num() < MaxQueuedMessages; ++Remaining)
+			{
+				QueuedBytes += Pending[Remaining].Num();
+				QueuedMessages.Add(MoveTemp(Pending[Remaining]));
+			}
+			return;
+		}
+	}
+}
+
+bool UWebSocketClientWrapper::Tick(float DeltaTime)
+{
+	ReleasedWebSockets.Empty();
+
+	if (NetworkingWebSocket != nullptr)
+		NetworkingWebSocket->Tick();
+
+	const double Now = FPlatformTime::Seconds();
+	switch (State)
+	{
+	case EWebSocketClientState::Resolving:
+	case EWebSocketClientState::Connecting:
+		if (Now >= StateDeadline)
+			HandleConnectionFailure();
+		break;
+	case EWebSocketClientState::WaitingToReconnect:
+		if (Now >= StateDeadline)
+			StartConnection();
+		break;
+	default:
+		break;
+	}
+
+	return true;
+}
+
+void UWebSocketClientWrapper::ReleaseConnection()
+{
+	if (NetworkingWebSocket != nullptr)
+	{
+		// Stop receiving callbacks from a connection we are dropping
+		FWebSocketInfoCallBack NoInfoCallBack;
+		FWebSocketPacketReceivedCallBack NoReceiveCallBack;
+		NetworkingWebSocket->SetConnectedCallBack(NoInfoCallBack);
+		NetworkingWebSocket->SetSocketClosedCallBack(NoInfoCallBack);
+		NetworkingWebSocket->SetErrorCallBack(NoInfoCallBack);
+		NetworkingWebSocket->SetReceiveCallBack(NoReceiveCallBack);
+	}
+	NetworkingWebSocket = nullptr;
+	bInitialized = false;
+	Framer.Reset();
+	bCompressionOffered = false;
+	bCompressionActive = false;
+	Deflate.Reset(false);
+
+	// We may be inside one of the connection callbacks, destroy it on the next tick
+	if (OwnedWebSocket.IsValid())
+		ReleasedWebSockets.Add(MoveTemp(OwnedWebSocket));
+}
+
+void UWebSocketClientWrapper::HandleConnectionFailure()
+{
+	const bool bWasConnected = State == EWebSocketClientState::Connected;
+	ReleaseConnection();
+
+	if (bWasConnected)
+	{
+		OnDisconnected.Broadcast(this);
+		ClosedDelegate.Broadcast();
+	}
+
+	if (bAutoReconnect)
+	{
+		ScheduleReconnect();
+	}
+	else
+	{
+		State = EWebSocketClientState::Disconnected;
+		QueuedMessages.Empty();
+		QueuedBytes = 0;
+	}
+}
+
+void UWebSocketClientWrapper::ScheduleReconnect()
+{
+	// Jitter spreads the reconnections of many clients dropped at once
+	const float Delay = CurrentReconnectDelay * FMath::FRandRange(0.8f, 1.2f);
+	State = EWebSocketClientState::WaitingToReconnect;
+	StateDeadline = FPlatformTime::Seconds() + Delay;
+	CurrentReconnectDelay = FMath::Min(CurrentReconnectDelay * ReconnectBackoffMultiplier, MaxReconnectDelay);
 }
 
 void UWebSocketClientWrapper::OnClientConnected()
 {
+	State = EWebSocketClientState::Connected;
+	LastReceiveTime = FPlatformTime::Seconds();
+	bPingOutstanding = false;
+	CurrentReconnectDelay = InitialReconnectDelay;
 	OnConnected.Broadcast(this);
+
+	// Messages go uncompressed until the server answers
+	if (bCompressMessages)
+		bCompressionOffered = SendControlMessage(CompressPrefix + (bCompressionContextTakeover ? TEXT("true}") : TEXT("false}")));
+
+	FlushQueuedMessages();
 }
 
 void UWebSocketClientWrapper::OnClientDisconnected()
 {
+	if (IsOutbound())
+	{
+		if (State == EWebSocketClientState::Connected || State == EWebSocketClientState::Connecting)
+			HandleConnectionFailure();
+		return;
+	}
+
+	State = EWebSocketClientState::Disconnected;
 	OnDisconnected.Broadcast(this);
+	ClosedDelegate.Broadcast();
 	Server = nullptr;
 	NetworkingWebSocket = nullptr;
 	bInitialized = false;
+	Framer.Reset();
+	bCompressionActive = false;
+	Deflate.Reset(false);
 }
 
 void UWebSocketClientWrapper::OnClientError()
 {
 	OnError.Broadcast(this);
+
+	if (IsOutbound() && (State == EWebSocketClientState::Connected || State == EWebSocketClientState::Connecting))
+		HandleConnectionFailure();
 }
 
 void UWebSocketClientWrapper::ReceivedRawPacket(void *Data, int32 Count)
@@ -116,7 +457,208 @@ void UWebSocketClientWrapper::ReceivedRawPacket(void *Data, int32 Count)
 		return;
 	}
 
-	FString Message(Count, UTF8_TO_TCHAR(static_cast<const char*>(Data)));
+	INC_DWORD_STAT_BY(STAT_WebApiServer_WebSocketBytesReceived, Count);
+
+	if (UWebSocketServerWrapper* OwningServer = Server.Get())
+		OwningServer->NotifyActivity();
 
+	LastReceiveTime = FPlatformTime::Seconds();
+
+	// A callback may hold part of a message or several of them
+	Framer.MaxMessageSize = MaxMessageSize;
+	const uint8* Bytes = static_cast<const uint8*>(Data);
+	while (Count > 0)
+	{
+		if (bCompressionActive && (Deflate.IsInFrame() || Bytes[0] == MESSAGE_DEFLATE_MARKER))
+		{
+			const int32 Consumed = ReceiveCompressed(Bytes, Count);
+			if (Consumed == INDEX_NONE)
+				return;
+			Bytes += Consumed;
+			Count -= Consumed;
+			continue;
+		}
+
+		// The marker never appears in UTF-8, the text runs up to the next compressed frame
+		int32 TextCount = Count;
+		for (int32 Index = 1; bCompressionActive && Index < Count; ++Index)
+		{
+			if (Bytes[Index] == MESSAGE_DEFLATE_MARKER)
+			{
+				TextCount = Index;
+				break;
+			}
+		}
+
+		const EJsonFramerResult Result = Framer.Feed(Bytes, TextCount, [this](const FString& Message)
+		{
+			DispatchMessage(Message);
+		});
+
+		if (Result == EJsonFramerResult::Oversized)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("WebSocketClientWrapper: Dropped a message over %d bytes"), MaxMessageSize);
+			OnError.Broadcast(this);
+		}
+		else if (Result == EJsonFramerResult::Skipped)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("WebSocketClientWrapper: Skipped bytes that are not part of a json message"));
+			OnError.Broadcast(this);
+		}
+
+		// Dropped from a handler
+		if (NetworkingWebSocket == nullptr)
+			return;
+		Bytes += TextCount;
+		Count -= TextCount;
+	}
+}
+
+int32 UWebSocketClientWrapper::ReceiveCompressed(const uint8* Bytes, int32 Count)
+{
+	bool bComplete, bOversized;
+	const int32 Consumed = Deflate.FeedFrame(Bytes, Count, MaxMessageSize, bComplete, bOversized);
+
+	TArray<uint8> Message;
+	bool bInflated = true;
+	if (bComplete)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_WebApiServer_WebSocketDecompress);
+		bInflated = Deflate.DecompressFrame(MaxMessageSize, Message);
+	}
+
+	if (bOversized || !bInflated)
+	{
+		// The stream can't be resynchronized, and with context takeover neither can the inflate window
+		UE_LOG(LogTemp, Warning, TEXT("WebSocketClientWrapper: Dropping the connection after a compressed message over %d bytes or corrupted"), MaxMessageSize);
+		OnError.Broadcast(this);
+		if (IsOutbound())
+			HandleConnectionFailure();
+		else if (UWebSocketServerWrapper* OwningServer = Server.Get())
+			OwningServer->ReapClient(this);
+		else
+			Abandon();
+		return INDEX_NONE;
+	}
+
+	if (bComplete)
+	{
+		INC_DWORD_STAT(STAT_WebApiServer_WebSocketMessagesInflated);
+		FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Message.GetData()), Message.Num());
+		DispatchMessage(FString(Converter.Length(), Converter.Get()));
+		if (NetworkingWebSocket == nullptr)
+			return INDEX_NONE;
+	}
+	return Consumed;
+}
+
+void UWebSocketClientWrapper::DispatchMessage(const FString& Message)
+{
+	if (HandleHeartbeat(Message) || HandleCompressionOffer(Message))
+		return;
+
+	INC_DWORD_STAT(STAT_WebApiServer_WebSocketMessagesReceived);
 	OnMessageRecieved.Broadcast(this, Message);
-}
\ No newline at end of file
+}
+
+bool UWebSocketClientWrapper::HandleCompressionOffer(const FString& Message)
+{
+	if (!Message.StartsWith(CompressPrefix, ESearchCase::CaseSensitive))
+		return false;
+
+	const bool bPeerTakeover = FCString::Strncmp(*Message + CompressPrefix.Len(), TEXT("true"), 4) == 0;
+	const bool bContextTakeover = bPeerTakeover && bCompressionContextTakeover;
+
+	if (IsOutbound())
+	{
+		// The answer of the server to our offer
+		if (!bCompressionOffered)
+			return true;
+		bCompressionOffered = false;
+	}
+	else
+	{
+		// Peers that don't compress get no answer and keep receiving plain messages
+		if (!bCompressMessages || bCompressionActive)
+			return true;
+		SendControlMessage(CompressPrefix + (bContextTakeover ? TEXT("true}") : TEXT("false}")));
+	}
+
+	// Everything sent before this point was uncompressed, on both sides
+	Deflate.Reset(bContextTakeover);
+	bCompressionActive = true;
+	return true;
+}
+
+bool UWebSocketClientWrapper::SendPing()
+{
+	if (State != EWebSocketClientState::Connected)
+		return false;
+
+	if (!SendControlMessage(FString::Printf(TEXT("%s%d}"), *PingPrefix, ++PingSequence)))
+		return false;
+
+	INC_DWORD_STAT(STAT_WebApiServer_WebSocketPingsSent);
+	PingSentTime = FPlatformTime::Seconds();
+	bPingOutstanding = true;
+	return true;
+}
+
+bool UWebSocketClientWrapper::HandleHeartbeat(const FString& Message)
+{
+	// Heartbeats are always sent in this exact form, anything else goes to the listeners
+	if (Message.StartsWith(PingPrefix, ESearchCase::CaseSensitive))
+	{
+		SendControlMessage(PongPrefix + Message.RightChop(PingPrefix.Len()));
+		return true;
+	}
+
+	if (!Message.StartsWith(PongPrefix, ESearchCase::CaseSensitive))
+		return false;
+
+	const int32 Sequence = FCString::Atoi(*Message + PongPrefix.Len());
+	if (!bPingOutstanding || Sequence != PingSequence)
+		return true;
+
+	bPingOutstanding = false;
+	const float Sample = FPlatformTime::Seconds() - PingSentTime;
+	if (!bHasRttSample)
+	{
+		SmoothedRtt = Sample;
+		RttVariation = Sample / 2.0f;
+		bHasRttSample = true;
+	}
+	else
+	{
+		RttVariation = 0.75f * RttVariation + 0.25f * FMath::Abs(SmoothedRtt - Sample);
+		SmoothedRtt = 0.875f * SmoothedRtt + 0.125f * Sample;
+	}
+	return true;
+}
+
+float UWebSocketClientWrapper::GetIdleTime() const
+{
+	return FPlatformTime::Seconds() - LastReceiveTime;
+}
+
+bool UWebSocketClientWrapper::GetRoundTripTime(float& OutSmoothedRtt, float& OutRttVariation) const
+{
+	if (!bHasRttSample)
+		return false;
+
+	OutSmoothedRtt = SmoothedRtt;
+	OutRttVariation = RttVariation;
+	return true;
+}
+
+void UWebSocketClientWrapper::Abandon()
+{
+	// The networking module owns server side sockets and has no call to close one, it keeps it until the peer or the OS drops it.
+	// With the callbacks detached nothing more is read from it or sent on it.
+	ReleaseConnection();
+	State = EWebSocketClientState::Disconnected;
+	Server = nullptr;
+	bPingOutstanding = false;
+	OnDisconnected.Broadcast(this);
+	ClosedDelegate.Broadcast();
+}
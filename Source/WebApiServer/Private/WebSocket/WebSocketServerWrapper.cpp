@@ -5,7 +5,22 @@
 #include "IWebSocketNetworkingModule.h"
 #include "IWebSocketServer.h"
 #include "INetworkingWebSocket.h"
+#include "WebSocketNetworkingDelegates.h"
 #include "WebSocket/WebSocketClientWrapper.h"
+#include "WebApiServerStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Connections Rejected"), STAT_WebApiServer_WebSocketConnectionsRejected, STATGROUP_WebApiServer);
+DECLARE_CYCLE_STAT(TEXT("WebSocket Server Tick"), STAT_WebApiServer_WebSocketServerTick, STATGROUP_WebApiServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Polls"), STAT_WebApiServer_WebSocketPolls, STATGROUP_WebApiServer);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("WebSocket Poll Rate"), STAT_WebApiServer_WebSocketPollRate, STATGROUP_WebApiServer);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("WebSocket Clients Reaped"), STAT_WebApiServer_WebSocketClientsReaped, STATGROUP_WebApiServer);
+
+/** First delay of the Adaptive policy once the server goes idle, doubled on every idle poll */
+static constexpr double MinIdleInterval = 1.0 / 240.0;
+
+/** Seconds between checks of the heartbeat and idle timeouts */
+static constexpr float HeartbeatCheckInterval = 0.1f;
 
 UWebSocketServerWrapper::~UWebSocketServerWrapper()
 {
@@ -22,45 +37,192 @@ UWebSocketServerWrapper* UWebSocketServerWrapper::NewWebSocketServer(UObject* Ou
 
 void UWebSocketServerWrapper::StartServer(int32 Port)
 {
+    StopServer();
+
     WebSocketPort = Port;
+    RejectedConnectionCount = 0;
     ServerWebSocket = FModuleManager::Get().LoadModuleChecked<IWebSocketNetworkingModule>(TEXT("WebSocketNetworking")).CreateServer();
 
     FWebSocketClientConnectedCallBack CallBack;
     CallBack.BindUObject(this, &ThisClass::OnWebSocketClientConnected);
 
+    // Connections over MaxClients fail their handshake and are closed by the networking module
+    FWebSocketFilterConnectionCallback FilterCallBack;
+    FilterCallBack.BindWeakLambda(this, [this](FString Origin, FString ClientIP) {
+		return AdmitConnection() ? EWebsocketConnectionFilterResult::ConnectionAccepted : EWebsocketConnectionFilterResult::ConnectionRefused;
+    });
+    ServerWebSocket->SetFilterConnectionCallback(FilterCallBack);
+
     if (!ServerWebSocket->Init(WebSocketPort, CallBack))
     {
+        UE_LOG(LogTemp, Error, TEXT("WebSocketServerWrapper: Failed to listen on port %d"), Port);
         ServerWebSocket.Reset();
-        CallBack.Unbind();
         return;
     }
 
-    TWeakObjectPtr<UWebSocketServerWrapper> WeakThis(this);
-    TickHandle = FTSTicker::GetCoreTicker().AddTicker(
-        FTickerDelegate::CreateLambda([WeakThis](float time) {
-		if (WeakThis.IsValid() && WeakThis->ServerWebSocket)
-		{
-			WeakThis->ServerWebSocket->Tick();
-			return true;
-		}
-		return false;
-    }));
+    NextPollTime = FPlatformTime::Seconds();
+    IdleInterval = 0.0;
+    LastActivityCount = ActivityCount;
+    PollsInWindow = 0;
+    PollWindowStart = FPlatformTime::Seconds();
+    MeasuredPollRate = 0.0f;
+    ReapedClientCount = 0;
+
+    TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickServer));
+    HeartbeatTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickHeartbeats), HeartbeatCheckInterval);
+}
+
+bool UWebSocketServerWrapper::TickServer(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_WebApiServer_WebSocketServerTick);
+
+    if (!IsRunning())
+        return false;
+
+    const double Now = FPlatformTime::Seconds();
+    const int32 MaxPolls = FMath::Max(MaxPollsPerFrame, 1);
+    int32 Polls = 1;
+
+    switch (TickPolicy)
+    {
+    case EWebSocketServerTickPolicy::FrameLocked:
+        break;
+
+    case EWebSocketServerTickPolicy::FixedRate:
+    {
+        const double Interval = 1.0 / FMath::Max(PollRate, 1.0f);
+        if (Now < NextPollTime)
+            return true;
+
+        // Polls due since the last frame. Debt beyond MaxPollsPerFrame is dropped instead of carried over.
+        Polls = FMath::Min(1 + FMath::FloorToInt((Now - NextPollTime) / Interval), MaxPolls);
+        NextPollTime = FMath::Max(NextPollTime + Polls * Interval, Now);
+        break;
+    }
+
+    case EWebSocketServerTickPolicy::Adaptive:
+        // Anything sent since the last poll is flushed right away, whatever the backoff
+        if (Now < NextPollTime && ActivityCount == LastActivityCount)
+            return true;
+        Polls = MaxPolls;
+        break;
+    }
+
+    const uint32 ActivityBefore = ActivityCount;
+    int32 PollsDone = 0;
+    while (PollsDone < Polls)
+    {
+        const uint32 ActivityBeforePoll = ActivityCount;
+        ServerWebSocket->Tick();
+        ++PollsDone;
+
+        // Callbacks may have stopped the server
+        if (!IsRunning())
+            return false;
+
+        // Adaptive polls again in the same frame only while polls bring traffic
+        if (TickPolicy == EWebSocketServerTickPolicy::Adaptive && ActivityCount == ActivityBeforePoll)
+            break;
+    }
+
+    if (TickPolicy == EWebSocketServerTickPolicy::Adaptive)
+    {
+        const double MaxIdleInterval = 1.0 / FMath::Max(IdlePollRate, 1.0f);
+        if (ActivityCount != ActivityBefore || ActivityBefore != LastActivityCount)
+            IdleInterval = 0.0;
+        else
+            IdleInterval = FMath::Clamp(IdleInterval * 2.0, MinIdleInterval, FMath::Max(MaxIdleInterval, MinIdleInterval));
+        NextPollTime = Now + IdleInterval;
+        LastActivityCount = ActivityCount;
+    }
+
+    INC_DWORD_STAT_BY(STAT_WebApiServer_WebSocketPolls, PollsDone);
+    PollsInWindow += PollsDone;
+    if (Now - PollWindowStart >= 1.0)
+    {
+        MeasuredPollRate = PollsInWindow / (Now - PollWindowStart);
+        SET_FLOAT_STAT(STAT_WebApiServer_WebSocketPollRate, MeasuredPollRate);
+        PollsInWindow = 0;
+        PollWindowStart = Now;
+    }
+
+    return true;
 }
 
 void UWebSocketServerWrapper::StopServer()
 {
-    ServerWebSocket = nullptr;
+    if (HeartbeatTickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(HeartbeatTickHandle);
+        HeartbeatTickHandle.Reset();
+    }
 
     if (TickHandle.IsValid())
     {
         FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
         TickHandle.Reset();
     }
+    ServerWebSocket.Reset();
+
+    // Interests are registered by the clients of this run
+    InterestGrid.Reset();
 }
 
 bool UWebSocketServerWrapper::IsRunning() const
 {
-    return ServerWebSocket != nullptr && ServerWebSocket.IsValid();
+    return ServerWebSocket.IsValid();
+}
+
+bool UWebSocketServerWrapper::TickHeartbeats(float DeltaTime)
+{
+    if (HeartbeatInterval <= 0.0f && IdleTimeout <= 0.0f)
+        return true;
+
+    const double Now = FPlatformTime::Seconds();
+
+    TArray<UWebSocketClientWrapper*> DeadClients;
+    for (UWebSocketClientWrapper* Client : WebSocketClients)
+    {
+        const double SinceReceive = Now - Client->LastReceiveTime;
+        if (IdleTimeout > 0.0f && SinceReceive >= IdleTimeout)
+        {
+            DeadClients.Add(Client);
+            continue;
+        }
+
+        if (HeartbeatInterval <= 0.0f)
+            continue;
+
+        // Anything received after the ping proves the peer alive, even if it doesn't speak rpc.pong
+        const bool bUnanswered = Client->bPingOutstanding && Client->LastReceiveTime < Client->PingSentTime;
+        if (bUnanswered)
+        {
+            if (Now - Client->PingSentTime >= HeartbeatTimeout)
+                DeadClients.Add(Client);
+            continue;
+        }
+
+        if (Now - Client->PingSentTime >= HeartbeatInterval)
+            Client->SendPing();
+    }
+
+    for (UWebSocketClientWrapper* Client : DeadClients)
+        ReapClient(Client);
+
+    return true;
+}
+
+void UWebSocketServerWrapper::ReapClient(UWebSocketClientWrapper* Client)
+{
+    INC_DWORD_STAT(STAT_WebApiServer_WebSocketClientsReaped);
+    ++ReapedClientCount;
+
+    // Detaches the socket callbacks, including the closed callback referencing the client
+    Client->Abandon();
+    NotifyActivity();
+    WebSocketClients.Remove(Client);
+    InterestGrid.RemoveClient(Client);
+    OnClientDisconnect.Broadcast(this, Client);
 }
 
 void UWebSocketServerWrapper::Broadcast(const FString &Payload)
@@ -81,15 +243,80 @@ void UWebSocketServerWrapper::Broadcast(const FString &Payload)
     }
 }
 
+void UWebSocketServerWrapper::BroadcastRelevant(const FString &Payload, const FVector& Location)
+{
+    TArray<UObject*> Clients;
+    InterestGrid.QueryLocation(Location, Clients);
+    SendToClients(Payload, Clients);
+}
+
+void UWebSocketServerWrapper::BroadcastToTag(const FString &Payload, FName Tag)
+{
+    TArray<UObject*> Clients;
+    InterestGrid.QueryTag(Tag, Clients);
+    SendToClients(Payload, Clients);
+}
+
+void UWebSocketServerWrapper::SendToClients(const FString &Payload, const TArray<UObject*>& Clients)
+{
+    if (!IsRunning() || Clients.IsEmpty())
+        return;
+
+    // Converted once for all the recipients
+    TArray<uint8> Data;
+    FTCHARToUTF8 Converter(*Payload);
+    Data.Append((uint8 *)Converter.Get(), Converter.Length());
+
+    for (UObject* Object : Clients)
+    {
+        UWebSocketClientWrapper* Client = Cast<UWebSocketClientWrapper>(Object);
+        if (Client != nullptr && WebSocketClients.Contains(Client))
+            Client->SendData(Data);
+    }
+}
+
+void UWebSocketServerWrapper::SetClientInterest(UWebSocketClientWrapper* Client, const FVector& Center, float Radius)
+{
+    if (Client != nullptr && WebSocketClients.Contains(Client))
+        InterestGrid.SetInterest(Client, Center, Radius);
+}
+
+void UWebSocketServerWrapper::SetClientInterestTags(UWebSocketClientWrapper* Client, const TArray<FName>& Tags)
+{
+    if (Client != nullptr && WebSocketClients.Contains(Client))
+        InterestGrid.SetTags(Client, Tags);
+}
+
+bool UWebSocketServerWrapper::AdmitConnection()
+{
+    if (MaxClients <= 0 || WebSocketClients.Num() < MaxClients)
+        return true;
+
+    INC_DWORD_STAT(STAT_WebApiServer_WebSocketConnectionsRejected);
+    ++RejectedConnectionCount;
+    NotifyActivity();
+    return false;
+}
+
 void UWebSocketServerWrapper::OnWebSocketClientConnected(INetworkingWebSocket *ClientWebSocket)
 {
+    NotifyActivity();
+
     UWebSocketClientWrapper *NewClient = NewObject<UWebSocketClientWrapper>();
+    NewClient->MaxMessageSize = MaxMessageSize;
+    NewClient->bCompressMessages = bCompressMessages;
+    NewClient->CompressionThreshold = CompressionThreshold;
+    NewClient->bCompressionContextTakeover = bCompressionContextTakeover;
     NewClient->Initialize(this, ClientWebSocket);
     WebSocketClients.Add(NewClient);
 
     FWebSocketInfoCallBack ClosedCallBack;
     ClosedCallBack.BindLambda([this, NewClient]() {
+		// The client must forget the socket the server is about to delete
+		NewClient->OnClientDisconnected();
+		NotifyActivity();
 		WebSocketClients.Remove(NewClient);
+		InterestGrid.RemoveClient(NewClient);
 		OnClientDisconnect.Broadcast(this, NewClient);
     });
     ClientWebSocket->SetSocketClosedCallBack(ClosedCallBack);
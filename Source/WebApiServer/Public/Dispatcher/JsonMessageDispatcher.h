@@ -4,8 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "UObject/ObjectKey.h"
+#include "Containers/Ticker.h"
+#include "Containers/Queue.h"
+#include <atomic>
 #include "Serialization/JsonTypes.h"
 #include "Json/JsonObjectWrapperType.h"
+#include "Json/JsonArenaDocument.h"
+#include "Dispatcher/JsonRpcResponseCache.h"
+#include "Dispatcher/JsonRpcDispatcherShard.h"
 #include "Messaging/MessageSender.h"
 #include "JsonMessageDispatcher.generated.h"
 
@@ -14,9 +21,22 @@
 #define JSONRPC_PARAMS "params"
 #define JSONRPC_RESULT "result"
 #define JSONRPC_ERROR "error"
+#define JSONRPC_CHUNK "chunk"
+#define JSONRPC_STREAM_CREDIT "rpc.credit"
 #define JSONRPC_ID_MAX 10000000
+/** Timeout asking SendRequest to wait for the round trip time of the sender instead of a fixed delay, see UJsonMessageDispatcher::AdaptiveTimeoutBase */
+#define JSONRPC_ADAPTIVE_TIMEOUT 0.0f
 
 class UJsonPromise;
+struct FJsonRpcIncomingParams;
+struct FJsonRpcInFlightRequest;
+struct FJsonRpcConflationQueue;
+struct FJsonRpcClientAdmission;
+struct FJsonRpcBulkhead;
+struct FJsonRpcShardRegistry;
+struct FJsonRpcShardSender;
+struct FJsonRpcDeferredMessage;
+struct FJsonRpcResponseStream;
 
 /* Request Handlers */
 
@@ -28,6 +48,15 @@ typedef TFunction<void (const FString&)> FJsonRpcRequestErrorCallback;
 typedef TFunction<TSharedPtr<FJsonValue> (const TSharedPtr<FJsonValue>&)> FJsonRpcRequestHandlerLambda;
 typedef TFunction<TSharedPtr<FJsonValue> (const TArray<TSharedPtr<FJsonValue>>&)> FJsonRpcRequestHandlerStructuredArrayLambda;
 typedef TFunction<TSharedPtr<FJsonValue> (const TSharedPtr<FJsonObject>&)> FJsonRpcRequestHandlerStructuredObjectLambda;
+/** View handlers borrow the params of the message instead of receiving copies. The views must not be kept after the call. */
+typedef TFunction<TSharedPtr<FJsonValue> (TConstArrayView<TSharedPtr<FJsonValue>>)> FJsonRpcRequestHandlerArrayViewLambda;
+typedef TFunction<TSharedPtr<FJsonValue> (const FJsonObject&)> FJsonRpcRequestHandlerObjectViewLambda;
+/** Params are given as a view into the message. The view must not be kept after the call. */
+typedef TFunction<TSharedPtr<FJsonValue> (const FJsonArenaView&)> FJsonRpcRequestHandlerCompactLambda;
+/** Produces the next chunk of a streamed response. Returns false once the stream is over, with OutError set if it failed. */
+typedef TFunction<bool (TSharedPtr<FJsonValue>& OutChunk, FString& OutError)> FJsonRpcChunkProducer;
+/** Returns the producer of the response, called again every time the connection can take more */
+typedef TFunction<FJsonRpcChunkProducer (const TSharedPtr<FJsonValue>&)> FJsonRpcStreamingRequestHandlerLambda;
 
 USTRUCT()
 struct FJsonRpcRequestHandler
@@ -39,6 +68,17 @@ struct FJsonRpcRequestHandler
 
     TFunction<void (const TSharedPtr<FJsonValue>&, const FJsonRpcRequestCompletionCallback&, const FJsonRpcRequestErrorCallback&)> Action;
 
+    /** Set for compact handlers, used instead of Action when the message was parsed into a compact document */
+    TFunction<void (const FJsonArenaView&, const FJsonRpcRequestCompletionCallback&, const FJsonRpcRequestErrorCallback&)> CompactAction;
+
+    /** Set for handlers producing an already serialized result. Takes the result and the error, returns false on error. */
+    TFunction<bool (FString&, FString&)> SerializedAction;
+
+    /** Set for streaming handlers, see RegisterStreamingRequestHandler */
+    FJsonRpcStreamingRequestHandlerLambda StreamAction;
+
+    /** Never run by a shard thread, set for Blueprint, async and snapshot handlers */
+    bool bGameThreadBound = false;
 };
 
 /* Notification Handlers */
@@ -48,6 +88,9 @@ DECLARE_DYNAMIC_DELEGATE_OneParam(FJsonRpcNotificationHandlerDelegate, FJsonObje
 typedef TFunction<void(const TSharedPtr<FJsonValue>&)> FJsonRpcNotificationHandlerLambda;
 typedef TFunction<void(const TArray<TSharedPtr<FJsonValue>>&)> FJsonRpcNotificationHandlerStructuredArrayLambda;
 typedef TFunction<void(const TSharedPtr<FJsonObject>&)> FJsonRpcNotificationHandlerStructuredObjectLambda;
+typedef TFunction<void(TConstArrayView<TSharedPtr<FJsonValue>>)> FJsonRpcNotificationHandlerArrayViewLambda;
+typedef TFunction<void(const FJsonObject&)> FJsonRpcNotificationHandlerObjectViewLambda;
+typedef TFunction<void(const FJsonArenaView&)> FJsonRpcNotificationHandlerCompactLambda;
 
 
 USTRUCT()
@@ -59,6 +102,11 @@ struct FJsonRpcNotificationHandler
     TWeakObjectPtr<UObject> Owner;
 
     FJsonRpcNotificationHandlerLambda Action;
+
+    FJsonRpcNotificationHandlerCompactLambda CompactAction;
+
+    /** Never run by a shard thread, set for Blueprint handlers */
+    bool bGameThreadBound = false;
 };
 
 /* Response Handlers */
@@ -66,10 +114,12 @@ struct FJsonRpcNotificationHandler
 DECLARE_DYNAMIC_DELEGATE_ThreeParams(FJsonRpcResponseHandlerDelegate, bool, bSuccess, const FJsonObjectWrapper&, Result, const FString&, Error);
 DECLARE_DYNAMIC_DELEGATE_OneParam(FJsonRpcResponseSuccessHandlerDelegate, const FJsonObjectWrapper&, Result);
 DECLARE_DYNAMIC_DELEGATE_OneParam(FJsonRpcResponseFailureHandlerDelegate, const FString&, Error);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FJsonRpcResponseChunkHandlerDelegate, const FJsonObjectWrapper&, Chunk);
 
 typedef TFunction<void(bool, const TSharedPtr<FJsonValue>&, const FString&)> FJsonRpcResponseHandlerLambda;
 typedef TFunction<void(const TSharedPtr<FJsonValue>&)> FJsonRpcResponseSuccessHandlerLambda;
 typedef TFunction<void(const FString&)> FJsonRpcResponseFailureHandlerLambda;
+typedef TFunction<void(const TSharedPtr<FJsonValue>&)> FJsonRpcResponseChunkHandlerLambda;
 
 USTRUCT()
 struct FJsonRpcResponseHandler
@@ -77,8 +127,192 @@ struct FJsonRpcResponseHandler
     GENERATED_BODY()
 
     FJsonRpcResponseHandlerLambda CompletionHandler;
+
+    /** Called for every chunk of a streamed response. Without it the chunks are collected and the completion handler gets them as an array. */
+    FJsonRpcResponseChunkHandlerLambda ChunkHandler;
+
+    TArray<TSharedPtr<FJsonValue>> Chunks;
     
     FDateTime Timeout;
+
+    /** Restarted by every chunk, a stream only times out when it stalls */
+    float TimeoutSeconds = 0.0f;
+
+    /** Peer the request was sent to */
+    UPROPERTY()
+    TWeakObjectPtr<UObject> MessageSender;
+
+    /** Streaming requests grant the peer a credit for every chunk handled, see StreamCreditWindow */
+    bool bGrantsCredits = false;
+
+    /** Chunks handled since the last credit was granted */
+    int32 UncreditedChunks = 0;
+};
+
+/** Message received by a shard that must be handled by the game thread */
+struct FJsonRpcInboundMessage
+{
+    TSharedPtr<FJsonObject> Message;
+    TWeakObjectPtr<UObject> MessageSender;
+    TSharedPtr<FJsonRpcShardSender> ShardSender;
+    /** Length of the message received by the shard, for the slow call records */
+    int32 MessageSize = 0;
+};
+
+/** Message serialized by a producer thread, sent by the game thread */
+struct FJsonRpcOutboundMessage
+{
+    TWeakObjectPtr<UObject> MessageSender;
+    FString Message;
+    /** Requests only: registered as response handler right before the message is sent */
+    int32 RequestId = 0;
+    FJsonRpcResponseHandlerLambda CompletionHandler;
+    float Timeout = 0.0f;
+};
+
+/** Shared with the handlers completing on other threads, so they can queue their response without reaching the dispatcher */
+typedef TQueue<FJsonRpcOutboundMessage, EQueueMode::Mpsc> FJsonRpcOutboundQueue;
+
+/* Interceptors */
+
+/** Runs before the request handler. Return false to answer with OutError instead of running it. */
+typedef TFunction<bool (const FString& Method, const TSharedPtr<FJsonValue>& Params, const TScriptInterface<IMessageSender>& MessageSender, FString& OutError)> FJsonRpcRequestInterceptorLambda;
+/** Runs before the notification handlers. Return false to drop the notification. */
+typedef TFunction<bool (const FString& Method, const TSharedPtr<FJsonValue>& Params)> FJsonRpcNotificationInterceptorLambda;
+/** Runs on every message the dispatcher sends. May rewrite the message, return false to drop it. */
+typedef TFunction<bool (const TScriptInterface<IMessageSender>& MessageSender, FString& Message)> FJsonRpcOutgoingInterceptorLambda;
+
+/** Cross-cutting hooks such as auth checks, logging or tracing, see UJsonMessageDispatcher::AddInterceptor. Any hook may be left unset. */
+struct FJsonRpcInterceptor
+{
+    FJsonRpcRequestInterceptorLambda OnRequest;
+    FJsonRpcNotificationInterceptorLambda OnNotification;
+    FJsonRpcOutgoingInterceptorLambda OnOutgoing;
+
+    /** Interceptors run by increasing priority, then in the order they were added */
+    int32 Priority = 0;
+
+    TWeakObjectPtr<UObject> Owner;
+};
+
+/* Snapshots */
+
+typedef TFunction<TSharedPtr<FJsonValue> ()> FJsonRpcSnapshotProducerLambda;
+
+USTRUCT()
+struct FJsonRpcSnapshot
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TWeakObjectPtr<UObject> Owner;
+
+    FJsonRpcSnapshotProducerLambda Producer;
+
+    /** Output of the producer for the frame BuildFrame */
+    FString SerializedValue;
+
+    uint64 BuildFrame = MAX_uint64;
+};
+
+/* Method Policies */
+
+/** Options applied to the requests of a method, see UJsonMessageDispatcher::SetMethodPolicy */
+USTRUCT(BlueprintType)
+struct FJsonRpcMethodPolicy
+{
+    GENERATED_BODY()
+
+    /**
+     * Answer identical requests (same params) with the stored result instead of running the handler.
+     * Only for methods whose result depends on nothing but their params. Errors are never cached.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cache")
+    bool bCacheResponses = false;
+
+    /** Seconds a cached result stays valid */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cache", meta = (EditCondition = "bCacheResponses"))
+    float CacheTimeToLive = 1.0f;
+
+    /**
+     * Identical requests received while one is running wait for it and get its result, instead of running the handler again.
+     * Mostly useful for slow or async handlers hit by many clients at once.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Coalescing")
+    bool bCoalesceInFlight = false;
+
+    /** Requests per second a single client may send to this method, 0 for no limit. Requests over the limit get a "rate_limited" error. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Admission")
+    float RequestsPerSecondPerClient = 0.0f;
+
+    /** Requests a client may send at once above the rate */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Admission", meta = (EditCondition = "RequestsPerSecondPerClient > 0"))
+    int32 RequestBurstPerClient = 10;
+
+    /** Requests of this method running at once, from all clients, 0 for no limit. Extra requests wait in a queue. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bulkhead")
+    int32 MaxInFlight = 0;
+
+    /** Requests waiting for a slot. Requests over it are rejected right away with a "method_busy" error. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bulkhead", meta = (EditCondition = "MaxInFlight > 0"))
+    int32 MaxQueued = 32;
+
+    /** Seconds a request may wait for a slot before it's rejected with a "queue_timeout" error, 0 to wait forever */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bulkhead", meta = (EditCondition = "MaxInFlight > 0"))
+    float QueueTimeout = 10.0f;
+
+    /**
+     * With shards running, handle the requests and notifications of this method on the game thread instead of a shard thread.
+     * Needed by lambda handlers touching game state. Methods using the cache, coalescing, rate or bulkhead options always are.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threading")
+    bool bGameThreadBound = false;
+};
+
+/** Traffic shed by the admission limits of a dispatcher */
+USTRUCT(BlueprintType)
+struct FJsonRpcAdmissionStats
+{
+    GENERATED_BODY()
+
+    /** Messages dropped by MessagesPerSecondPerClient, before parsing */
+    UPROPERTY(BlueprintReadOnly, Category = "Admission")
+    int32 RejectedMessages = 0;
+
+    /** Requests rejected by a method RequestsPerSecondPerClient */
+    UPROPERTY(BlueprintReadOnly, Category = "Admission")
+    int32 RejectedRequests = 0;
+
+    /** Requests rejected by MaxPendingRequestsPerClient */
+    UPROPERTY(BlueprintReadOnly, Category = "Admission")
+    int32 RejectedPendingRequests = 0;
+};
+
+/** Handler call that went over HandlerBudgetMs */
+USTRUCT(BlueprintType)
+struct FJsonRpcSlowCall
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Watchdog")
+    FString Method;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Watchdog")
+    bool bNotification = false;
+
+    /** Length of the message the call came in, of the whole batch for batched calls. 0 for messages not received as text. */
+    UPROPERTY(BlueprintReadOnly, Category = "Watchdog")
+    int32 MessageSize = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Watchdog")
+    float DurationMs = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Watchdog")
+    FDateTime Time;
+
+    /** Engine frame the call ran in, to match against hitches */
+    UPROPERTY(BlueprintReadOnly, Category = "Watchdog")
+    int64 Frame = 0;
 };
 
 /**
@@ -91,6 +325,8 @@ class WEBAPISERVER_API UJsonMessageDispatcher : public UObject
 
 public:
 
+    virtual ~UJsonMessageDispatcher() override;
+
     /** Register a request handler. Request handlers are unique per methods. */
     UFUNCTION(BlueprintCallable, Category = "Handler|Request", meta = (DefaultToSelf = "Identifier"))
     bool RegisterRequestHandler(const FString& Method, const FJsonRpcRequestHandlerDelegate& Handler, UObject* Owner = nullptr, bool bOverride = false);
@@ -101,6 +337,27 @@ public:
 
     bool RegisterRequestHandler(const FString& Method, const TMap<FString, EJson>& ExpectedTypes, const FJsonRpcRequestHandlerStructuredObjectLambda& Handler, UObject* Owner = nullptr, bool bOverride = false);
 
+    /** Same as the structured overloads, with the params borrowed from the message instead of copied */
+    bool RegisterRequestViewHandler(const FString& Method, const TArray<EJson>& ExpectedTypes, const FJsonRpcRequestHandlerArrayViewLambda& Handler, UObject* Owner = nullptr, bool bOverride = false);
+
+    bool RegisterRequestViewHandler(const FString& Method, const TMap<FString, EJson>& ExpectedTypes, const FJsonRpcRequestHandlerObjectViewLambda& Handler, UObject* Owner = nullptr, bool bOverride = false);
+
+    /** Register a request handler reading its params through a compact document view, see bUseCompactJsonDom */
+    bool RegisterCompactRequestHandler(const FString& Method, const FJsonRpcRequestHandlerCompactLambda& Handler, UObject* Owner = nullptr, bool bOverride = false);
+
+    /**
+     * Register a handler answering with a stream of chunks instead of one result, for results too large to be built at once.
+     *
+     * The handler returns a producer which is called on the game thread for one chunk at a time, at most MaxStreamChunksPerTick
+     * per tick, so a slow client slows the producer down instead of piling up memory. It's paced by the credits the requester
+     * grants with {"method":"rpc.credit","params":{"id":N,"chunks":K}}, see StreamCreditWindow, and, for connections that
+     * know it, by the bytes waiting to be sent. Requesters that don't grant credits are only paced by the connection.
+     * Every chunk is sent as {"id":N,"chunk":...} and the stream ends with {"id":N,"result":null} or an error.
+     * Senders that can't stream, such as HTTP exchanges, get all the chunks as one array result.
+     * Cache, coalescing, bulkhead and pending request limits don't apply to streams.
+     */
+    bool RegisterStreamingRequestHandler(const FString& Method, const FJsonRpcStreamingRequestHandlerLambda& Handler, UObject* Owner = nullptr, bool bOverride = false);
+
     UFUNCTION(BlueprintCallable, Category = "Handler|Request", meta = (DefaultToSelf = "Owner"))
     bool RegisterRequestAsyncHandler(const FString& Method, const FJsonRpcRequestHandlerAsyncDelegate& Handler, UObject* Owner = nullptr, bool bOverride = false);
 
@@ -125,6 +382,12 @@ public:
 
     void RegisterNotificationHandler(const FString& Method, const TMap<FString, EJson>& ExpectedTypes, const FJsonRpcNotificationHandlerStructuredObjectLambda& Handler, UObject* Owner = nullptr);
 
+    void RegisterNotificationViewHandler(const FString& Method, const TArray<EJson>& ExpectedTypes, const FJsonRpcNotificationHandlerArrayViewLambda& Handler, UObject* Owner = nullptr);
+
+    void RegisterNotificationViewHandler(const FString& Method, const TMap<FString, EJson>& ExpectedTypes, const FJsonRpcNotificationHandlerObjectViewLambda& Handler, UObject* Owner = nullptr);
+
+    void RegisterCompactNotificationHandler(const FString& Method, const FJsonRpcNotificationHandlerCompactLambda& Handler, UObject* Owner = nullptr);
+
     /** Check if a notification handler is registered */
     UFUNCTION(BlueprintCallable, Category = "Handler|Notification")
     bool IsNotificationHandlerRegistered(const FString& Method, UObject* Owner = nullptr) const;
@@ -141,30 +404,207 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Handler")
     void UnregisterHandlersFromOwner(UObject* Owner);
 
+    /** Method Policies */
+
+    UFUNCTION(BlueprintCallable, Category = "Policy")
+    void SetMethodPolicy(const FString& Method, const FJsonRpcMethodPolicy& Policy);
+
+    UFUNCTION(BlueprintCallable, Category = "Policy")
+    void ClearMethodPolicy(const FString& Method);
+
+    UFUNCTION(BlueprintCallable, Category = "Policy")
+    bool GetMethodPolicy(const FString& Method, FJsonRpcMethodPolicy& OutPolicy) const;
+
+    /** Requests of the method currently running under its MaxInFlight limit */
+    UFUNCTION(BlueprintCallable, Category = "Policy|Bulkhead")
+    int32 GetInFlightCount(const FString& Method) const;
+
+    /** Requests of the method waiting for a slot */
+    UFUNCTION(BlueprintCallable, Category = "Policy|Bulkhead")
+    int32 GetQueuedCount(const FString& Method) const;
+
+    /** Drop the cached results of a method, to call when the data it reads has changed */
+    UFUNCTION(BlueprintCallable, Category = "Policy|Cache")
+    void InvalidateCachedResponses(const FString& Method);
+
+    UFUNCTION(BlueprintCallable, Category = "Policy|Cache")
+    void InvalidateAllCachedResponses();
+
+    /** Memory used by cached results of all methods, least recently used results are evicted past it */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Policy|Cache")
+    int32 ResponseCacheMaxBytes = 16 * 1024 * 1024;
+
+    /** Seconds after which a coalesced request that never completed stops holding back identical requests. Checked by Cleanup. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Policy|Coalescing", meta = (ClampMin = 0))
+    float InFlightRequestTimeout = 30.0f;
+
+    /** Snapshots */
+
+    /**
+     * Register a named piece of state shared by several handlers.
+     * The producer runs at most once per frame, on the first use, and its serialized output is reused for the rest of the frame.
+     */
+    void RegisterSnapshotProducer(const FString& Name, const FJsonRpcSnapshotProducerLambda& Producer, UObject* Owner = nullptr);
+
+    UFUNCTION(BlueprintCallable, Category = "Snapshot")
+    void UnregisterSnapshotProducer(const FString& Name);
+
+    /** Serialized snapshot of the current frame, built if needed */
+    UFUNCTION(BlueprintCallable, Category = "Snapshot")
+    bool GetSerializedSnapshot(const FString& Name, FString& OutSerializedValue);
+
+    /** Register a request handler answering with a snapshot, without serializing it again for every request of the frame */
+    UFUNCTION(BlueprintCallable, Category = "Snapshot", meta = (DefaultToSelf = "Owner"))
+    bool RegisterSnapshotRequestHandler(const FString& Method, const FString& SnapshotName, UObject* Owner = nullptr, bool bOverride = false);
+
+    /** Admission */
+
+    /**
+     * Messages per second accepted from a single sender, 0 for no limit. Messages over the limit are answered with a fixed error without being parsed.
+     * A batch counts as one message per element.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Admission")
+    float MessagesPerSecondPerClient = 0.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Admission", meta = (EditCondition = "MessagesPerSecondPerClient > 0"))
+    int32 MessageBurstPerClient = 50;
+
+    /** Requests of a single sender waiting on a handler to complete, 0 for no limit */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Admission")
+    int32 MaxPendingRequestsPerClient = 0;
+
+    /** Seconds after which a request whose handler never completed stops counting toward MaxPendingRequestsPerClient */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Admission", meta = (ClampMin = 0, EditCondition = "MaxPendingRequestsPerClient > 0"))
+    float PendingRequestTimeout = 60.0f;
+
+    UFUNCTION(BlueprintCallable, Category = "Admission")
+    FJsonRpcAdmissionStats GetAdmissionStats() const { return AdmissionStats; }
+
+    /**
+     * Charge Count messages to the MessagesPerSecondPerClient limit of the sender. False, and counted as rejected, when over it.
+     * HandleMessage does it itself, transports handing parsed messages to HandleJsonMessage call it first.
+     */
+    bool AdmitMessages(const TScriptInterface<IMessageSender>& MessageSender, int32 Count);
+
+    UFUNCTION(BlueprintCallable, Category = "Admission")
+    void ResetAdmissionStats() { AdmissionStats = FJsonRpcAdmissionStats(); }
+
     /** Send Messages */
 
+    /**
+     * Requests sent with JSONRPC_ADAPTIVE_TIMEOUT, or any timeout <= 0, wait this long plus the retransmission timeout of the connection (SRTT + 4 RTTVAR),
+     * for senders measuring their round trip time such as WebSocket clients with heartbeats. Requests keep their fixed timeout, 5 seconds by default, otherwise.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Send|Request")
+    float AdaptiveTimeoutBase = 1.0f;
+
+    /** Upper bound of adaptive timeouts, also used while the sender has no round trip measurement */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Send|Request")
+    float MaxAdaptiveTimeout = 10.0f;
+
+    /** Timeout of a request sent to the sender, adaptive if Timeout <= 0 */
+    float GetRequestTimeout(const TScriptInterface<IMessageSender>& MessageSender, float Timeout) const;
+
+    /** Complete the requests waiting on a response of the sender with an error, for instance once it's disconnected */
+    UFUNCTION(BlueprintCallable, Category = "Send|Request")
+    void FailPendingRequests(const TScriptInterface<IMessageSender>& MessageSender, const FString& Error = TEXT("disconnected"));
+
+    /** Timeout in seconds, or JSONRPC_ADAPTIVE_TIMEOUT (0 from Blueprints) to derive it from the round trip time of the sender */
     UFUNCTION(BlueprintCallable, Category = "Send|Request")
     void SendRequestWithCompletion(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FJsonObjectWrapper& Params, EJsonObjectWrapperType ParamsType, const FJsonRpcResponseHandlerDelegate& CompletionHandler, float Timeout = 5.0f);
 
+    /** Timeout in seconds, or JSONRPC_ADAPTIVE_TIMEOUT (0 from Blueprints) to derive it from the round trip time of the sender */
     UFUNCTION(BlueprintCallable, Category = "Send|Request")
     void SendRequestWithSuccessOrFailure(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FJsonObjectWrapper& Params, EJsonObjectWrapperType ParamsType, const FJsonRpcResponseSuccessHandlerDelegate& SuccessHandler, const FJsonRpcResponseFailureHandlerDelegate& FailureHandler, float Timeout = 5.0f);
 
+    /** Timeout in seconds, or JSONRPC_ADAPTIVE_TIMEOUT (0 from Blueprints) to derive it from the round trip time of the sender */
     UFUNCTION(BlueprintCallable, Category = "Send|Request")
     void SendRequestWithPromise(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FJsonObjectWrapper& Params, EJsonObjectWrapperType ParamsType, UJsonPromise* Promise, float Timeout = 5.0f);
 
+    /** Timeout in seconds, or JSONRPC_ADAPTIVE_TIMEOUT (0 from Blueprints) to derive it from the round trip time of the sender */
     void SendRequest(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const FJsonRpcResponseHandlerLambda& CompletionHandler, float Timeout = 5.0f);
 
+    /** Timeout in seconds, or JSONRPC_ADAPTIVE_TIMEOUT (0 from Blueprints) to derive it from the round trip time of the sender */
     void SendRequest(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const FJsonRpcResponseSuccessHandlerLambda& SuccessHandler, const FJsonRpcResponseFailureHandlerLambda& FailureHandler, float Timeout = 5.0f);
 
+    /** Timeout in seconds, or JSONRPC_ADAPTIVE_TIMEOUT (0 from Blueprints) to derive it from the round trip time of the sender */
     void SendRequest(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, UJsonPromise* Promise, float Timeout = 5.0f);
 
+    /**
+     * Send a request answered by a streaming handler, see RegisterStreamingRequestHandler. The chunk handler is called as
+     * chunks arrive and the completion handler once the stream ends. Every chunk restarts the timeout, which can be JSONRPC_ADAPTIVE_TIMEOUT as well.
+     * Streamed responses to the other SendRequest variants complete with the array of all the chunks instead.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Send|Request")
+    void SendStreamingRequestWithCompletion(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FJsonObjectWrapper& Params, EJsonObjectWrapperType ParamsType, const FJsonRpcResponseChunkHandlerDelegate& ChunkHandler, const FJsonRpcResponseHandlerDelegate& CompletionHandler, float Timeout = 5.0f);
+
+    void SendStreamingRequest(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const FJsonRpcResponseChunkHandlerLambda& ChunkHandler, const FJsonRpcResponseHandlerLambda& CompletionHandler, float Timeout = 5.0f);
+
+    /** Streams started by streaming handlers produce chunks while their sender has less than this many bytes waiting to be sent */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Send|Stream")
+    int32 StreamSendWindow = 256 * 1024;
+
+    /**
+     * Chunks of a streamed response the peer may send ahead of the chunk handler of SendStreamingRequest.
+     * The window is granted with the request and replenished as chunks are handled, 0 to not grant credits.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Send|Stream", meta = (ClampMin = 0))
+    int32 StreamCreditWindow = 64;
+
+    /** Chunks a stream may produce per tick, so a fast connection doesn't hold the game thread. Also applies to streams sent as one result. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Send|Stream", meta = (ClampMin = 1))
+    int32 MaxStreamChunksPerTick = 16;
+
+    /** Streamed responses still being produced. Streams of a sender are dropped once it reports its close. */
+    UFUNCTION(BlueprintCallable, Category = "Send|Stream")
+    int32 GetActiveStreamCount() const { return ResponseStreams.Num(); }
+
     UFUNCTION(BlueprintCallable, Category = "Send|Notification")
     void SendNotification(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FJsonObjectWrapper& Params, EJsonObjectWrapperType ParamsType);
 
     void SendNotification(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params);
 
+    /**
+     * Thread safe versions of SendRequest and SendNotification.
+     *
+     * The message is built and serialized on the calling thread, then pushed to a lock free queue the game thread
+     * drains every frame to send it. The response handler is registered by the game thread when the message goes out,
+     * and is called on the game thread like any other. The dispatcher and the sender must outlive the calls.
+     * JSONRPC_ADAPTIVE_TIMEOUT is resolved on the game thread, when the request goes out.
+     */
+    void SendRequestAnyThread(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const FJsonRpcResponseHandlerLambda& CompletionHandler, float Timeout = 5.0f);
+
+    void SendNotificationAnyThread(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params);
+
+    /** Send the messages queued by other threads now instead of waiting for the next tick. Game thread only. */
+    void FlushOutboundQueue();
+
+    /**
+     * Hold the notification until the next flush, replacing any notification with the same method and key still held for this sender.
+     * Held notifications of a sender are sent together as one batch message, so only the latest value per key is serialized and sent.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Send|Notification")
+    void SendNotificationConflated(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FString& Key, const FJsonObjectWrapper& Params, EJsonObjectWrapperType ParamsType);
+
+    void SendNotificationConflated(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const FString& Key, const TSharedPtr<FJsonValue>& Params);
+
+    /** Send the held notifications now instead of waiting for the next flush */
+    UFUNCTION(BlueprintCallable, Category = "Send|Notification")
+    void FlushConflatedNotifications();
+
+    /** Seconds between automatic flushes of held notifications, 0 to flush every frame */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Send|Notification")
+    float ConflationFlushInterval = 0.0f;
+
     /** Message handling */
 
+    /**
+     * Parse incoming messages into a reused compact document instead of a tree of FJsonValue.
+     * Compact handlers read the message in place; other handlers get their params converted on demand.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Message")
+    bool bUseCompactJsonDom = false;
+
     UFUNCTION(BlueprintCallable)
     void HandleMessage(const FString& Message, TScriptInterface<IMessageSender> MessageSender);
 
@@ -173,6 +613,88 @@ public:
 
     void HandleJsonMessage(const TSharedPtr<FJsonObject>& JsonMessage, TScriptInterface<IMessageSender> MessageSender);
 
+    /** Interceptors */
+
+    /**
+     * Install hooks run before every request and notification handler and on every message sent, returns a handle for RemoveInterceptor.
+     *
+     * The hooks of all interceptors are flattened into one array per kind when interceptors are added or removed, so a message
+     * goes through a plain loop instead of nested handler wrappers, and through a single empty check when none are installed.
+     * Hooks may add or remove interceptors, the change applies from the next message.
+     * Request and notification hooks also run on shard threads while shards are running and must then be thread safe.
+     * They get the params as a json value, converted from the compact document when bUseCompactJsonDom is set.
+     */
+    int32 AddInterceptor(const FJsonRpcInterceptor& Interceptor);
+
+    bool RemoveInterceptor(int32 Handle);
+
+    /** Remove the interceptors added with this owner. Interceptors without owner are only removed by handle, a null owner is ignored. */
+    UFUNCTION(BlueprintCallable, Category = "Interceptor")
+    void RemoveInterceptorsFromOwner(UObject* Owner);
+
+    UFUNCTION(BlueprintCallable, Category = "Interceptor")
+    int32 GetInterceptorCount() const { return Interceptors.Num(); }
+
+    bool HasOutgoingInterceptors() const { return !OutgoingInterceptors->IsEmpty(); }
+
+    /** Run the outgoing hooks on the message, false if one of them dropped it */
+    bool InterceptOutgoing(const TScriptInterface<IMessageSender>& MessageSender, FString& Message) const;
+
+    /** Watchdog */
+
+    /**
+     * Time spent by a request or notification handler on the game thread above which the call is recorded as slow, 0 to disable.
+     * Asynchronous handlers are only timed until they return. Requests queued by a bulkhead are timed when they start.
+     * Handlers run by shards aren't timed.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Watchdog")
+    float HandlerBudgetMs = 0.0f;
+
+    /** Slow calls kept by GetSlowCalls, the oldest ones are overwritten */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Watchdog", meta = (ClampMin = 0))
+    int32 SlowCallHistorySize = 64;
+
+    /** Seconds between two slow call warnings in the log. Slow calls in between are still recorded. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Watchdog")
+    float SlowCallLogInterval = 1.0f;
+
+    /** Recorded slow calls, oldest first */
+    UFUNCTION(BlueprintCallable, Category = "Watchdog")
+    TArray<FJsonRpcSlowCall> GetSlowCalls() const;
+
+    /** Slow calls since the dispatcher was created or cleared, including the ones overwritten */
+    UFUNCTION(BlueprintCallable, Category = "Watchdog")
+    int32 GetSlowCallCount() const { return SlowCallCount; }
+
+    UFUNCTION(BlueprintCallable, Category = "Watchdog")
+    void ClearSlowCalls();
+
+    /** Shards */
+
+    /**
+     * Handle incoming messages on NumShards worker threads instead of the game thread, 0 to stop.
+     *
+     * Every sender is pinned to one shard, so its messages keep their order. Shards run the handlers from a read-only copy
+     * of the registered handlers, refreshed when handlers or policies change; their responses are sent by the game thread.
+     * Responses, game thread bound handlers and methods with game thread policies are handed back to the game thread, as are
+     * all the requests while request interceptors are registered. Once a message of a sender is handed back, its following
+     * messages go to the game thread too until that one is done, so they still run in order.
+     * Lambda handlers must be thread safe, or be flagged with bGameThreadBound in their method policy.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Shards")
+    void StartShards(int32 NumShards);
+
+    /** Messages still queued on the shards are dropped. Responses of handlers completing later are sent on the next tick. */
+    UFUNCTION(BlueprintCallable, Category = "Shards")
+    void StopShards();
+
+    /** Messages waiting on a shard, 0 for no limit. Messages over the limit are answered with {"id":null,"error":"server_busy"} without being parsed. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shards", meta = (ClampMin = 0))
+    int32 MaxShardQueueLength = 4096;
+
+    UFUNCTION(BlueprintCallable, Category = "Shards")
+    int32 GetNumShards() const { return Shards.Num(); }
+
     /** Cleanup */
 
     UFUNCTION(BlueprintCallable)
@@ -182,13 +704,148 @@ private:
 
     bool HaveValidRequestHandler(const FString& Method) const;
 
-    void HandleRequest(int32 Id, const FString& Method, const TSharedPtr<FJsonValue>& Params, TScriptInterface<IMessageSender> MessageSender);
-    void HandleNotification(const FString& Method, const TSharedPtr<FJsonValue>& Params);
+    /** Register or replace the handler of a method, dropping the results of the replaced one */
+    void AddRequestHandler(const FString& Method, const TSharedPtr<FJsonRpcRequestHandler>& Handler);
+
+    /** Drop the cached and in-flight results of a method whose handler changed */
+    void InvalidateMethodResults(const FString& Method);
+
+    bool Tick(float DeltaTime);
+
+    /** Queued messages, conflated notifications, bulkhead queues, streams or shards the tick has to service */
+    bool HasPendingWork() const;
+
+    /** Admission state of the sender, nullptr if it isn't a valid object */
+    FJsonRpcClientAdmission* FindOrAddClientAdmission(const TScriptInterface<IMessageSender>& MessageSender);
+
+    /** Release the state kept for the sender once its connection closes, see IMessageSender::GetClosedDelegate */
+    void ObserveSender(const TScriptInterface<IMessageSender>& MessageSender);
+    void HandleSenderClosed(TObjectKey<UObject> Sender);
+    void StartTicking();
+
+    void HandleCompactMessage(const FString& Message, TScriptInterface<IMessageSender> MessageSender);
+    void HandleCompactJsonMessage(const FJsonArenaView& JsonMessage, TScriptInterface<IMessageSender> MessageSender);
+
+    void DispatchToShard(const FString& Message, const TScriptInterface<IMessageSender>& MessageSender);
+    void RebuildShardRegistry();
+    void FlushInboundQueue();
+
+    /** Shard thread side */
+    void HandleShardMessage(const FJsonRpcShardRegistry& Registry, const FString& Message, const TSharedRef<FJsonRpcShardSender>& Sender, bool bRunRequests);
+    void HandleShardJsonMessage(const FJsonRpcShardRegistry& Registry, const TSharedPtr<FJsonObject>& JsonMessage, const TSharedRef<FJsonRpcShardSender>& Sender, bool bRunRequests, int32 MessageSize);
+    void QueueOutboundMessage(const TWeakObjectPtr<UObject>& MessageSender, FString&& Message);
+
+    /** Deferred is set for requests handed back by a shard, and released once the handler completes */
+    void HandleRequest(int32 Id, const FString& Method, const FJsonRpcIncomingParams& Params, TScriptInterface<IMessageSender> MessageSender,
+        const TSharedPtr<FJsonRpcDeferredMessage>& Deferred = nullptr);
+    void HandleNotification(const FString& Method, const FJsonRpcIncomingParams& Params);
     void HandleResponse(int32 Id, const TSharedPtr<FJsonValue>& Result, const TSharedPtr<FJsonValue>& Error);
+    void HandleResponseChunk(int32 Id, const TSharedPtr<FJsonValue>& Chunk);
+
+    /** Chunks granted by the requester of a stream, params are {"id":N,"chunks":K} */
+    void HandleStreamCredit(const TSharedPtr<FJsonValue>& Params, const TScriptInterface<IMessageSender>& MessageSender);
+    void SendStreamCredit(const TScriptInterface<IMessageSender>& MessageSender, int32 Id, int32 Chunks);
+
+    /** Register the response handler and send the request, returns its id */
+    int32 SendRequestWithHandler(const TScriptInterface<IMessageSender>& MessageSender, const FString& Method, const TSharedPtr<FJsonValue>& Params, const TSharedPtr<FJsonRpcResponseHandler>& Handler, float Timeout);
+
+    void StartResponseStream(int32 Id, const FJsonRpcRequestHandler& Handler, const TSharedPtr<FJsonValue>& Params, const TScriptInterface<IMessageSender>& MessageSender);
+    /** Produce the chunks the sender can take now, false once the stream is over */
+    bool PumpResponseStream(FJsonRpcResponseStream& Stream);
+    void PumpResponseStreams();
+
+    void RunInBulkhead(const FString& Method, const FJsonRpcMethodPolicy& Policy, const TSharedPtr<FJsonRpcRequestHandler>& Handler, const TSharedPtr<FJsonValue>& Params,
+        const FJsonRpcRequestCompletionCallback& CompletionCallback, const FJsonRpcRequestErrorCallback& FailureCallback);
+    void DrainBulkhead(const FString& Method);
+    void ExpireBulkheadQueues();
+
+    /** Flatten the hooks of Interceptors into the per kind arrays */
+    void RebuildInterceptors();
+
+    void RecordSlowCall(const FString& Method, int32 MessageSize, bool bNotification, double DurationMs);
+
+    void RemoveInFlightRequest(const FJsonRpcRequestKey& Key, const TSharedPtr<FJsonRpcInFlightRequest>& InFlightRequest);
 
     TMap<FString, TSharedPtr<FJsonRpcRequestHandler>> RequestHandlers;
     TMap<FString, TArray<TSharedPtr<FJsonRpcNotificationHandler>>> NotificationHandlers;
     TMap<int32, TSharedPtr<FJsonRpcResponseHandler>> ResponseHandlers;
-    int32 LastRequestId = 0;
+
+    /** Request ids are taken from any thread */
+    int32 NextRequestId();
+    std::atomic<uint32> RequestIdCounter { 0 };
+
+    TSharedRef<FJsonRpcOutboundQueue> OutboundQueue = MakeShared<FJsonRpcOutboundQueue>();
+
+    TMap<FString, FJsonRpcMethodPolicy> MethodPolicies;
+
+    TMap<FString, FJsonRpcSnapshot> Snapshots;
+
+    FJsonRpcResponseCache ResponseCache;
+
+    TMap<TObjectKey<UObject>, TSharedPtr<FJsonRpcClientAdmission>> ClientAdmissions;
+
+    FJsonRpcAdmissionStats AdmissionStats;
+
+    /** Senders whose closed delegate is bound, kept until they're destroyed since the binding outlives a close */
+    TSet<TObjectKey<UObject>> ObservedSenders;
+
+    /** Notifications held by SendNotificationConflated, per sender */
+    TMap<TObjectKey<UObject>, TSharedPtr<FJsonRpcConflationQueue>> ConflationQueues;
+
+    double LastConflationFlushTime = 0.0;
+
+    FTSTicker::FDelegateHandle TickHandle;
+
+    /** Set once the ticker is requested, from any thread */
+    std::atomic<bool> bTickingRequested { false };
+
+    TArray<TSharedPtr<FJsonRpcResponseStream>> ResponseStreams;
+
+    /** Sorted by priority, with their handles */
+    TArray<TPair<int32, FJsonRpcInterceptor>> Interceptors;
+    int32 NextInterceptorHandle = 0;
+
+    /** Replaced by RebuildInterceptors rather than modified, the loops running the hooks hold on to the arrays they started with */
+    TSharedRef<const TArray<FJsonRpcRequestInterceptorLambda>> RequestInterceptors = MakeShared<TArray<FJsonRpcRequestInterceptorLambda>>();
+    TSharedRef<const TArray<FJsonRpcNotificationInterceptorLambda>> NotificationInterceptors = MakeShared<TArray<FJsonRpcNotificationInterceptorLambda>>();
+    TSharedRef<const TArray<FJsonRpcOutgoingInterceptorLambda>> OutgoingInterceptors = MakeShared<TArray<FJsonRpcOutgoingInterceptorLambda>>();
+
+    /** Ring buffer of the last slow calls, NextSlowCall is the oldest once it's full */
+    TArray<FJsonRpcSlowCall> SlowCalls;
+    int32 NextSlowCall = 0;
+    int32 SlowCallCount = 0;
+    int32 SuppressedSlowCallLogs = 0;
+    double LastSlowCallLogTime = -DBL_MAX;
+
+    friend struct FJsonRpcHandlerWatchdog;
+
+    /** Running and waiting requests of methods with a MaxInFlight limit */
+    TMap<FString, TSharedPtr<FJsonRpcBulkhead>> Bulkheads;
+
+    /** Requests of methods with bCoalesceInFlight currently running */
+    TMap<FJsonRpcRequestKey, TSharedPtr<FJsonRpcInFlightRequest>> InFlightRequests;
+
+    /** Reused for every message while bUseCompactJsonDom is set */
+    FJsonArenaDocument CompactDocument;
+
+    /** A handler may dispatch a message itself, in which case that message can't reuse CompactDocument */
+    bool bCompactDocumentInUse = false;
+
+    /** Length of the message being handled, recorded with the slow calls it leads to */
+    int32 HandledMessageSize = 0;
+
+    TArray<TUniquePtr<FJsonRpcDispatcherShard>> Shards;
+
+    /** Handlers the shards may run, shared with the messages queued on the shards */
+    TSharedPtr<const FJsonRpcShardRegistry> ShardRegistry;
+
+    /** Set when handlers or policies change, the registry is rebuilt on the next sharded message */
+    bool bShardRegistryDirty = true;
+
+    /** Messages handed back by the shards */
+    TQueue<FJsonRpcInboundMessage, EQueueMode::Mpsc> InboundQueue;
+
+    /** Senders whose messages went to a shard, game thread only */
+    TMap<TObjectKey<UObject>, TSharedPtr<FJsonRpcShardSender>> ShardSenders;
 
 };
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+class FRunnableThread;
+class FEvent;
+
+/**
+ * Worker thread of a sharded dispatcher, see UJsonMessageDispatcher::StartShards.
+ * Runs the work it's given in order, so messages of a connection pinned to the shard are handled in the order they were received.
+ */
+class WEBAPISERVER_API FJsonRpcDispatcherShard : public FRunnable
+{
+public:
+
+    explicit FJsonRpcDispatcherShard(int32 InIndex);
+
+    /** Stops and joins the thread. Work still queued is dropped. */
+    virtual ~FJsonRpcDispatcherShard() override;
+
+    /** Queue work for the shard thread, from any thread */
+    void Enqueue(TUniqueFunction<void ()>&& Work);
+
+    /** Work queued and not started yet */
+    int32 GetQueuedCount() const { return QueuedCount.load(std::memory_order_relaxed); }
+
+    int32 GetIndex() const { return Index; }
+
+    virtual uint32 Run() override;
+
+    virtual void Stop() override;
+
+private:
+
+    int32 Index;
+
+    TQueue<TUniqueFunction<void ()>, EQueueMode::Mpsc> Queue;
+
+    std::atomic<int32> QueuedCount { 0 };
+
+    std::atomic<bool> bStopping { false };
+
+    FEvent* WorkEvent = nullptr;
+
+    FRunnableThread* Thread = nullptr;
+};
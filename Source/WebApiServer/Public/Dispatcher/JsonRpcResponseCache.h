@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonValue.h"
+#include "Containers/List.h"
+
+/** Identifies a request by method and params. Params are compared by value, the hash only narrows the search. */
+struct FJsonRpcRequestKey
+{
+    FJsonRpcRequestKey() = default;
+    FJsonRpcRequestKey(const FString& InMethod, const TSharedPtr<FJsonValue>& InParams);
+
+    FString Method;
+    TSharedPtr<FJsonValue> Params;
+    uint32 Hash = 0;
+
+    bool operator==(const FJsonRpcRequestKey& Other) const;
+
+    friend uint32 GetTypeHash(const FJsonRpcRequestKey& Key) { return Key.Hash; }
+
+    /** Hash of a json value that doesn't depend on the order of object members */
+    static uint32 HashJsonValue(const TSharedPtr<FJsonValue>& Value);
+
+    /** Approximate bytes held by a json value tree, without serializing it */
+    static SIZE_T GetJsonValueSize(const TSharedPtr<FJsonValue>& Value);
+};
+
+/**
+ * Serialized results of requests, for methods whose result only depends on their params.
+ *
+ * Entries expire after their time to live and the least recently used ones are evicted
+ * once the total size goes over MaxBytes.
+ */
+class WEBAPISERVER_API FJsonRpcResponseCache
+{
+public:
+
+    ~FJsonRpcResponseCache();
+
+    SIZE_T MaxBytes = 16 * 1024 * 1024;
+
+    /** Serialized result of a live entry, or nullptr. Expired entries are dropped on the way. */
+    const FString* Find(const FJsonRpcRequestKey& Key, double Now);
+
+    void Add(const FJsonRpcRequestKey& Key, const FString& SerializedResult, double ExpireTime);
+
+    void Invalidate(const FString& Method);
+
+    void Reset();
+
+    int32 Num() const { return Index.Num(); }
+
+    SIZE_T GetUsedBytes() const { return UsedBytes; }
+
+private:
+
+    struct FEntry
+    {
+        FJsonRpcRequestKey Key;
+        FString SerializedResult;
+        double ExpireTime = 0.0;
+        SIZE_T Size = 0;
+    };
+
+    typedef TDoubleLinkedList<FEntry>::TDoubleLinkedListNode FEntryNode;
+
+    void Remove(FEntryNode* Node);
+
+    /** Most recently used first */
+    TDoubleLinkedList<FEntry> Entries;
+    TMap<FJsonRpcRequestKey, FEntryNode*> Index;
+    SIZE_T UsedBytes = 0;
+};
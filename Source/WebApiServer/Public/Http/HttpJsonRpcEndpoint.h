@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Messaging/MessageSender.h"
+#include "Json/JsonArenaDocument.h"
+#include "HttpJsonRpcEndpoint.generated.h"
+
+class IHttpRouter;
+class UJsonMessageDispatcher;
+struct FHttpServerRequest;
+struct FHttpServerResponse;
+struct FHttpRouteHandleInternal;
+
+typedef TFunction<void(TUniquePtr<FHttpServerResponse>&&)> FHttpJsonRpcResultCallback;
+
+/**
+ * Remote address posting to an endpoint.
+ *
+ * Exchanges only live for one body, the dispatcher admission limits are counted on the peer of their address instead.
+ * Clients behind the same proxy or NAT share one peer.
+ */
+UCLASS()
+class WEBAPISERVER_API UHttpJsonRpcPeer : public UObject
+{
+    GENERATED_BODY()
+
+public:
+
+    FDateTime LastRequestTime;
+};
+
+/**
+ * One HTTP POST being answered by the dispatcher.
+ *
+ * Collects the responses the dispatcher sends for the requests of the body, matched by id,
+ * and completes the HTTP response once every request of the body got its answer.
+ */
+UCLASS()
+class WEBAPISERVER_API UHttpJsonRpcExchange : public UObject, public IMessageSender
+{
+    GENERATED_BODY()
+
+public:
+
+    virtual bool SendMessage_Implementation(const FString& Message) override;
+
+    /** The exchange completes after one response per request */
+    virtual bool CanStreamResponses() const override { return false; }
+
+    bool IsCompleted() const { return bCompleted; }
+
+    bool IsExpired(const FDateTime& Now) const { return Now >= Deadline; }
+
+    virtual UObject* GetAdmissionOwner() const override { return Peer; }
+
+    /** Answer with an HTTP error if the body didn't complete yet */
+    void Fail(int32 StatusCode, const FString& Error);
+
+private:
+
+    void Complete();
+
+    UPROPERTY()
+    TObjectPtr<UHttpJsonRpcPeer> Peer;
+
+    FHttpJsonRpcResultCallback OnComplete;
+
+    TArray<FString> Responses;
+
+    /** Ids of the requests of the body still waiting for their response */
+    TArray<int32> PendingIds;
+
+    /** Reused to read the id of each response */
+    FJsonArenaDocument ResponseDocument;
+
+    bool bBatch = false;
+
+    bool bCompleted = false;
+
+    FDateTime Deadline;
+
+    friend class UHttpJsonRpcEndpoint;
+};
+
+/**
+ * HTTP/1.1 endpoint routing POST bodies into a UJsonMessageDispatcher.
+ *
+ * Bodies are single JSON-RPC messages or batches (arrays of messages) and are handled by the same request and notification handlers as the socket transports.
+ * Responses of async handlers are written back when their promise terminates.
+ * Connection keep-alive and request ordering on a connection are handled by the engine HTTPServer module.
+ */
+UCLASS(ClassGroup = (Networking), BlueprintType)
+class WEBAPISERVER_API UHttpJsonRpcEndpoint : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    virtual ~UHttpJsonRpcEndpoint() override;
+
+    UFUNCTION(BlueprintCallable, Category = "HttpEndpoint",
+        meta = (DefaultToSelf = "Outer"))
+    static UHttpJsonRpcEndpoint* NewHttpJsonRpcEndpoint(UObject* Outer, UJsonMessageDispatcher* Dispatcher, int32 Port = 8082, const FString& Path = "/rpc");
+
+    UFUNCTION(BlueprintCallable, Category = "HttpEndpoint")
+    bool StartEndpoint(UJsonMessageDispatcher* InDispatcher, int32 Port, const FString& Path);
+
+    UFUNCTION(BlueprintCallable, Category = "HttpEndpoint")
+    void StopEndpoint();
+
+    UFUNCTION(BlueprintCallable, Category = "HttpEndpoint")
+    bool IsRunning() const;
+
+    /** Seconds after which a body whose requests are still pending is answered with a timeout error */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HttpEndpoint")
+    float RequestTimeout = 30.0f;
+
+protected:
+
+    bool HandleHttpRequest(const FHttpServerRequest& Request, const FHttpJsonRpcResultCallback& OnComplete);
+
+    bool Tick(float DeltaTime);
+
+    UPROPERTY(BlueprintReadOnly, Category = "HttpEndpoint", meta = (AllowPrivateAccess = true))
+    int32 HttpPort;
+
+    UPROPERTY(BlueprintReadOnly, Category = "HttpEndpoint", meta = (AllowPrivateAccess = true))
+    FString HttpPath;
+
+private:
+
+    UPROPERTY()
+    TObjectPtr<UJsonMessageDispatcher> Dispatcher;
+
+    /** Exchanges waiting for async handlers */
+    UPROPERTY()
+    TSet<TObjectPtr<UHttpJsonRpcExchange>> PendingExchanges;
+
+    /** By remote address, dropped once idle for longer than any of their exchanges can wait */
+    UPROPERTY()
+    TMap<FString, TObjectPtr<UHttpJsonRpcPeer>> Peers;
+
+    TSharedPtr<IHttpRouter> Router;
+
+    TSharedPtr<const FHttpRouteHandleInternal> RouteHandle;
+
+    /** Delegate */
+    FTSTicker::FDelegateHandle TickHandle;
+};
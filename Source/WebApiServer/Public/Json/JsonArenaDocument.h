@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonValue.h"
+
+class FJsonArenaDocument;
+
+enum class EJsonArenaType : uint8
+{
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object,
+};
+
+/**
+ * Read-only handle on a value of a FJsonArenaDocument.
+ *
+ * Views are two words and are meant to be passed by value. They are only valid while the document they point into is alive and unchanged,
+ * which for dispatcher handlers means for the duration of the handler call.
+ */
+class WEBAPISERVER_API FJsonArenaView
+{
+public:
+
+    FJsonArenaView() = default;
+
+    /** False for the view of a missing member or an out of range index */
+    bool IsValid() const { return Document != nullptr; }
+
+    EJsonArenaType GetType() const;
+
+    bool IsNull() const { return !IsValid() || GetType() == EJsonArenaType::Null; }
+
+    bool AsBool() const;
+    double AsNumber() const;
+    /** Unescaped string, pointing into the document */
+    FStringView AsString() const;
+
+    /** Same conversions as the FJsonValue equivalents, so numeric strings are accepted as numbers */
+    bool TryGetBool(bool& OutValue) const;
+    bool TryGetNumber(double& OutValue) const;
+    bool TryGetNumber(int32& OutValue) const;
+    bool TryGetString(FString& OutValue) const;
+
+    /** Number of elements of an array or members of an object, duplicate members included */
+    int32 Num() const;
+
+    /** Element of an array, or member of an object, by position */
+    FJsonArenaView operator[](int32 Position) const;
+
+    /** Member of an object by name. With duplicate names the last member wins, as with FJsonObject. */
+    FJsonArenaView Find(FStringView Key) const;
+
+    /** Name of this value when it is a member of an object */
+    FStringView GetKey() const;
+
+    /** Build the equivalent shared json value, for handlers working on FJsonValue */
+    TSharedPtr<FJsonValue> ToJsonValue() const;
+
+    /** Iteration over the elements of an array or the members of an object */
+    class FIterator
+    {
+    public:
+        FIterator(const FJsonArenaDocument* InDocument, int32 InIndex) : Document(InDocument), Index(InIndex) {}
+        FJsonArenaView operator*() const { return FJsonArenaView(Document, Index); }
+        FIterator& operator++();
+        bool operator!=(const FIterator& Other) const { return Index != Other.Index; }
+    private:
+        const FJsonArenaDocument* Document;
+        int32 Index;
+    };
+
+    FIterator begin() const;
+    FIterator end() const;
+
+private:
+
+    FJsonArenaView(const FJsonArenaDocument* InDocument, int32 InIndex) : Document(InDocument), Index(InIndex) {}
+
+    static int32 GetSubtreeEnd(const FJsonArenaDocument* InDocument, int32 InIndex);
+
+    const FJsonArenaDocument* Document = nullptr;
+    int32 Index = INDEX_NONE;
+
+    friend class FJsonArenaDocument;
+};
+
+/**
+ * Compact json document.
+ *
+ * All the values of a message live in one contiguous node array and all the strings in one character pool,
+ * instead of one shared allocation per value and one map per object as with FJsonValue/FJsonObject.
+ * Nodes are stored in document order; a container is followed by its children and knows where its subtree ends.
+ * Reset keeps the capacity so a document reused for successive messages stops allocating once warm.
+ */
+class WEBAPISERVER_API FJsonArenaDocument
+{
+public:
+
+    /** Parse a json text. On failure the document is left empty. */
+    bool Parse(FStringView Text);
+
+    /** Copy an existing json value into the document */
+    void Build(const TSharedPtr<FJsonValue>& Value);
+
+    /** Drop the content, keeping the allocated memory */
+    void Reset();
+
+    FJsonArenaView GetRoot() const;
+
+    int32 GetNodeCount() const { return Nodes.Num(); }
+
+    /** Bytes currently reserved by the arena */
+    SIZE_T GetAllocatedSize() const { return Nodes.GetAllocatedSize() + Strings.GetAllocatedSize(); }
+
+private:
+
+    struct FNode
+    {
+        EJsonArenaType Type = EJsonArenaType::Null;
+        bool bBoolean = false;
+        /** Children of a container, characters of a string */
+        int32 Count = 0;
+        /** Index past the last node of the subtree */
+        int32 End = 0;
+        /** Member name in the string pool for members of an object */
+        int32 KeyOffset = 0;
+        int32 KeyLength = 0;
+        /** Characters of a string in the string pool */
+        int32 StringOffset = 0;
+        double Number = 0.0;
+    };
+
+    int32 AddNode(EJsonArenaType Type, int32 KeyOffset, int32 KeyLength);
+    int32 AddString(FStringView Value);
+    void BuildValue(const TSharedPtr<FJsonValue>& Value, int32 KeyOffset, int32 KeyLength);
+
+    TArray<FNode> Nodes;
+    TArray<TCHAR> Strings;
+
+    friend class FJsonArenaView;
+    friend struct FJsonArenaParser;
+};
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EJsonFramerResult : uint8
+{
+    Ok,
+    /** At least one message went over MaxMessageSize and was dropped */
+    Oversized,
+    /** Bytes outside of any object or array were skipped */
+    Skipped,
+};
+
+/**
+ * Reassembles JSON messages from a stream of UTF-8 fragments.
+ *
+ * Transports such as WebSocketNetworking may hand a large message over in several receive callbacks,
+ * or several small messages in a single one. The framer scans each fragment once as it arrives,
+ * tracking string and nesting state, and emits a message as soon as its top level value closes.
+ * Messages contained in a single fragment are converted straight from it without being buffered.
+ * The size limit is checked before bytes are appended, and an oversized message is skipped
+ * without being stored so the stream stays usable afterwards.
+ * Bytes between messages that don't start an object or array are skipped up to the next one and reported,
+ * so a bad prefix never swallows the valid messages following it.
+ * When a fragment both skips bytes and drops an oversized message, Oversized is reported.
+ */
+class WEBAPISERVER_API FJsonMessageFramer
+{
+public:
+
+    int32 MaxMessageSize = 16 * 1024 * 1024;
+
+    EJsonFramerResult Feed(const uint8* Data, int32 Count, TFunctionRef<void (const FString&)> OnMessage);
+
+    void Reset();
+
+    /** Bytes of the partial message currently held */
+    int32 GetBufferedSize() const { return Buffer.Num(); }
+
+    bool IsInMessage() const { return bInMessage; }
+
+private:
+
+    TArray<uint8> Buffer;
+
+    int32 Depth = 0;
+
+    bool bInMessage = false;
+    bool bInString = false;
+    bool bEscaped = false;
+    bool bDiscarding = false;
+};
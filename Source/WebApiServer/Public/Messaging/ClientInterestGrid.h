@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+/**
+ * Index of what each client is interested in, to find the clients an event is relevant to without testing them all.
+ *
+ * A client is interested in a sphere of the world and in a set of tags. Spheres are indexed in a uniform grid
+ * over the horizontal plane: every cell the sphere overlaps lists the client, so a query only looks at the few
+ * clients of the cell the event happens in. Clients whose sphere covers too many cells are kept in a separate list
+ * and tested on every query.
+ */
+class WEBAPISERVER_API FClientInterestGrid
+{
+public:
+
+    explicit FClientInterestGrid(float InCellSize = 5000.0f);
+
+    /** Spheres covering more cells than this are not indexed */
+    int32 MaxCellsPerClient = 256;
+
+    float GetCellSize() const { return CellSize; }
+
+    /** Set the area the client is interested in. A radius <= 0 removes its spatial interest. */
+    void SetInterest(UObject* Client, const FVector& Center, float Radius);
+
+    void SetTags(UObject* Client, const TArray<FName>& Tags);
+
+    void RemoveClient(UObject* Client);
+
+    void Reset();
+
+    /** Clients whose interest sphere contains the location */
+    void QueryLocation(const FVector& Location, TArray<UObject*>& OutClients) const;
+
+    /** Clients interested in the tag */
+    void QueryTag(FName Tag, TArray<UObject*>& OutClients) const;
+
+    int32 Num() const { return Clients.Num(); }
+
+private:
+
+    struct FInterest
+    {
+        TWeakObjectPtr<UObject> Object;
+        FVector Center = FVector::ZeroVector;
+        float Radius = 0.0f;
+        /** Cells listing the client, inclusive. Empty when not indexed in the grid. */
+        FIntPoint MinCell = FIntPoint(0, 0);
+        FIntPoint MaxCell = FIntPoint(-1, -1);
+        bool bOversized = false;
+        TArray<FName> Tags;
+    };
+
+    FIntPoint GetCell(const FVector& Location) const;
+
+    void UnlinkSpatial(const TObjectKey<UObject>& Key, FInterest& Interest);
+    void UnlinkTags(const TObjectKey<UObject>& Key, FInterest& Interest);
+
+    static bool Contains(const FInterest& Interest, const FVector& Location);
+
+    float CellSize;
+
+    TMap<TObjectKey<UObject>, FInterest> Clients;
+    TMap<FIntPoint, TArray<TObjectKey<UObject>>> Cells;
+    TSet<TObjectKey<UObject>> OversizedClients;
+    TMap<FName, TSet<TObjectKey<UObject>>> TaggedClients;
+};
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "Dom/JsonValue.h"
+#include "Json/JsonObjectWrapperType.h"
+#include "Messaging/MessageSender.h"
+#include "JsonStateStream.generated.h"
+
+/**
+ * Streams a json state to subscribers as json-rpc notifications, sending only what changed.
+ *
+ * Every published state gets a new version. A subscriber receives
+ *   {"method": Method, "params": {"version": V, "snapshot": State}}
+ * the first time, after a resync, or when the changes would be bigger than the state itself, and otherwise
+ *   {"method": Method, "params": {"version": V, "base": B, "patch": Patch}}
+ * where Patch is a json merge patch (RFC 7396) to apply on the version B it already has, omitted if the state is back to B.
+ *
+ * On reliable ordered transports the last version sent is used as base. With bRequireAcknowledge
+ * the base is the last version the subscriber reported through Acknowledge, for clients that may drop messages.
+ * Patches are computed once per base version and shared by every subscriber on that base.
+ */
+UCLASS(BlueprintType)
+class WEBAPISERVER_API UJsonStateStream : public UObject
+{
+    GENERATED_BODY()
+
+public:
+
+    UFUNCTION(BlueprintCallable, Category = "StateStream", meta = (DefaultToSelf = "Outer"))
+    static UJsonStateStream* NewJsonStateStream(UObject* Outer, const FString& Method);
+
+    /** Method of the notifications sent to subscribers */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StateStream")
+    FString Method;
+
+    /** Versions kept to compute patches from. Subscribers further behind receive a snapshot. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StateStream")
+    int32 HistorySize = 16;
+
+    /** Use the version acknowledged by the subscriber as base instead of the last version sent */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StateStream")
+    bool bRequireAcknowledge = false;
+
+    /** Add a subscriber. It receives the current state right away. */
+    UFUNCTION(BlueprintCallable, Category = "StateStream")
+    void Subscribe(const TScriptInterface<IMessageSender>& Subscriber);
+
+    UFUNCTION(BlueprintCallable, Category = "StateStream")
+    void Unsubscribe(const TScriptInterface<IMessageSender>& Subscriber);
+
+    UFUNCTION(BlueprintCallable, Category = "StateStream")
+    int32 GetSubscriberCount() const { return Subscribers.Num(); }
+
+    /** Record a new version of the state and send it to every subscriber. The state is copied, the caller may keep modifying it. */
+    void PublishState(const TSharedPtr<FJsonValue>& State);
+
+    UFUNCTION(BlueprintCallable, Category = "StateStream", DisplayName = "Publish State")
+    void PublishStateWrapper(const FJsonObjectWrapper& State, EJsonObjectWrapperType StateType);
+
+    /** Version the subscriber has applied */
+    UFUNCTION(BlueprintCallable, Category = "StateStream")
+    void Acknowledge(const TScriptInterface<IMessageSender>& Subscriber, int32 Version);
+
+    /** Send the full current state to the subscriber, for instance when it failed to apply a patch */
+    UFUNCTION(BlueprintCallable, Category = "StateStream")
+    void Resync(const TScriptInterface<IMessageSender>& Subscriber);
+
+    UFUNCTION(BlueprintCallable, Category = "StateStream")
+    int32 GetVersion() const { return CurrentVersion; }
+
+private:
+
+    struct FSubscriber
+    {
+        TWeakObjectPtr<UObject> Object;
+        /** Version the next patch is computed from, INDEX_NONE for a snapshot */
+        int32 BaseVersion = INDEX_NONE;
+    };
+
+    struct FVersion
+    {
+        int32 Version = 0;
+        TSharedPtr<FJsonValue> State;
+    };
+
+    void SendCurrentState(FSubscriber& Subscriber);
+
+    const FString& GetSnapshotMessage();
+
+    /** Patch message from the base version to the current one, empty if it can't be built or isn't worth it */
+    const FString& GetPatchMessage(int32 BaseVersion);
+
+    TMap<TObjectKey<UObject>, FSubscriber> Subscribers;
+
+    /** Oldest first, the last one is the current state */
+    TArray<FVersion> History;
+
+    int32 CurrentVersion = 0;
+
+    /** Messages for the current version, built on first use */
+    FString SnapshotMessage;
+    TMap<int32, FString> PatchMessages;
+};
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Size in bytes of the big-endian length header preceding every frame. */
+#define LENGTH_PREFIX_SIZE 4
+
+/** Result of trying to extract one frame from the receive buffer. */
+enum class ELengthPrefixedReadResult : uint8
+{
+    /** A complete frame was extracted. */
+    Frame,
+    /** Not enough bytes buffered yet. */
+    NeedMoreData,
+    /** The announced frame size exceeds the configured maximum. The stream can't be recovered. */
+    Oversized,
+};
+
+/**
+ * Stream framing used by the raw socket transports.
+ *
+ * Every message is sent as a 4 bytes big-endian payload length followed by the UTF-8 payload.
+ * Outgoing frames are appended to a send buffer, incoming bytes are appended to a receive buffer
+ * from which complete frames are popped.
+ */
+class WEBAPISERVER_API FLengthPrefixedFraming
+{
+public:
+
+    /** Frames larger than this are rejected before any memory is reserved for them. */
+    int32 MaxFrameSize = 16 * 1024 * 1024;
+
+    /** Append a framed UTF-8 copy of the message to the send buffer */
+    void QueueMessage(const FString& Message);
+
+    /** Append a framed copy of the raw payload to the send buffer */
+    void QueueData(const uint8* Data, int32 Size);
+
+    /** Bytes queued and not yet consumed by ConsumeSent */
+    int32 GetPendingSendBytes() const { return SendBuffer.Num() - SendOffset; }
+
+    const uint8* GetPendingSendData() const { return SendBuffer.GetData() + SendOffset; }
+
+    /** Mark the given amount of pending bytes as sent */
+    void ConsumeSent(int32 Count);
+
+    /** Writable tail of the receive buffer, grown so it can hold at least MinSize bytes */
+    uint8* GetReceiveSlack(int32 MinSize);
+
+    /** Commit bytes written into the slack returned by GetReceiveSlack */
+    void CommitReceived(int32 Count);
+
+    /** True when any frame header received so far announces a frame bigger than MaxFrameSize */
+    bool HasOversizedFrame();
+
+    /** True once a maximal frame worth of bytes is buffered. Complete frames must be read before receiving more. */
+    bool IsReceiveBufferFull() const { return ReceiveBuffer.Num() - ReceiveOffset >= static_cast<int64>(MaxFrameSize) + LENGTH_PREFIX_SIZE; }
+
+    ELengthPrefixedReadResult TryReadMessage(FString& OutMessage);
+
+    void Reset();
+
+private:
+
+    TArray<uint8> SendBuffer;
+    int32 SendOffset = 0;
+
+    TArray<uint8> ReceiveBuffer;
+    int32 ReceiveOffset = 0;
+
+    /** Next frame header not checked by HasOversizedFrame yet */
+    int32 ScanOffset = 0;
+};
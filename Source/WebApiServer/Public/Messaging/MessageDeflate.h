@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** First byte of a compressed frame. 0xC1 never starts valid UTF-8, so it can't be mistaken for a JSON message. */
+#define MESSAGE_DEFLATE_MARKER 0xC1
+
+/** Marker followed by the big-endian size of the compressed payload */
+#define MESSAGE_DEFLATE_HEADER_SIZE 5
+
+/**
+ * Per-message compression of a connection, in the form used by permessage-deflate (RFC 7692):
+ * raw deflate flushed at the end of every message, with the trailing 00 00 FF FF of the flush removed.
+ *
+ * With context takeover the deflate window carries over from one message to the next, so repeated keys and
+ * values of successive messages compress to back references. Both peers must then see every message, in order.
+ * Without it the streams are reset after every message.
+ */
+class WEBAPISERVER_API FMessageDeflate
+{
+public:
+
+    FMessageDeflate();
+
+    ~FMessageDeflate();
+
+    /** Drop both streams and start over, after a (re)negotiation */
+    void Reset(bool bInContextTakeover);
+
+    bool HasContextTakeover() const { return bContextTakeover; }
+
+    /** Append a complete compressed frame, header included, to OutFrame */
+    bool Compress(const uint8* Data, int32 Count, TArray<uint8>& OutFrame);
+
+    /**
+     * Feed received bytes that start with, or continue, a compressed frame. Returns the number of bytes consumed.
+     * The frame is buffered until complete, bOutComplete is then set and DecompressFrame must be called.
+     * Frames announcing more than MaxFrameSize bytes are refused and bOutOversized is set.
+     */
+    int32 FeedFrame(const uint8* Data, int32 Count, int32 MaxFrameSize, bool& bOutComplete, bool& bOutOversized);
+
+    /** Inflate the frame completed by FeedFrame. Fails if the message would grow past MaxSize. */
+    bool DecompressFrame(int32 MaxSize, TArray<uint8>& OutMessage);
+
+    /** True while a frame is partially received */
+    bool IsInFrame() const { return !FrameBuffer.IsEmpty(); }
+
+private:
+
+    struct FStreams;
+
+    TUniquePtr<FStreams> Streams;
+
+    bool bContextTakeover = false;
+
+    /** Header and payload of the frame being received */
+    TArray<uint8> FrameBuffer;
+};
@@ -27,4 +27,19 @@ public:
 	bool SendMessage(const FString& Message);
 	virtual bool SendMessage_Implementation(const FString& Message);
 
+	/** Smoothed round trip time of the connection and its variation, in seconds. False if the sender doesn't measure it. */
+	virtual bool GetRoundTripTime(float& OutSmoothedRtt, float& OutRttVariation) const { return false; }
+
+	/** Bytes accepted by SendMessage and not handed to the OS yet, used to pace streamed responses. INDEX_NONE if unknown. */
+	virtual int32 GetPendingSendBytes() const { return INDEX_NONE; }
+
+	/** False for senders that answer with a single message, streamed responses are then sent as one result */
+	virtual bool CanStreamResponses() const { return true; }
+
+	/** Raised once the connection of the sender is closed, so the state kept for it can be released. nullptr if the sender doesn't report it. */
+	virtual FSimpleMulticastDelegate* GetClosedDelegate() { return nullptr; }
+
+	/** Object the admission limits of the sender are counted on, nullptr for the sender itself. Lets senders living for a single exchange share the limits of their peer. */
+	virtual UObject* GetAdmissionOwner() const { return nullptr; }
+
 };
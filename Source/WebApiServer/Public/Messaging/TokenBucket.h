@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Token bucket rate limiter. Starts full; the rate and burst are passed on each call so they can be changed at any time. */
+struct FTokenBucket
+{
+    /**
+     * Take Cost tokens if at least one is available. Rate is in tokens per second, Burst is the capacity of the bucket.
+     * A cost larger than the tokens left puts the bucket in debt, the following calls fail until it's paid back.
+     */
+    bool TryConsume(double Now, double Rate, double Burst, double Cost = 1.0)
+    {
+        const double Capacity = FMath::Max(Burst, 1.0);
+        if (!bStarted)
+            Tokens = Capacity;
+        else
+            Tokens = FMath::Min(Capacity, Tokens + (Now - LastRefillTime) * Rate);
+        bStarted = true;
+        LastRefillTime = Now;
+
+        if (Tokens < 1.0)
+            return false;
+
+        Tokens -= Cost;
+        return true;
+    }
+
+private:
+    double Tokens = 0.0;
+    double LastRefillTime = 0.0;
+    bool bStarted = false;
+};
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Messaging/MessageSender.h"
+#include "Messaging/LengthPrefixedFraming.h"
+#include "TcpClientWrapper.generated.h"
+
+class FSocket;
+class UTcpServerWrapper;
+
+/**
+ * Raw TCP connection exchanging length-prefixed UTF-8 messages.
+ *
+ * Either accepted by a UTcpServerWrapper, which then pumps it from its own tick,
+ * or created with NewTcpConnection to reach a remote server, in which case it ticks itself.
+ */
+UCLASS(ClassGroup = (Networking), BlueprintType)
+class WEBAPISERVER_API UTcpClientWrapper : public UObject, public IMessageSender
+{
+    GENERATED_BODY()
+
+public:
+    virtual ~UTcpClientWrapper() override;
+
+    UFUNCTION(BlueprintCallable, Category = "TcpClient", meta = (DefaultToSelf = "Outer"))
+    static UTcpClientWrapper* NewTcpConnection(UObject* Outer, const FString& Host = "127.0.0.1", int32 Port = 8081);
+
+    UFUNCTION(BlueprintCallable, Category = "TcpClient")
+    bool Connect(const FString& Host, int32 Port);
+
+    UFUNCTION(BlueprintCallable, Category = "TcpClient")
+    void Disconnect();
+
+    UFUNCTION(BlueprintCallable, Category = "TcpClient")
+    bool IsConnected() const;
+
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStatusChanged, UTcpClientWrapper*, Client);
+
+    UPROPERTY(BlueprintAssignable, Category = "TcpClient")
+    FOnStatusChanged OnConnected;
+
+    UPROPERTY(BlueprintAssignable, Category = "TcpClient")
+    FOnStatusChanged OnDisconnected;
+
+    UPROPERTY(BlueprintAssignable, Category = "TcpClient")
+    FOnStatusChanged OnError;
+
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMessageRecieved, UTcpClientWrapper*, Client,
+                                             const FString&, Message);
+
+    UPROPERTY(BlueprintAssignable, Category = "Message")
+    FOnMessageRecieved OnMessageRecieved;
+
+    virtual bool SendMessage_Implementation(const FString& Message) override;
+
+    virtual int32 GetPendingSendBytes() const override { return Framing.GetPendingSendBytes(); }
+
+    virtual FSimpleMulticastDelegate* GetClosedDelegate() override { return &ClosedDelegate; }
+
+    /** Send the raw bytes as one frame */
+    UFUNCTION(BlueprintCallable, Category = "Message")
+    bool SendData(const TArray<uint8>& Data);
+
+    /** Largest frame accepted from the peer. Bigger frames close the connection. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TcpClient")
+    int32 MaxMessageSize = 16 * 1024 * 1024;
+
+private:
+    /** Raised along with OnDisconnected, see IMessageSender::GetClosedDelegate */
+    FSimpleMulticastDelegate ClosedDelegate;
+
+    void Initialize(UTcpServerWrapper* InServer, FSocket* InSocket);
+
+    /** Flush pending sends, read available bytes and dispatch complete frames. Returns false once the connection is closed. */
+    bool Pump();
+
+    bool FlushSendBuffer();
+    bool ReceiveAvailable();
+    void CloseSocket();
+    void HandleConnectionLost(bool bError);
+
+    UPROPERTY(BlueprintReadOnly, Category = "TcpClient|Server", meta = (AllowPrivateAccess = true))
+    TWeakObjectPtr<UTcpServerWrapper> Server = nullptr;
+
+    FSocket* Socket = nullptr;
+
+    FLengthPrefixedFraming Framing;
+
+    bool bConnected = false;
+
+    FTSTicker::FDelegateHandle TickHandle;
+
+    friend class UTcpServerWrapper;
+};
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+class FSocket;
+class FRunnableThread;
+
+typedef TQueue<FSocket*, EQueueMode::Mpsc> FTcpAcceptedSocketQueue;
+
+/**
+ * Accept thread of one listening socket of a UTcpServerWrapper, see UTcpServerWrapper::NumListeners.
+ * Accepted sockets are made non blocking and handed to the game thread through the queue, which creates their clients.
+ */
+class WEBAPISERVER_API FTcpListenerThread : public FRunnable
+{
+public:
+
+    /** Takes ownership of the listening socket */
+    FTcpListenerThread(FSocket* InListenSocket, FTcpAcceptedSocketQueue& InAcceptedSockets, int32 InIndex);
+
+    /** Stops and joins the thread, then destroys the listening socket */
+    virtual ~FTcpListenerThread() override;
+
+    virtual uint32 Run() override;
+
+    virtual void Stop() override;
+
+private:
+
+    FSocket* ListenSocket;
+
+    FTcpAcceptedSocketQueue& AcceptedSockets;
+
+    std::atomic<bool> bStopping { false };
+
+    FRunnableThread* Thread = nullptr;
+};
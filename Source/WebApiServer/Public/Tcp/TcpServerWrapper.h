@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Tcp/TcpListenerThread.h"
+#include "TcpServerWrapper.generated.h"
+
+class FSocket;
+class UTcpClientWrapper;
+
+/**
+ * Raw TCP server exchanging length-prefixed UTF-8 messages.
+ *
+ * Intended for backend-to-backend traffic where the WebSocket handshake, framing and masking are not needed.
+ * Accepted clients implement IMessageSender and can be fed to a UJsonMessageDispatcher the same way WebSocket clients are.
+ * Connections are accepted on listener threads, clients are created and serviced on the game thread.
+ */
+UCLASS(ClassGroup = (Networking), BlueprintType)
+class WEBAPISERVER_API UTcpServerWrapper : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    virtual ~UTcpServerWrapper() override;
+
+    UFUNCTION(BlueprintCallable, Category = "TcpServer",
+        meta = (DefaultToSelf = "Outer"))
+    static UTcpServerWrapper* NewTcpServer(UObject* Outer, int32 Port = 8081);
+
+    UFUNCTION(BlueprintCallable, Category = "TcpServer")
+    bool StartServer(int32 Port);
+
+    UFUNCTION(BlueprintCallable, Category = "TcpServer")
+    void StopServer();
+
+    UFUNCTION(BlueprintCallable, Category = "TcpServer")
+    bool IsRunning() const;
+
+    UFUNCTION(BlueprintCallable, Category = "TcpServer")
+    void Broadcast(const FString& Payload);
+
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnClientStatus, UTcpServerWrapper*, Server, UTcpClientWrapper*, Client);
+
+    UPROPERTY(BlueprintAssignable, Category = "TcpServer")
+    FOnClientStatus OnClientConnect;
+
+    UPROPERTY(BlueprintAssignable, Category = "TcpServer")
+    FOnClientStatus OnClientDisconnect;
+
+    const TSet<TObjectPtr<UTcpClientWrapper>>& GetClients() const { return TcpClients; }
+
+    /** Largest frame accepted from clients */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TcpServer")
+    int32 MaxMessageSize = 16 * 1024 * 1024;
+
+    /**
+     * Listening sockets bound to the port, read by StartServer. Each has its own accept queue and thread, and the kernel spreads
+     * incoming connections among them (SO_REUSEPORT), so a burst of connections isn't accepted one at a time. Only on Linux, other platforms use one.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TcpServer", meta = (ClampMin = 1))
+    int32 NumListeners = 1;
+
+    UFUNCTION(BlueprintCallable, Category = "TcpServer")
+    int32 GetNumListeners() const { return Listeners.Num(); }
+
+protected:
+    bool Tick(float DeltaTime);
+
+    /** Create the clients of the sockets accepted by the listener threads */
+    void AcceptPendingConnections();
+
+    UPROPERTY(BlueprintReadOnly, Category = "TcpServer", meta = (AllowPrivateAccess = true))
+    int32 TcpPort;
+
+private:
+    TArray<TUniquePtr<FTcpListenerThread>> Listeners;
+
+    FTcpAcceptedSocketQueue AcceptedSockets;
+
+    UPROPERTY(BlueprintReadOnly, Category = "TcpServer", meta = (AllowPrivateAccess = true))
+    TSet<TObjectPtr<UTcpClientWrapper>> TcpClients;
+
+    /** Delegate */
+    FTSTicker::FDelegateHandle TickHandle;
+};
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Messaging/MessageSender.h"
+#include "Messaging/LengthPrefixedFraming.h"
+#include "UnixSocketClientWrapper.generated.h"
+
+/** Unix domain sockets are only wired on the POSIX platforms. Elsewhere the wrappers fail to start. */
+#define WEBAPISERVER_WITH_UNIX_SOCKETS (PLATFORM_LINUX || PLATFORM_MAC)
+
+class UUnixSocketServerWrapper;
+
+/**
+ * Unix domain socket connection exchanging length-prefixed UTF-8 messages, using the same framing as UTcpClientWrapper.
+ *
+ * Meant for editor tools and sidecar processes running on the same host as the server.
+ * Either accepted by a UUnixSocketServerWrapper, which then pumps it, or created with NewUnixSocketConnection in which case it ticks itself.
+ */
+UCLASS(ClassGroup = (Networking), BlueprintType)
+class WEBAPISERVER_API UUnixSocketClientWrapper : public UObject, public IMessageSender
+{
+    GENERATED_BODY()
+
+public:
+    virtual ~UUnixSocketClientWrapper() override;
+
+    UFUNCTION(BlueprintCallable, Category = "UnixSocketClient", meta = (DefaultToSelf = "Outer"))
+    static UUnixSocketClientWrapper* NewUnixSocketConnection(UObject* Outer, const FString& SocketPath, bool bBatchedIO = false);
+
+    UFUNCTION(BlueprintCallable, Category = "UnixSocketClient")
+    bool Connect(const FString& SocketPath);
+
+    UFUNCTION(BlueprintCallable, Category = "UnixSocketClient")
+    void Disconnect();
+
+    UFUNCTION(BlueprintCallable, Category = "UnixSocketClient")
+    bool IsConnected() const;
+
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStatusChanged, UUnixSocketClientWrapper*, Client);
+
+    UPROPERTY(BlueprintAssignable, Category = "UnixSocketClient")
+    FOnStatusChanged OnConnected;
+
+    UPROPERTY(BlueprintAssignable, Category = "UnixSocketClient")
+    FOnStatusChanged OnDisconnected;
+
+    UPROPERTY(BlueprintAssignable, Category = "UnixSocketClient")
+    FOnStatusChanged OnError;
+
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMessageRecieved, UUnixSocketClientWrapper*, Client,
+                                             const FString&, Message);
+
+    UPROPERTY(BlueprintAssignable, Category = "Message")
+    FOnMessageRecieved OnMessageRecieved;
+
+    virtual bool SendMessage_Implementation(const FString& Message) override;
+
+    virtual int32 GetPendingSendBytes() const override { return Framing.GetPendingSendBytes(); }
+
+    virtual FSimpleMulticastDelegate* GetClosedDelegate() override { return &ClosedDelegate; }
+
+    /** Send the raw bytes as one frame */
+    UFUNCTION(BlueprintCallable, Category = "Message")
+    bool SendData(const TArray<uint8>& Data);
+
+    /**
+     * When set, outgoing frames are coalesced and written with a single send per tick,
+     * and incoming bytes are drained with large reads before dispatching every complete frame.
+     * When unset, each message is written as soon as it is sent.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UnixSocketClient")
+    bool bBatchedIO = false;
+
+    /** Largest frame accepted from the peer. Bigger frames close the connection. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UnixSocketClient")
+    int32 MaxMessageSize = 16 * 1024 * 1024;
+
+    /** Seconds a pending connect may take before it fails with OnError */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UnixSocketClient")
+    float ConnectTimeout = 5.0f;
+
+private:
+    /** Raised along with OnDisconnected, see IMessageSender::GetClosedDelegate */
+    FSimpleMulticastDelegate ClosedDelegate;
+
+    void Initialize(UUnixSocketServerWrapper* InServer, int32 InSocketFd);
+
+    /** Flush pending sends, read available bytes and dispatch complete frames. Returns false once the connection is closed. */
+    bool Pump(bool bReadable = true);
+
+    bool FlushSendBuffer();
+    bool ReceiveAvailable();
+    void CloseSocket();
+    void HandleConnectionLost(bool bError);
+
+    UPROPERTY(BlueprintReadOnly, Category = "UnixSocketClient|Server", meta = (AllowPrivateAccess = true))
+    TWeakObjectPtr<UUnixSocketServerWrapper> Server = nullptr;
+
+    int32 SocketFd = -1;
+
+    FLengthPrefixedFraming Framing;
+
+    bool bConnected = false;
+
+    double ConnectDeadline = 0.0;
+
+    FTSTicker::FDelegateHandle TickHandle;
+
+    friend class UUnixSocketServerWrapper;
+};
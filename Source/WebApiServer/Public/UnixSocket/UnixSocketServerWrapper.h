@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "UnixSocketServerWrapper.generated.h"
+
+class UUnixSocketClientWrapper;
+
+/**
+ * Unix domain socket server exchanging length-prefixed UTF-8 messages.
+ *
+ * Same-host tooling avoids the TCP stack and the WebSocket handshake entirely.
+ * Accepted clients implement IMessageSender and can be fed to a UJsonMessageDispatcher.
+ * Each tick polls the listener and every client with a single poll() call, so only readable connections are touched.
+ */
+UCLASS(ClassGroup = (Networking), BlueprintType)
+class WEBAPISERVER_API UUnixSocketServerWrapper : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    virtual ~UUnixSocketServerWrapper() override;
+
+    UFUNCTION(BlueprintCallable, Category = "UnixSocketServer",
+        meta = (DefaultToSelf = "Outer"))
+    static UUnixSocketServerWrapper* NewUnixSocketServer(UObject* Outer, const FString& SocketPath, bool bBatchedIO = false);
+
+    /**
+     * Listen on the given filesystem path.
+     * A stale socket file left at that path is replaced. Fails if the path is not a socket or another server still answers on it.
+     */
+    UFUNCTION(BlueprintCallable, Category = "UnixSocketServer")
+    bool StartServer(const FString& SocketPath);
+
+    UFUNCTION(BlueprintCallable, Category = "UnixSocketServer")
+    void StopServer();
+
+    UFUNCTION(BlueprintCallable, Category = "UnixSocketServer")
+    bool IsRunning() const;
+
+    UFUNCTION(BlueprintCallable, Category = "UnixSocketServer")
+    void Broadcast(const FString& Payload);
+
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnClientStatus, UUnixSocketServerWrapper*, Server, UUnixSocketClientWrapper*, Client);
+
+    UPROPERTY(BlueprintAssignable, Category = "UnixSocketServer")
+    FOnClientStatus OnClientConnect;
+
+    UPROPERTY(BlueprintAssignable, Category = "UnixSocketServer")
+    FOnClientStatus OnClientDisconnect;
+
+    const TSet<TObjectPtr<UUnixSocketClientWrapper>>& GetClients() const { return UnixSocketClients; }
+
+    /** Applied to accepted clients. See UUnixSocketClientWrapper::bBatchedIO */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UnixSocketServer")
+    bool bBatchedIO = false;
+
+    /** Largest frame accepted from clients */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UnixSocketServer")
+    int32 MaxMessageSize = 16 * 1024 * 1024;
+
+protected:
+    bool Tick(float DeltaTime);
+
+    void AcceptPendingConnections();
+
+    UPROPERTY(BlueprintReadOnly, Category = "UnixSocketServer", meta = (AllowPrivateAccess = true))
+    FString UnixSocketPath;
+
+private:
+    int32 ListenFd = -1;
+
+    /** Identity of the socket file created by bind, only that file is removed on stop */
+    uint64 BoundDevice = 0;
+    uint64 BoundInode = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "UnixSocketServer", meta = (AllowPrivateAccess = true))
+    TSet<TObjectPtr<UUnixSocketClientWrapper>> UnixSocketClients;
+
+    /** Delegate */
+    FTSTicker::FDelegateHandle TickHandle;
+};
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Messaging/MessageSender.h"
+#include "WebSocketClientPool.generated.h"
+
+class UWebSocketClientWrapper;
+
+/**
+ * Small set of outbound connections to the same endpoint used as a single message sender.
+ *
+ * Messages are spread round-robin over the connected members. While every member is reconnecting,
+ * messages are queued on the members and pipelined as soon as they are back.
+ * Messages received on any member are forwarded through OnMessageRecieved, so responses can be routed by a dispatcher regardless of the connection they came back on.
+ */
+UCLASS(ClassGroup = (Networking), BlueprintType)
+class WEBAPISERVER_API UWebSocketClientPool : public UObject, public IMessageSender
+{
+    GENERATED_BODY()
+
+public:
+
+    UFUNCTION(BlueprintCallable, Category = "WebSocketClientPool", meta = (DefaultToSelf = "Outer"))
+    static UWebSocketClientPool* NewWebSocketClientPool(UObject* Outer, const FString& Url, int32 PoolSize = 4);
+
+    /** Open PoolSize connections to the url. See UWebSocketClientWrapper::ConnectToUrl */
+    UFUNCTION(BlueprintCallable, Category = "WebSocketClientPool")
+    bool Connect(const FString& Url, int32 PoolSize);
+
+    UFUNCTION(BlueprintCallable, Category = "WebSocketClientPool")
+    void Disconnect();
+
+    UFUNCTION(BlueprintCallable, Category = "WebSocketClientPool")
+    int32 GetConnectedCount() const;
+
+    const TArray<TObjectPtr<UWebSocketClientWrapper>>& GetConnections() const { return Connections; }
+
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnPoolMessageRecieved, UWebSocketClientPool*, Pool,
+                                             const FString&, Message);
+
+    UPROPERTY(BlueprintAssignable, Category = "Message")
+    FOnPoolMessageRecieved OnMessageRecieved;
+
+    virtual bool SendMessage_Implementation(const FString& Message) override;
+
+    /** The slowest connected member, so timeouts derived from it hold whichever member carries the request */
+    virtual bool GetRoundTripTime(float& OutSmoothedRtt, float& OutRttVariation) const override;
+
+    /** Sum over the members that know it, INDEX_NONE if none does */
+    virtual int32 GetPendingSendBytes() const override;
+
+    /**
+     * Raised when any member loses its connection, and by Disconnect. The pool can't tell which member carried a request,
+     * so the requests pending on the pool are failed rather than left to their timeout.
+     */
+    virtual FSimpleMulticastDelegate* GetClosedDelegate() override { return &ClosedDelegate; }
+
+private:
+
+    UFUNCTION()
+    void HandleConnectionMessage(UWebSocketClientWrapper* Client, const FString& Message);
+
+    void HandleConnectionClosed();
+
+    FSimpleMulticastDelegate ClosedDelegate;
+
+    UPROPERTY()
+    TArray<TObjectPtr<UWebSocketClientWrapper>> Connections;
+
+    int32 NextConnection = 0;
+};
@@ -3,12 +3,27 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Ticker.h"
 #include "Messaging/MessageSender.h"
+#include "Json/JsonMessageFramer.h"
+#include "Messaging/MessageDeflate.h"
 #include "WebSocketClientWrapper.generated.h"
 
 class INetworkingWebSocket;
 class UWebSocketServerWrapper;
 
+UENUM(BlueprintType)
+enum class EWebSocketClientState : uint8
+{
+    Disconnected,
+    /** Waiting for the host name resolution */
+    Resolving,
+    Connecting,
+    Connected,
+    /** Connection lost, a new attempt is scheduled */
+    WaitingToReconnect,
+};
+
 UCLASS(ClassGroup = (Networking), BlueprintType)
 class WEBAPISERVER_API UWebSocketClientWrapper : public UObject, public IMessageSender
 {
@@ -17,16 +32,32 @@ class WEBAPISERVER_API UWebSocketClientWrapper : public UObject, public IMessage
 public:
     UWebSocketClientWrapper();
 
-    UFUNCTION(BlueprintCallable, Category = "WebSocketClient",
-    meta = (DefaultToSelf = "Outer", DeprecatedFunction, DeprecationMessage = "Not yet fully implemented."))
-    static UWebSocketClientWrapper* NewWebSocketConnection(UObject* Outer, const FString& Ip = "0.0.0.0", int32 Port = 8080);
+    virtual ~UWebSocketClientWrapper() override;
+
+    UFUNCTION(BlueprintCallable, Category = "WebSocketClient", meta = (DefaultToSelf = "Outer"))
+    static UWebSocketClientWrapper* NewWebSocketConnection(UObject* Outer, const FString& Ip = "127.0.0.1", int32 Port = 8080);
 
-    UFUNCTION(BlueprintCallable, Category = "WebSocket", meta = (DeprecatedFunction, DeprecationMessage = "Not yet fully implemented."))
+    /** Connect to a host name or an ip address (v4 or v6) */
+    UFUNCTION(BlueprintCallable, Category = "WebSocket")
     void Connect(const FString& Ip, int32 Port);
 
-    UFUNCTION(BlueprintCallable, Category = "WebSocket", meta = (DeprecatedFunction, DeprecationMessage = "Not yet fully implemented."))
+    /** Connect to an address of the form "ws://host:port/path", "host:port" or "[ipv6]:port" */
+    UFUNCTION(BlueprintCallable, Category = "WebSocket")
+    bool ConnectToUrl(const FString& Url);
+
+    /** Close an outbound connection and stop reconnecting. Messages still queued are dropped. */
+    UFUNCTION(BlueprintCallable, Category = "WebSocket")
     void Disconnect();
 
+    UFUNCTION(BlueprintCallable, Category = "WebSocket")
+    bool IsConnected() const { return State == EWebSocketClientState::Connected; }
+
+    UFUNCTION(BlueprintCallable, Category = "WebSocket")
+    EWebSocketClientState GetState() const { return State; }
+
+    /** Parse "ws://host:port/path", "host:port", "[ipv6]:port" or a bare host into its host and port */
+    static bool ParseEndpoint(const FString& Url, FString& OutHost, int32& OutPort);
+
     DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStatusChanged, UWebSocketClientWrapper*, client);
 
     UPROPERTY(BlueprintAssignable, Category = "WebSocket")
@@ -46,19 +77,184 @@ public:
 
     virtual bool SendMessage_Implementation(const FString &Message);
 
+    /** Send the data, or queue it while an outbound connection is being (re)established */
     UFUNCTION(BlueprintCallable, Category = "Message")
     bool SendData(const TArray<uint8> &Data);
 
+    /** Largest message accepted from the peer. Bigger messages are skipped without being buffered and OnError is raised. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Message")
+    int32 MaxMessageSize = 16 * 1024 * 1024;
+
+    /** Outbound connections only. Reconnect with exponential backoff when the connection drops or fails. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocket|Reconnect")
+    bool bAutoReconnect = true;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocket|Reconnect")
+    float InitialReconnectDelay = 0.5f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocket|Reconnect")
+    float MaxReconnectDelay = 30.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocket|Reconnect")
+    float ReconnectBackoffMultiplier = 2.0f;
+
+    /** Seconds before a connection attempt with no answer is considered failed */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocket|Reconnect")
+    float ConnectTimeout = 10.0f;
+
+    /** Messages kept while not connected. They are sent in order as soon as the connection is back. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocket|Reconnect")
+    int32 MaxQueuedMessages = 1024;
+
+    /**
+     * Send a {"method":"rpc.ping","params":N} heartbeat. The peer is expected to answer {"method":"rpc.pong","params":N},
+     * which clients of this plugin do on their own; the answer updates the round trip time. Heartbeats never reach OnMessageRecieved.
+     */
+    UFUNCTION(BlueprintCallable, Category = "WebSocket|Heartbeat")
+    bool SendPing();
+
+    /** Smoothed round trip time in seconds, 0 until a ping is answered */
+    UFUNCTION(BlueprintCallable, Category = "WebSocket|Heartbeat")
+    float GetSmoothedRtt() const { return SmoothedRtt; }
+
+    UFUNCTION(BlueprintCallable, Category = "WebSocket|Heartbeat")
+    float GetRttVariation() const { return RttVariation; }
+
+    /** Seconds since data was last received */
+    UFUNCTION(BlueprintCallable, Category = "WebSocket|Heartbeat")
+    float GetIdleTime() const;
+
+    virtual bool GetRoundTripTime(float& OutSmoothedRtt, float& OutRttVariation) const override;
+
+    /**
+     * Bytes queued while reconnecting. Unknown once connected, the networking module doesn't expose its own send buffer,
+     * streamed responses are then paced by the credits the requester grants.
+     */
+    virtual int32 GetPendingSendBytes() const override { return State == EWebSocketClientState::Connected ? INDEX_NONE : QueuedBytes; }
+
+    virtual FSimpleMulticastDelegate* GetClosedDelegate() override { return &ClosedDelegate; }
+
+    /**
+     * Offer per-message compression when connecting, or accept it when offered by the peer on the server side.
+     * Peers agree with a {"method":"rpc.compress","params":<context takeover>} exchange, peers that never send it
+     * only get uncompressed messages.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Message|Compression")
+    bool bCompressMessages = false;
+
+    /** Messages smaller than this many bytes are sent uncompressed */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Message|Compression", meta = (ClampMin = 0))
+    int32 CompressionThreshold = 1024;
+
+    /**
+     * Keep the compression window from one message to the next, so keys and values repeated across messages compress too.
+     * Costs a 32 KB window per direction for the lifetime of the connection. Used only if both peers ask for it.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Message|Compression")
+    bool bCompressionContextTakeover = true;
+
+    /** True once both peers agreed to compress */
+    UFUNCTION(BlueprintCallable, Category = "Message|Compression")
+    bool IsCompressionActive() const { return bCompressionActive; }
+
+    /** Size of the messages sent compressed, before compression */
+    UFUNCTION(BlueprintCallable, Category = "Message|Compression")
+    int64 GetCompressedInputBytes() const { return CompressedInputBytes; }
+
+    /** Size of the messages sent compressed, on the wire */
+    UFUNCTION(BlueprintCallable, Category = "Message|Compression")
+    int64 GetCompressedOutputBytes() const { return CompressedOutputBytes; }
+
 private:
+    /** Raised along with OnDisconnected, see IMessageSender::GetClosedDelegate */
+    FSimpleMulticastDelegate ClosedDelegate;
+
     void Initialize(UWebSocketServerWrapper *InServer, INetworkingWebSocket *InNetworkingWebSocket);
 
+    bool IsOutbound() const { return !bServerSide; }
+
+    void StartConnection();
+    void OnAddressResolved(TSharedPtr<FInternetAddr> Address);
+    void HandleConnectionFailure();
+    void ScheduleReconnect();
+    void ReleaseConnection();
+    void FlushQueuedMessages();
+    bool Tick(float DeltaTime);
+
+    /** Answer pings and measure pongs, true if the message was a heartbeat */
+    bool HandleHeartbeat(const FString& Message);
+
+    /** Agree on compression, true if the message was an rpc.compress offer or answer */
+    bool HandleCompressionOffer(const FString& Message);
+
+    /** Heartbeats and compression offers are handled here, other messages go to OnMessageRecieved */
+    void DispatchMessage(const FString& Message);
+
+    /** Returns the bytes consumed, or INDEX_NONE if the connection was dropped */
+    int32 ReceiveCompressed(const uint8* Bytes, int32 Count);
+
+    bool SendFrame(const TArray<uint8>& Frame);
+
+    bool SendControlMessage(const FString& Message);
+
+    /** Server side: stop servicing a connection the server gave up on. The socket stays open until the peer or the OS drops it. */
+    void Abandon();
+
     bool bInitialized = false;
 
+    bool bServerSide = false;
+
     UPROPERTY(BlueprintReadOnly, Category = "WebSocket|Server", meta = (AllowPrivateAccess = true))
     TWeakObjectPtr<UWebSocketServerWrapper> Server = nullptr;
 
     INetworkingWebSocket *NetworkingWebSocket = nullptr;
 
+    /** Outbound connections own their socket. Server side sockets are owned by the server. */
+    TSharedPtr<INetworkingWebSocket> OwnedWebSocket;
+
+    /** Connections dropped from within their own callbacks, destroyed on the next tick */
+    TArray<TSharedPtr<INetworkingWebSocket>> ReleasedWebSockets;
+
+    EWebSocketClientState State = EWebSocketClientState::Disconnected;
+
+    FString RemoteHost;
+    int32 RemotePort = 0;
+
+    /** Incremented on every attempt so late resolution callbacks of an abandoned attempt are ignored */
+    uint32 ConnectionAttempt = 0;
+
+    float CurrentReconnectDelay = 0.0f;
+    double StateDeadline = 0.0;
+
+    TArray<TArray<uint8>> QueuedMessages;
+    int32 QueuedBytes = 0;
+
+    /** Reassembles messages delivered over several receive callbacks */
+    FJsonMessageFramer Framer;
+
+    FMessageDeflate Deflate;
+
+    /** Outbound: rpc.compress sent and not answered yet */
+    bool bCompressionOffered = false;
+    bool bCompressionActive = false;
+
+    int64 CompressedInputBytes = 0;
+    int64 CompressedOutputBytes = 0;
+
+    double LastReceiveTime = 0.0;
+
+    /** Last ping sent, only the latest one is measured */
+    double PingSentTime = 0.0;
+    int32 PingSequence = 0;
+    bool bPingOutstanding = false;
+
+    /** RFC 6298 estimators */
+    float SmoothedRtt = 0.0f;
+    float RttVariation = 0.0f;
+    bool bHasRttSample = false;
+
+    FTSTicker::FDelegateHandle TickHandle;
+
     void OnClientConnected();
     void OnClientDisconnected();
     void OnClientError();
@@ -3,13 +3,31 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Messaging/ClientInterestGrid.h"
 #include "WebSocketServerWrapper.generated.h"
 
 class IWebSocketServer;
 class UWebSocketClientWrapper;
 
+/** How often the server polls its sockets */
+UENUM(BlueprintType)
+enum class EWebSocketServerTickPolicy : uint8
+{
+    /** Once per engine frame */
+    FrameLocked,
+    /** PollRate times per second, several times in a frame when the frame rate is lower */
+    FixedRate,
+    /** Slower while nothing is received or sent, down to IdlePollRate, and several times in a frame under load */
+    Adaptive,
+};
+
 /**
+ * WebSocket server on a single listener polled from the game thread.
  *
+ * WebSocketNetworking has no option for SO_REUSEPORT and raises its accept and receive callbacks from its Tick, where they
+ * reach UObjects, so its listener can't be moved to worker threads. Backends accepting many connections at once can use
+ * UTcpServerWrapper::NumListeners instead.
  */
 UCLASS(ClassGroup = (Networking), BlueprintType)
 class WEBAPISERVER_API UWebSocketServerWrapper : public UObject
@@ -35,6 +53,23 @@ public:
     UFUNCTION(BlueprintCallable, Category = "WebSocketServer")
     void Broadcast(const FString &Payload);
 
+    /** Send to the clients whose interest area contains the location, see SetClientInterest */
+    UFUNCTION(BlueprintCallable, Category = "WebSocketServer|Interest")
+    void BroadcastRelevant(const FString &Payload, const FVector& Location);
+
+    /** Send to the clients interested in the tag, see SetClientInterestTags */
+    UFUNCTION(BlueprintCallable, Category = "WebSocketServer|Interest")
+    void BroadcastToTag(const FString &Payload, FName Tag);
+
+    /** Area of the world the client is interested in. A radius <= 0 clears it. */
+    UFUNCTION(BlueprintCallable, Category = "WebSocketServer|Interest")
+    void SetClientInterest(UWebSocketClientWrapper* Client, const FVector& Center, float Radius);
+
+    UFUNCTION(BlueprintCallable, Category = "WebSocketServer|Interest")
+    void SetClientInterestTags(UWebSocketClientWrapper* Client, const TArray<FName>& Tags);
+
+    const FClientInterestGrid& GetInterestGrid() const { return InterestGrid; }
+
     DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnClientStatus, UWebSocketServerWrapper*, Server, UWebSocketClientWrapper*, Client);
 
     UPROPERTY(BlueprintAssignable, Category = "WebSocketServer")
@@ -45,18 +80,120 @@ public:
 
     const TSet<TObjectPtr<UWebSocketClientWrapper>>& GetClients() const { return WebSocketClients; }
 
+    /** Largest message accepted from a client, applied to clients as they connect */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer")
+    int32 MaxMessageSize = 16 * 1024 * 1024;
+
+    /** Clients connected at once, 0 for no limit. Connections over the limit are refused during the handshake and closed. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer")
+    int32 MaxClients = 0;
+
+    /** Connections refused because of MaxClients since the server started */
+    UFUNCTION(BlueprintCallable, Category = "WebSocketServer")
+    int32 GetRejectedConnectionCount() const { return RejectedConnectionCount; }
+
+    /** Accept the per-message compression offered by clients, see UWebSocketClientWrapper::bCompressMessages. Applied to clients as they connect. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Compression")
+    bool bCompressMessages = false;
+
+    /** Messages smaller than this many bytes are sent uncompressed */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Compression", meta = (ClampMin = 0))
+    int32 CompressionThreshold = 1024;
+
+    /** Keep the compression window across messages when the client asks for it too */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Compression")
+    bool bCompressionContextTakeover = true;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Tick")
+    EWebSocketServerTickPolicy TickPolicy = EWebSocketServerTickPolicy::FrameLocked;
+
+    /** Polls per second with the FixedRate policy */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Tick", meta = (ClampMin = 1))
+    float PollRate = 120.0f;
+
+    /** Slowest polling of the Adaptive policy, reached after a while without traffic. Bounds the latency of the first message. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Tick", meta = (ClampMin = 1))
+    float IdlePollRate = 10.0f;
+
+    /** Polls in one frame with the FixedRate and Adaptive policies */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Tick", meta = (ClampMin = 1))
+    int32 MaxPollsPerFrame = 4;
+
+    /** Polls per second, measured over the last second */
+    UFUNCTION(BlueprintCallable, Category = "WebSocketServer|Tick")
+    float GetPollRate() const { return MeasuredPollRate; }
+
+    /**
+     * Seconds between heartbeats sent to each client, 0 to disable. Answers update the round trip time of the clients,
+     * see UWebSocketClientWrapper::SendPing. Peers that don't answer rpc.ping must keep sending traffic to stay connected.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Heartbeat")
+    float HeartbeatInterval = 0.0f;
+
+    /** Seconds a client may leave a heartbeat unanswered, without sending anything else either, before it's reaped */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Heartbeat", meta = (EditCondition = "HeartbeatInterval > 0"))
+    float HeartbeatTimeout = 10.0f;
+
+    /** Seconds without receiving anything after which a client is reaped, 0 to disable */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSocketServer|Heartbeat")
+    float IdleTimeout = 0.0f;
+
+    /**
+     * Clients dropped by the heartbeat or idle timeouts, or for sending a corrupted compressed stream, since the server started. They leave GetClients,
+     * OnClientDisconnect is raised and nothing more is read from them. WebSocketNetworking can't close a server side socket, it is released when the
+     * peer or the OS drops the connection.
+     */
+    UFUNCTION(BlueprintCallable, Category = "WebSocketServer|Heartbeat")
+    int32 GetReapedClientCount() const { return ReapedClientCount; }
+
 protected:
     void OnWebSocketClientConnected(INetworkingWebSocket *ClientWebSocket);
 
+    /** False once MaxClients is reached, the handshake of the connection is then refused */
+    bool AdmitConnection();
+
+    void SendToClients(const FString &Payload, const TArray<UObject*>& Clients);
+
     UPROPERTY(BlueprintReadOnly, Category = "WebSocketServer", meta = (AllowPrivateAccess = true))
     int32 WebSocketPort;
 
 private:
+    bool TickServer(float DeltaTime);
+
+    bool TickHeartbeats(float DeltaTime);
+
+    void ReapClient(UWebSocketClientWrapper* Client);
+
+    FTSTicker::FDelegateHandle HeartbeatTickHandle;
+
+    int32 ReapedClientCount = 0;
+
+    /** Called when data is received or sent, or a client connects or leaves, so Adaptive polling speeds up */
+    void NotifyActivity() { ++ActivityCount; }
+
+    uint32 ActivityCount = 0;
+
+    int32 PollsInWindow = 0;
+    double PollWindowStart = 0.0;
+    float MeasuredPollRate = 0.0f;
+
     TUniquePtr<IWebSocketServer> ServerWebSocket;
 
+    FTSTicker::FDelegateHandle TickHandle;
+
+    /** FixedRate and Adaptive: time of the next poll */
+    double NextPollTime = 0.0;
+    /** Adaptive: current delay between polls, 0 while busy */
+    double IdleInterval = 0.0;
+    /** Adaptive: ActivityCount seen by the last poll */
+    uint32 LastActivityCount = 0;
+
     UPROPERTY(BlueprintReadOnly, Category = "WebSocketServer", meta = (AllowPrivateAccess = true))
     TSet<TObjectPtr<UWebSocketClientWrapper>> WebSocketClients;
 
-    /** Delegate */
-    FTSTicker::FDelegateHandle TickHandle;
+    FClientInterestGrid InterestGrid;
+
+    int32 RejectedConnectionCount = 0;
+
+    friend class UWebSocketClientWrapper;
 };
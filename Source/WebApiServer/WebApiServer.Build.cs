@@ -44,11 +44,15 @@ public class WebApiServer : ModuleRules
                 "WebSocketNetworking",
                 "Json",
                 "JsonUtilities",
+                "HTTPServer",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
 		
 		
+		// Per-message compression of the WebSocket transport
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
+		
 		DynamicallyLoadedModuleNames.AddRange(
 			new string[]
 			{